@@ -0,0 +1,59 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "DeviceResourceCache.h"
+#include "TileTelemetry.h"
+
+using namespace winrt;
+
+//
+//  FUNCTION: GetSolidColorBrush
+//
+//  PURPOSE: Returns the brush of the given color for the device of the context, and only creates it the first time.
+//
+ID2D1SolidColorBrush* DeviceResourceCache::GetSolidColorBrush(ID2D1DeviceContext* d2dDeviceContext, D2D1_COLOR_F const& color)
+{
+	com_ptr<ID2D1Device> device;
+	d2dDeviceContext->GetDevice(device.put());
+	if (device != m_device)
+	{
+		Reset();
+		m_device = device;
+	}
+
+	for (CachedBrush const& cached : m_solidColorBrushes)
+	{
+		if (cached.color.r == color.r && cached.color.g == color.g && cached.color.b == color.b && cached.color.a == color.a)
+		{
+			return cached.brush.get();
+		}
+	}
+
+	CachedBrush cached{ color };
+	check_hresult(d2dDeviceContext->CreateSolidColorBrush(color, cached.brush.put()));
+	TileTelemetry::Add(TileCounter::DeviceResourcesCreated);
+	m_solidColorBrushes.push_back(cached);
+	return m_solidColorBrushes.back().brush.get();
+}
+
+//
+//  FUNCTION: Reset
+//
+//  PURPOSE: Releases every resource, for when the device is lost. They are created again on the next device.
+//
+void DeviceResourceCache::Reset()
+{
+	m_solidColorBrushes.clear();
+	m_device = nullptr;
+}
@@ -13,6 +13,8 @@
 //*********************************************************
 #include "stdafx.h"
 #include "DirectXTileRenderer.h"
+#include "SurfaceFrame.h"
+#include "TileTelemetry.h"
 
 static const float sc_MaxZoom = 1.0f; // Restrict max zoom to 1:1 scale.
 static const unsigned int sc_MaxBytesPerPixel = 16; // Covers all supported image formats.
@@ -76,18 +78,22 @@ bool DirectXTileRenderer::DrawTile(Rect rect)
 			POINT offset{};
 			RECT constrainedUpdateRect = RECT{ x,  y,  min(x + constrainedUpdateSize.cx, updateRect.right), min(y + constrainedUpdateSize.cy, updateRect.bottom) };
 			com_ptr<ID2D1DeviceContext> d2dDeviceContext;
-			com_ptr<ID2D1SolidColorBrush> tileBrush;
 
 			// Begin our update of the surface pixels. Passing nullptr to this call will update the entire surface. We only update the rect area that needs to be rendered.
-			if (!CheckForDeviceRemoved(m_surfaceInterop->BeginDraw(&constrainedUpdateRect, __uuidof(ID2D1DeviceContext), (void**)d2dDeviceContext.put(), &offset)))
+			HRESULT beginDrawResult;
+			{
+				TileSpanScope span(TileSpan::BeginDraw);
+				beginDrawResult = m_surfaceInterop->BeginDraw(&constrainedUpdateRect, __uuidof(ID2D1DeviceContext), (void**)d2dDeviceContext.put(), &offset);
+			}
+			if (!CheckForDeviceRemoved(beginDrawResult))
 			{
 				return false;
 			}
 
 			d2dDeviceContext->Clear(D2D1::ColorF(D2D1::ColorF::Red, 0.f));
 
-			//Create a solid color brush for the tiles and which will be set to a different color before rendering.
-			check_hresult(d2dDeviceContext->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Green, 1.0f), tileBrush.put()));
+			//The brush for the tile borders, created once for the device.
+			ID2D1SolidColorBrush* tileBrush = m_deviceResources.GetSolidColorBrush(d2dDeviceContext.get(), D2D1::ColorF(D2D1::ColorF::Green, 1.0f));
 
 			// Set a transform to draw into this section of the virtual surface using the input coordate space
 			d2dDeviceContext->SetTransform(D2D1::Matrix3x2F::Translation((FLOAT)(offset.x - x), (FLOAT)(offset.y - y)));
@@ -98,7 +104,7 @@ bool DirectXTileRenderer::DrawTile(Rect rect)
 			d2dDeviceContext->DrawImage(m_finalOutput.get());
 			d2dDeviceContext->PopAxisAlignedClip();
 
-			d2dDeviceContext->DrawRectangle(d2dRect, tileBrush.get(), 3.0f);
+			d2dDeviceContext->DrawRectangle(d2dRect, tileBrush, 3.0f);
 
 			m_surfaceInterop->EndDraw();
 		}
@@ -124,7 +130,9 @@ bool DirectXTileRenderer::CheckForDeviceRemoved(HRESULT hr)
 	else if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
 	{
 		// We can't draw at this time, but this failure is recoverable. Just skip drawing for
-		// now. We will be asked to draw again once the Direct3D device is recreated
+		// now. We will be asked to draw again once the Direct3D device is recreated, and the
+		// brushes with it.
+		m_deviceResources.Reset();
 		return false;
 	}
 	// Any other error is unexpected and, therefore, fatal.
@@ -135,13 +143,12 @@ bool DirectXTileRenderer::CheckForDeviceRemoved(HRESULT hr)
 //
 //  FUNCTION:Trim
 //
-//  PURPOSE: Helper function that calls the trim on the virtualSurface
+//  PURPOSE: Helper function that calls the trim on the virtualSurface. Everything outside of keepRects is discarded in a
+//	single call.
 //
-void DirectXTileRenderer::Trim(Rect trimRect)
+void DirectXTileRenderer::Trim(std::vector<RectInt32> const& keepRects)
 {
-	RectInt32 trimRects[1];
-	trimRects[0] = RectInt32{ (int)trimRect.X, (int)trimRect.Y, (int)trimRect.Width, (int)trimRect.Height };
-	m_virtualSurface.Trim(trimRects);
+	m_virtualSurface.Trim(keepRects);
 }
 
 //
@@ -854,9 +861,9 @@ float DirectXTileRenderer::FitImageToWindow(Size panelSize)
 //
 Tile::Tile(int lrow, int lcolumn, int tileSize)
 {
-	int x = lcolumn * tileSize;
-	int y = lrow * tileSize;
+	int64_t x = SurfaceFrame::ToPixel(lcolumn, tileSize);
+	int64_t y = SurfaceFrame::ToPixel(lrow, tileSize);
 	row = lrow;
 	column = lcolumn;
-	rect = Rect((float)x, (float)y, tileSize, tileSize);
+	rect = Rect((float)x, (float)y, (float)tileSize, (float)tileSize);
 }
\ No newline at end of file
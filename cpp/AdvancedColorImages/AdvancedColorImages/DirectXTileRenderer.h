@@ -13,6 +13,8 @@
 //*********************************************************
 #pragma once
 
+#include "DeviceResourceCache.h"
+
 using namespace winrt;
 using namespace Windows::System;
 using namespace Windows::UI;
@@ -62,7 +64,7 @@ class DirectXTileRenderer
 {
 public:
 	void Initialize(Compositor const& compositor, int tileSize, int surfaceSize);
-	void Trim(Rect trimRect);
+	void Trim(std::vector<RectInt32> const& keepRects);
 	CompositionSurfaceBrush getSurfaceBrush();
 	bool DrawTile(Rect rect);
 	void SetRenderOptions(RenderEffectKind effect, float brightnessAdjustment, AdvancedColorInfo const& acInfo, Size windowSize);
@@ -101,6 +103,7 @@ private:
 	int                                     m_tileSize = 0;
 	int                                     m_surfaceSize = 0;
 	com_ptr<ABI::Windows::UI::Composition::ICompositionDrawingSurfaceInterop> m_surfaceInterop;
+	DeviceResourceCache                     m_deviceResources;//Brushes kept across BeginDraw sessions
 
 	// WIC and Direct2D resources.
 	com_ptr<ID3D11Device>					 m_d3dDevice;
@@ -14,10 +14,17 @@
 #include "stdafx.h"
 #include "TileDrawingManager.h"
 
+#include <chrono>
+
 
 TileDrawingManager::TileDrawingManager()
 {
-
+	m_scheduler.SetRenderer(this);
+	m_scheduler.SetFrameBudget(FRAMEBUDGET);
+	m_scheduler.SetCacheBudget((size_t)CACHEBUDGETMB * 1024 * 1024, TRIMMARGINTILECOUNT);
+	m_scheduler.SetTrimDeferral(TRIMDEFERRAL);
+	m_scheduler.SetTileOrder(TILEORDER);
+	m_scheduler.SetAdaptiveDrawAhead(MINDRAWAHEADTILECOUNT, ADAPTIVEDRAWAHEADTILECOUNT);
 }
 
 TileDrawingManager::~TileDrawingManager()
@@ -37,71 +44,70 @@ DirectXTileRenderer* TileDrawingManager::GetRenderer()
 //
 //  FUNCTION: UpdateVisibleRegion
 //
-//  PURPOSE: More unloaded surface is now visible on screen because of some event like manipulations(zoom, pan, etc.). This method, figures
-//	out the new areas that need to be rendered and fires the draw calls. This is the core of the tile drawing logic
+//  PURPOSE: More unloaded surface is now visible on screen because of some event like manipulations(zoom, pan, etc.). The TileScheduler
+//	figures out the new areas that need to be rendered and calls back into DrawTileRange and Trim.
 //
 void TileDrawingManager::UpdateVisibleRegion(float3 currentPosition)
 {
-	m_currentPosition = currentPosition;
-	bool stateUpdate = false;
-
-	int requiredTopTileRow = max((int)m_currentPosition.y / TILESIZE - DRAWAHEADTILECOUNT, 0);
-	int requiredBottomTileRow = (int)(m_currentPosition.y + m_viewPortSize.Height) / TILESIZE + DRAWAHEADTILECOUNT;
-	int requiredLeftTileColumn = max((int)m_currentPosition.x / TILESIZE - DRAWAHEADTILECOUNT, 0);
-	int requiredRightTileColumn = (int)(m_currentPosition.x + m_viewPortSize.Width) / TILESIZE + DRAWAHEADTILECOUNT;
-
-	m_currentTopLeftTileRow = (int)m_currentPosition.y / TILESIZE;
-	m_currentTopLeftTileColumn = (int)m_currentPosition.x / TILESIZE;
-
-	//Draws the tiles that are required above the drawn top row.
-	int numberOfRows = (m_drawnTopTileRow - requiredTopTileRow);
-	int numberOfColumns = (m_drawnRightTileColumn - m_drawnLeftTileColumn) + 1;
-	if (numberOfRows > 0 && numberOfColumns > 0)
-	{
-		DrawTileRange(m_drawnLeftTileColumn, requiredTopTileRow, numberOfColumns, numberOfRows);
-		stateUpdate = true;
-	}
+	double timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	m_scheduler.UpdateVisibleRegion(currentPosition.x, currentPosition.y, timeMs);
+}
 
-	//Draws the tiles that are required below the drawn bottom row.
-	numberOfRows = (requiredBottomTileRow - m_drawnBottomTileRow);
-	numberOfColumns = (m_drawnRightTileColumn - m_drawnLeftTileColumn) + 1;
-	if (numberOfRows > 0 && numberOfColumns > 0)
-	{
-		DrawTileRange(m_drawnLeftTileColumn, m_drawnBottomTileRow + 1, numberOfColumns, numberOfRows);
-		stateUpdate = true;
-	}
+//
+//  FUNCTION: SetInertiaTarget
+//
+//  PURPOSE: Lets the TileScheduler know where the current inertia will come to rest, so it does not draw ahead past it.
+//
+void TileDrawingManager::SetInertiaTarget(float3 restingPosition)
+{
+	m_scheduler.SetInertiaTarget(restingPosition.x, restingPosition.y);
+}
 
-	//Update the current drawn top tile row and current drawn bottom tile row.
-	m_drawnTopTileRow = min(requiredTopTileRow, m_drawnTopTileRow);
-	m_drawnBottomTileRow = max(requiredBottomTileRow, m_drawnBottomTileRow);
+//
+//  FUNCTION: ResetDrawAhead
+//
+//  PURPOSE: Called when the content stops moving, or a new manipulation starts, to drop the velocity seen so far.
+//
+void TileDrawingManager::ResetDrawAhead()
+{
+	m_scheduler.ResetDrawAhead();
+}
 
-	//Draws the tiles that are required to the left of the drawn columns.
-	numberOfRows = (m_drawnBottomTileRow - m_drawnTopTileRow) + 1;
-	numberOfColumns = (m_drawnLeftTileColumn - requiredLeftTileColumn);
-	if (numberOfRows > 0 && numberOfColumns > 0)
-	{
-		DrawTileRange(requiredLeftTileColumn, m_drawnTopTileRow, numberOfColumns, numberOfRows);
-		stateUpdate = true;
-	}
+//
+//  FUNCTION: FlushTrim
+//
+//  PURPOSE: Called when the content stops moving. A trim the tile cache was waiting on is done now, while nothing else is.
+//
+void TileDrawingManager::FlushTrim()
+{
+	m_scheduler.FlushTrim();
+}
 
-	//Draws the tiles that are required to the right of the drawn columns.
-	numberOfRows = (m_drawnBottomTileRow - m_drawnTopTileRow) + 1;
-	numberOfColumns = (requiredRightTileColumn - m_drawnRightTileColumn);
-	if (numberOfRows > 0 && numberOfColumns > 0)
-	{
-		DrawTileRange(m_drawnRightTileColumn + 1, m_drawnTopTileRow, numberOfColumns, numberOfRows);
-		stateUpdate = true;
-	}
+//
+//  FUNCTION: Invalidate
+//
+//  PURPOSE: Called when the image or the render options change. Every tile drawn so far shows the old content, so they
+//	are all trimmed and the visible ones queued again.
+//
+void TileDrawingManager::Invalidate()
+{
+	m_scheduler.Invalidate();
+}
 
-	//Update the current drawn left tile columns and current drawn right tile columns.
-	m_drawnLeftTileColumn = min(requiredLeftTileColumn, m_drawnLeftTileColumn);
-	m_drawnRightTileColumn = max(requiredRightTileColumn, m_drawnRightTileColumn);
+//
+//  FUNCTION: ProcessPendingTiles
+//
+//  PURPOSE: Draws the tiles queued by the previous updates, visible ones first, for at most FRAMEBUDGET milliseconds.
+//	Called once per frame. Returns true while there is work left.
+//
+bool TileDrawingManager::ProcessPendingTiles()
+{
+	return m_scheduler.ProcessPendingTiles();
+}
 
-	// Trimming the tiles that are not visible on screen
-	if (stateUpdate)
-	{
-		Trim(requiredLeftTileColumn, requiredTopTileRow, requiredRightTileColumn, requiredBottomTileRow);
-	}
+bool TileDrawingManager::HasPendingTiles() const
+{
+	return m_scheduler.HasPendingTiles();
 }
 
 //
@@ -111,41 +117,36 @@ void TileDrawingManager::UpdateVisibleRegion(float3 currentPosition)
 //
 void TileDrawingManager::UpdateViewportSize(Size newSize)
 {
-	m_viewPortSize = newSize;
-	//Using the ceil operator to make sure the Virtual Surfaces is loaded with tiles that occupy the entirity of the viewport
-	//not leaving any empty areas on it.
-	m_horizontalVisibleTileCount = (int)ceil(newSize.Width / TILESIZE);
-	m_verticalVisibleTileCount = (int)ceil(newSize.Height / TILESIZE);
-	DrawVisibleTilesByRange();
+	m_scheduler.UpdateViewportSize(newSize.Width, newSize.Height);
 }
 
 //
-//  FUNCTION: GetRectForTileRange
+//  FUNCTION: SetTileSize
 //
-//  PURPOSE: Gets the rect that needs to be updated for this range of tiles.
+//  PURPOSE: Switches to tiles of another size, any size works. Everything drawn so far is trimmed and drawn again at the
+//	new size by the next update.
 //
-Rect TileDrawingManager::GetRectForTileRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows)
+void TileDrawingManager::SetTileSize(int tileSize)
 {
-	int x = tileStartColumn * TILESIZE;
-	int y = tileStartRow * TILESIZE;
-	return Rect((float)x, (float)y, (float)(numColumns * TILESIZE), (float)(numRows * TILESIZE));
+	m_scheduler.SetTileSize(tileSize);
+}
+
+int TileDrawingManager::GetTileSize() const
+{
+	return m_scheduler.GetTileSize();
 }
 
 //
-//  FUNCTION: GetTilesForRange
+//  FUNCTION: GetRectForTileRange
 //
-//  PURPOSE: Converts the tile coordinates into a list of Tile Objects that can be sent to the renderer.
+//  PURPOSE: Gets the rect that needs to be updated for this range of tiles.
 //
-list<Tile> TileDrawingManager::GetTilesForRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows)
+Rect TileDrawingManager::GetRectForTileRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows)
 {
-	list<Tile> returnTiles;
-	//get Tile objects for each tile that needs to be rendered.
-	for (int i = tileStartColumn; i < tileStartColumn + numColumns; i++) {
-		for (int j = tileStartRow; j < tileStartRow + numRows; j++) {
-			returnTiles.push_back(Tile(j, i, TILESIZE));
-		}
-	}
-	return returnTiles;
+	int tileSize = m_scheduler.GetTileSize();
+	int64_t x = SurfaceFrame::ToPixel(tileStartColumn, tileSize);
+	int64_t y = SurfaceFrame::ToPixel(tileStartRow, tileSize);
+	return Rect((float)x, (float)y, (float)SurfaceFrame::ToPixel(numColumns, tileSize), (float)SurfaceFrame::ToPixel(numRows, tileSize));
 }
 
 
@@ -156,52 +157,36 @@ list<Tile> TileDrawingManager::GetTilesForRange(int tileStartColumn, int tileSta
 //
 Rect TileDrawingManager::GetClipRectForRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows)
 {
-	return Rect((float)tileStartColumn*TILESIZE, (float)tileStartRow*TILESIZE, (float)(numColumns * TILESIZE), (float)(numRows * TILESIZE));
-}
-
-void TileDrawingManager::DrawTileRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows)
-{
-	//m_currentRenderer->DrawTileRange(GetRectForTileRange(tileStartColumn, tileStartRow, numColumns, numRows), GetTilesForRange(tileStartColumn, tileStartRow, numColumns, numRows));
-	m_currentRenderer->DrawTile(GetRectForTileRange(tileStartColumn, tileStartRow, numColumns, numRows));
-
-	//m_currentRenderer->Draw(GetRectForTileRange(tileStartColumn, tileStartRow, numColumns, numRows), GetClipRectForRange(tileStartColumn, tileStartRow, numColumns, numRows));
+	int tileSize = m_scheduler.GetTileSize();
+	return Rect((float)SurfaceFrame::ToPixel(tileStartColumn, tileSize), (float)SurfaceFrame::ToPixel(tileStartRow, tileSize),
+		(float)SurfaceFrame::ToPixel(numColumns, tileSize), (float)SurfaceFrame::ToPixel(numRows, tileSize));
 }
 
-
 //
-//  FUNCTION: DrawVisibleTilesByRange
+//  FUNCTION: DrawTileRange
 //
-//  PURPOSE: This function combines all the tiles into a single call, so the rendering is faster as opposed to calling BeginDraw on each tile.
+//  PURPOSE: Called by the TileScheduler with a block of tiles that needs to be rendered.
 //
-void TileDrawingManager::DrawVisibleTilesByRange()
+bool TileDrawingManager::DrawTileRange(TileRange const& range)
 {
-	//The DRAWAHEADTILECOUNT draws tiles that the configured number of tiles outside the viewport to make sure the user doesnt see a lot 
-	//of empty areas when scrolling.
-	DrawTileRange(0, 0, m_horizontalVisibleTileCount + DRAWAHEADTILECOUNT, m_verticalVisibleTileCount + DRAWAHEADTILECOUNT);
-
-	//update the tiles that are already drawn, so only the new tiles will have to be rendered when panning.
-	m_drawnRightTileColumn = m_horizontalVisibleTileCount - 1 + DRAWAHEADTILECOUNT;
-	m_drawnBottomTileRow = m_verticalVisibleTileCount - 1 + DRAWAHEADTILECOUNT;
+	return m_currentRenderer->DrawTile(GetRectForTileRange(range.startColumn, range.startRow, range.numColumns, range.numRows));
 
+	//m_currentRenderer->Draw(GetRectForTileRange(tileStartColumn, tileStartRow, numColumns, numRows), GetClipRectForRange(tileStartColumn, tileStartRow, numColumns, numRows));
 }
 
 //
 //  FUNCTION: Trim()
 //
-//  PURPOSE: Trims the tiles that are outside these co-ordinates. So only the contents that are visible are rendered, to save on memory.
+//  PURPOSE: Called by the TileScheduler once its tile cache is over budget, with the tiles that are still cached. Everything
+//	else is trimmed from the surface in a single call, to save on memory.
 //
-void TileDrawingManager::Trim(int leftColumn, int topRow, int rightColumn, int bottomRow)
+void TileDrawingManager::Trim(std::vector<TileRange> const& keepRanges)
 {
-	auto trimRect = GetRectForTileRange(
-		leftColumn,
-		topRow,
-		rightColumn - leftColumn + 1,
-		bottomRow - topRow + 1);
-
-	m_currentRenderer->Trim(trimRect);
-
-	m_drawnLeftTileColumn = leftColumn;
-	m_drawnRightTileColumn = rightColumn;
-	m_drawnTopTileRow = topRow;
-	m_drawnBottomTileRow = bottomRow;
+	int tileSize = m_scheduler.GetTileSize();
+	m_trimRects.clear();
+	for (TileRange const& range : keepRanges)
+	{
+		m_trimRects.push_back(RectInt32{ range.startColumn * tileSize, range.startRow * tileSize, range.numColumns * tileSize, range.numRows * tileSize });
+	}
+	m_currentRenderer->Trim(m_trimRects);
 }
@@ -15,52 +15,56 @@
 #pragma once
 
 #include "DirectXTileRenderer.h"
+#include "TileScheduler.h"
 
 using namespace std;
 using namespace winrt;
 using namespace Windows::Foundation::Numerics;
 using namespace Windows::Foundation;
 
-class TileDrawingManager
+//The tile logic itself lives in the platform neutral TileScheduler. The TileDrawingManager adapts it to winrt types and
+//turns the tile ranges it schedules into DirectXTileRenderer calls.
+class TileDrawingManager : public ITileRenderer
 {
 public:
 	TileDrawingManager();
 	~TileDrawingManager();
 	void UpdateVisibleRegion(float3 currentPosition);
 	void UpdateViewportSize(Size newSize);
+	void SetInertiaTarget(float3 restingPosition);
+	void ResetDrawAhead();
+	void FlushTrim();
+	void Invalidate();
+	bool ProcessPendingTiles();
+	bool HasPendingTiles() const;
 	void SetRenderer(DirectXTileRenderer* renderer);
 	DirectXTileRenderer* GetRenderer();
+	void SetTileSize(int tileSize);
+	int GetTileSize() const;
 
-	const static int TILESIZE = 100;
+	//ITileRenderer implementation, called back by the TileScheduler.
+	bool DrawTileRange(TileRange const& range) override;
+	void Trim(std::vector<TileRange> const& keepRanges) override;
+
+	const static int TILESIZE = 100; //Tile size at startup. The cost of a tile depends on the image, so it is pinned instead of calibrated
 	const static int MAXSURFACESIZE = TILESIZE * 10000;
 	const static int DRAWAHEADTILECOUNT = 0; //Number of tiles to draw ahead 
+	const static int MAXDRAWAHEADTILECOUNT = 2; //Number of tiles to draw ahead on the leading edge of a fast pan
+	const static int MINDRAWAHEADTILECOUNT = 0; //Least the draw ahead at rest shrinks to when tiles take too long to draw for the frame budget
+	const static int ADAPTIVEDRAWAHEADTILECOUNT = 2; //Most the draw ahead at rest grows to when tiles are cheap to draw, 0 keeps it at DRAWAHEADTILECOUNT
+	const static int FRAMEBUDGET = 8; //Milliseconds per frame spent drawing tiles, 0 draws them all synchronously
+	const static int CACHEBUDGETMB = 32; //Megabytes of tiles kept on the surface after they leave the draw ahead band
+	const static int TRIMMARGINTILECOUNT = 2; //Number of tiles around the draw ahead band that are never trimmed
+	const static int TRIMDEFERRAL = 8; //Updates a trim may wait for a frame with time to spare once the tile cache is over budget, 0 trims within the update
+	const static TileOrder TILEORDER = TileOrder::CenterOut; //Order the blocks of a range are drawn in, CenterOut fills the middle of the viewport first
 
 private:
 
-	list<Tile> GetTilesForRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows);
-	void DrawVisibleTilesByRange();
 	Rect GetRectForTileRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows);
 	Rect GetClipRectForRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows);
-	void Trim(int leftColumn, int topRow, int rightColumn, int bottomRow);
-	void DrawTileRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows);
 
 	//member variables
-
-	//These variables reflect the current state of the surface and which tiles are screen.
-	//Helps us figure out the new set of tiles that need to be rendered when there's change because of manipulation
-	//or viewport size changes.
-	int                     m_drawnTopTileRow = 0;//Keeps track of the top tile row that is currently drawn
-	int                     m_drawnBottomTileRow = 0;//Keeps track of the bottom tile row that is currently drawn
-	int                     m_drawnLeftTileColumn = 0;//Keeps track of the left tile colum that is currently drawn
-	int                     m_drawnRightTileColumn = 0;//Keeps track of the right rile column that is currently drawn
-
-	int                     m_horizontalVisibleTileCount = 0;//Number of horizonal tiles visible.
-	int                     m_verticalVisibleTileCount = 0;//Number of vertical tiles visible.
-
-	Size                    m_viewPortSize;//Size of the viewport.
-	float3                  m_currentPosition;//Current position
-	int                     m_currentTopLeftTileRow = 0;//Row number of the top left tile that is currently visible
-	int                     m_currentTopLeftTileColumn = 0;//Column number of the top left tile that is currently visible.
-
+	TileScheduler           m_scheduler{ TILESIZE, DRAWAHEADTILECOUNT, MAXDRAWAHEADTILECOUNT };
 	DirectXTileRenderer* m_currentRenderer;
+	std::vector<RectInt32>  m_trimRects;//Scratch space for Trim
 };
@@ -54,6 +54,16 @@ void WinComp::Initialize(HWND hwnd)
 	m_compositor = compositor;
 	m_dxRenderer = new DirectXTileRenderer();
 	m_dxRenderer->Initialize(m_compositor, TileDrawingManager::TILESIZE, TileDrawingManager::MAXSURFACESIZE);
+	//Tiles are drawn a frame budget at a time from this timer, instead of all at once inside the tracker callbacks.
+	m_tileTimer = DispatcherQueue::GetForCurrentThread().CreateTimer();
+	m_tileTimer.Interval(std::chrono::milliseconds(16));
+	m_tileTimer.Tick([this](DispatcherQueueTimer const& timer, IInspectable const&)
+	{
+		if (!m_TileDrawingManager.ProcessPendingTiles())
+		{
+			timer.Stop();
+		}
+	});
 	m_TileDrawingManager.SetRenderer(m_dxRenderer);
 
 }
@@ -129,6 +139,7 @@ void WinComp::UpdateViewPort(boolean changeContentVisual)
 		}
 		m_TileDrawingManager.UpdateViewportSize(windowSize);
 		m_TileDrawingManager.UpdateVisibleRegion(m_lastTrackerPosition / m_lastTrackerScale);
+		ScheduleTileWork();
 	}
 }
 
@@ -209,21 +220,29 @@ void WinComp::CustomAnimationStateEntered(InteractionTracker sender, Interaction
 
 void WinComp::IdleStateEntered(InteractionTracker sender, InteractionTrackerIdleStateEnteredArgs args)
 {
+	//the content has stopped moving, go back to drawing the same number of tiles ahead on every side.
+	m_TileDrawingManager.ResetDrawAhead();
 	if (m_zooming)
 	{
 		//dont update the content visual, because the window size hasnt changed.
 		UpdateViewPort(false);
 	}
 	m_zooming = false;
+	//a trim that was put off while the content was moving costs nothing now.
+	m_TileDrawingManager.FlushTrim();
 }
 
 void WinComp::InertiaStateEntered(InteractionTracker sender, InteractionTrackerInertiaStateEnteredArgs args)
 {
+	//the tracker already knows where the inertia will end, so the tiles drawn ahead never go past that point.
+	float3 restingPosition = args.ModifiedRestingPosition() != nullptr ? args.ModifiedRestingPosition().Value() : args.NaturalRestingPosition();
+	m_TileDrawingManager.SetInertiaTarget(restingPosition / m_lastTrackerScale);
 }
 
 void WinComp::InteractingStateEntered(InteractionTracker sender, InteractionTrackerInteractingStateEnteredArgs args)
 {
-
+	//a new manipulation does not continue the previous motion.
+	m_TileDrawingManager.ResetDrawAhead();
 }
 
 void WinComp::RequestIgnored(InteractionTracker sender, InteractionTrackerRequestIgnoredArgs args)
@@ -244,6 +263,21 @@ void WinComp::ValuesChanged(InteractionTracker sender, InteractionTrackerValuesC
 
 	m_lastTrackerScale = args.Scale();
 	m_lastTrackerPosition = sender.Position();
+	ScheduleTileWork();
+}
+
+//
+//  FUNCTION: ScheduleTileWork
+//
+//  PURPOSE: Starts the tile timer when the last update queued tiles. The timer stops itself once the queue is empty, so
+//	nothing runs while the content is at rest.
+//
+void WinComp::ScheduleTileWork()
+{
+	if (m_TileDrawingManager.HasPendingTiles() && !m_tileTimer.IsRunning())
+	{
+		m_tileTimer.Start();
+	}
 }
 // Based on image and display parameters, choose the best rendering options.
 void WinComp::UpdateDefaultRenderOptions()
@@ -267,7 +301,20 @@ void WinComp::UpdateRenderOptions()
 		m_dispInfo,
 		GetWindowSize()
 	);
+	//the tiles on the surface were drawn with the previous options.
+	InvalidateTiles();
+}
 
+//
+//  FUNCTION: InvalidateTiles
+//
+//  PURPOSE: Drops every tile drawn so far and queues the visible ones again, for when the image or the way it is
+//	rendered changes. The cache would otherwise keep showing the old tiles until they are evicted.
+//
+void WinComp::InvalidateTiles()
+{
+	m_TileDrawingManager.Invalidate();
+	ScheduleTileWork();
 }
 IAsyncAction WinComp::LoadDefaultImage()
 {
@@ -314,6 +361,7 @@ void WinComp::LoadImageFromFileName(LPCWSTR szFileName)
 	m_dxRenderer->FitImageToWindow(GetWindowSize());
 	// Image loading is done at this point.
 	m_isImageValid = true;
+	InvalidateTiles();
 	UpdateDefaultRenderOptions();
 }
 
@@ -328,6 +376,7 @@ IAsyncOperation<int> WinComp::LoadImageFromFile(StorageFile  imageFile)
 
 	// Image loading is done at this point.
 	m_isImageValid = true;
+	InvalidateTiles();
 	UpdateDefaultRenderOptions();
 
 	co_return 1;
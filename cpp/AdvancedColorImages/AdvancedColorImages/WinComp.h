@@ -67,6 +67,8 @@ public:
 private:
 
 	void AddD2DVisual(VisualCollection const& visuals, float x, float y);
+	void ScheduleTileWork();
+	void InvalidateTiles();
 	void StartAnimation(CompositionSurfaceBrush brush);
 	Size GetWindowSize();
 
@@ -88,6 +90,7 @@ private:
 	CompositionPropertySet      m_animatingPropset{ nullptr };
 
 	TileDrawingManager          m_TileDrawingManager;
+	DispatcherQueueTimer        m_tileTimer{ nullptr };//Draws the queued tiles, one frame budget per tick
 	float                       m_lastTrackerScale = 1.0f;
 	float3                      m_lastTrackerPosition{ 0.0f,0.0f,0.0f };
 	bool                        m_zooming;
@@ -0,0 +1,151 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "CompressedTileStore.h"
+
+#include <algorithm>
+
+size_t CompressedTileStore::KeyHash::operator()(Key const& key) const
+{
+	uint64_t hash = ((uint64_t)(uint32_t)key.column << 32 | (uint32_t)key.row) ^ ((uint64_t)key.level << 59);
+	hash *= 0x9E3779B97F4A7C15ull;
+	return (size_t)(hash ^ (hash >> 32));
+}
+
+//
+//  FUNCTION: SetBudget
+//
+//  PURPOSE: Sets the most compressed bytes the store holds. 0 turns the store off and empties it.
+//
+void CompressedTileStore::SetBudget(size_t budgetBytes)
+{
+	m_budgetBytes = budgetBytes;
+	Evict();
+}
+
+size_t CompressedTileStore::GetBudget() const
+{
+	return m_budgetBytes;
+}
+
+void CompressedTileStore::SetTileSize(int tileSize)
+{
+	if (tileSize != m_tileSize)
+	{
+		Clear();
+		m_tileSize = tileSize;
+	}
+}
+
+//
+//  FUNCTION: Clear
+//
+//  PURPOSE: Drops every tile, for when the content changes.
+//
+void CompressedTileStore::Clear()
+{
+	m_entries.clear();
+	m_stats.storedBytes = 0;
+}
+
+//
+//  FUNCTION: Find
+//
+//  PURPOSE: Returns the compressed pixels of a tile, or nullptr when the store does not have it. The data stays valid
+//	until the next Insert, SetTileSize or Clear.
+//
+std::vector<uint8_t> const* CompressedTileStore::Find(TileCoordinate tile, int level)
+{
+	if (m_budgetBytes == 0)
+	{
+		return nullptr;
+	}
+	auto found = m_entries.find(Key{ tile.column, tile.row, level });
+	if (found == m_entries.end())
+	{
+		return nullptr;
+	}
+	found->second.lastUse = ++m_clock;
+	return &found->second.data;
+}
+
+//
+//  FUNCTION: Insert
+//
+//  PURPOSE: Stores the compressed pixels of a tile, replacing what the store had for it, then evicts if the store went
+//	over its budget.
+//
+void CompressedTileStore::Insert(TileCoordinate tile, int level, uint8_t const* data, size_t size)
+{
+	if (m_budgetBytes == 0 || size > m_budgetBytes)
+	{
+		return;
+	}
+	Entry& entry = m_entries[Key{ tile.column, tile.row, level }];
+	m_stats.storedBytes -= entry.data.size();
+	entry.data.assign(data, data + size);
+	entry.lastUse = ++m_clock;
+	m_stats.storedBytes += entry.data.size();
+
+	m_stats.stores++;
+	m_stats.rawBytes += (uint64_t)m_tileSize * m_tileSize * sizeof(uint32_t);
+	m_stats.compressedBytes += size;
+	m_stats.peakStoredBytes = std::max(m_stats.peakStoredBytes, m_stats.storedBytes);
+	if (m_stats.storedBytes > m_budgetBytes)
+	{
+		Evict();
+	}
+}
+
+void CompressedTileStore::RecordRestores(int tileCount)
+{
+	m_stats.restores += tileCount;
+}
+
+TileStoreStats CompressedTileStore::GetStats() const
+{
+	return m_stats;
+}
+
+//
+//  FUNCTION: Evict
+//
+//  PURPOSE: Drops the least recently used tiles until the store is EVICTIONPERCENT under its budget.
+//
+void CompressedTileStore::Evict()
+{
+	if (m_stats.storedBytes <= m_budgetBytes)
+	{
+		return;
+	}
+
+	m_candidates.clear();
+	for (auto const& entry : m_entries)
+	{
+		m_candidates.emplace_back(entry.second.lastUse, entry.first);
+	}
+	std::sort(m_candidates.begin(), m_candidates.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+
+	size_t watermark = m_budgetBytes - m_budgetBytes / 100 * EVICTIONPERCENT;
+	for (auto const& candidate : m_candidates)
+	{
+		if (m_stats.storedBytes <= watermark)
+		{
+			break;
+		}
+		auto found = m_entries.find(candidate.second);
+		m_stats.storedBytes -= found->second.data.size();
+		m_entries.erase(found);
+		m_stats.evictions++;
+	}
+}
@@ -0,0 +1,106 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileRange.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+//
+//  STRUCT: TileStoreStats
+//
+//  PURPOSE: What the compressed tile store holds, how well it compresses and how many draws it saved. The time spent
+//	restoring and compressing each tile is in the RestoreTile and CompressTile telemetry spans.
+//
+struct TileStoreStats
+{
+	uint64_t stores = 0;//Tiles compressed into the store
+	uint64_t restores = 0;//Tiles decompressed instead of rasterized
+	uint64_t evictions = 0;//Tiles dropped to stay within the budget
+	uint64_t rawBytes = 0;//Uncompressed size of every tile stored
+	uint64_t compressedBytes = 0;//Compressed size of every tile stored
+	size_t   storedBytes = 0;//Compressed bytes held right now
+	size_t   peakStoredBytes = 0;//Highest value storedBytes has reached
+
+	double CompressionRatio() const
+	{
+		return compressedBytes == 0 ? 0.0 : (double)rawBytes / (double)compressedBytes;
+	}
+};
+
+//
+//  CLASS: CompressedTileStore
+//
+//  PURPOSE: Second level of the tile cache, for content that costs far more to rasterize than to decompress. The
+//	ParallelTileRenderer compresses every tile it rasterizes into the store with the TileCodec, and restores the tiles it
+//	finds there instead of rasterizing them again, so a tile that was trimmed off the surface comes back at the cost of
+//	a decode and an upload. The pixels are taken while they are in CPU memory anyway, since reading them back from the
+//	surface when the residency cache evicts the tile would cost more than drawing it.
+//	The store is bounded by a byte budget of compressed data and evicts the least recently used tiles down to a lower
+//	watermark when it goes over. Tiles are only valid for the tile size and content they were drawn with, SetTileSize
+//	and Clear drop them. It is only used from the thread drawing the ranges.
+//
+class CompressedTileStore
+{
+public:
+	void SetBudget(size_t budgetBytes);
+	size_t GetBudget() const;
+	void SetTileSize(int tileSize);
+	void Clear();
+
+	std::vector<uint8_t> const* Find(TileCoordinate tile, int level);
+	void Insert(TileCoordinate tile, int level, uint8_t const* data, size_t size);
+	void RecordRestores(int tileCount);
+	TileStoreStats GetStats() const;
+
+	//Fraction of the budget that is evicted at once when the store goes over it, as in the TileResidencyCache.
+	const static int EVICTIONPERCENT = 25;
+
+private:
+	struct Key
+	{
+		int column;
+		int row;
+		int level;
+
+		bool operator==(Key const& other) const
+		{
+			return column == other.column && row == other.row && level == other.level;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(Key const& key) const;
+	};
+
+	struct Entry
+	{
+		std::vector<uint8_t>    data;
+		uint64_t                lastUse = 0;
+	};
+
+	void Evict();
+
+	//member variables
+	std::unordered_map<Key, Entry, KeyHash> m_entries;
+	size_t                  m_budgetBytes = 0;//0 turns the store off
+	int                     m_tileSize = 0;
+	uint64_t                m_clock = 0;//Counts lookups and inserts, orders the entries by last use
+	std::vector<std::pair<uint64_t, Key>> m_candidates;//Scratch space for Evict
+	TileStoreStats          m_stats;
+};
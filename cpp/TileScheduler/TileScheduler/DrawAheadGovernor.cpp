@@ -0,0 +1,151 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "DrawAheadGovernor.h"
+
+#include <algorithm>
+
+//Weight of a new sample in the smoothed cost and slack.
+static const double SMOOTHING = 0.125;
+
+DrawAheadGovernor::DrawAheadGovernor(int tileCount) :
+	m_fixedTileCount(std::max(tileCount, 0)),
+	m_tileCount(std::max(tileCount, 0))
+{
+}
+
+//
+//  FUNCTION: SetLimits
+//
+//  PURPOSE: Turns the governor on, with the draw ahead kept between the two counts. It starts from the current count.
+//	A maximum of 0 turns it off again and goes back to the count it was created with.
+//
+void DrawAheadGovernor::SetLimits(int minTileCount, int maxTileCount)
+{
+	m_minTileCount = std::max(minTileCount, 0);
+	m_maxTileCount = maxTileCount > 0 ? std::max(maxTileCount, m_minTileCount) : 0;
+	m_tileCount = IsEnabled() ? std::min(std::max(m_tileCount, m_minTileCount), m_maxTileCount) : m_fixedTileCount;
+	m_calmFrames = 0;
+	m_pressureFrames = 0;
+	m_settleFrames = 0;
+}
+
+bool DrawAheadGovernor::IsEnabled() const
+{
+	return m_maxTileCount > 0;
+}
+
+int DrawAheadGovernor::GetTileCount() const
+{
+	return m_tileCount;
+}
+
+//
+//  FUNCTION: AddDrawSample
+//
+//  PURPOSE: Feeds the time the renderer took to draw a range of tiles. The cost per tile is smoothed over the last
+//	draws, the first one is taken as it is.
+//
+void DrawAheadGovernor::AddDrawSample(int tileCount, double elapsedMs)
+{
+	if (tileCount <= 0 || !(elapsedMs >= 0.0))
+	{
+		return;
+	}
+	double tileCostMs = elapsedMs / tileCount;
+	m_stats.tileCostMs = m_hasCost ? m_stats.tileCostMs + SMOOTHING * (tileCostMs - m_stats.tileCostMs) : tileCostMs;
+	m_hasCost = true;
+}
+
+//
+//  FUNCTION: EndFrame
+//
+//  PURPOSE: Called once per frame that drew tiles, with the time the frame spent drawing, whether work is left for the
+//	next one, the number of tiles in the next ring around the viewports and the most draw ahead the cache budget has
+//	room for, -1 when memory is not a bound. Returns the draw ahead to use from now on.
+//
+int DrawAheadGovernor::EndFrame(double elapsedMs, double frameBudgetMs, bool workLeft, int ringTileCount, int memoryTileCount)
+{
+	double frameMs = frameBudgetMs > 0.0 ? frameBudgetMs : (double)DEFAULTFRAMETIME;
+	bool pressure = workLeft || elapsedMs > frameMs;
+	double slackMs = pressure ? 0.0 : frameMs - elapsedMs;
+	m_stats.slackMs = m_stats.frames == 0 ? slackMs : m_stats.slackMs + SMOOTHING * (slackMs - m_stats.slackMs);
+	m_stats.frames++;
+	m_stats.memoryTileCount = memoryTileCount;
+	if (!IsEnabled())
+	{
+		return m_tileCount;
+	}
+
+	m_calmFrames = pressure ? 0 : m_calmFrames + 1;
+	if (m_settleFrames > 0)
+	{
+		m_settleFrames--;
+		m_pressureFrames = 0;
+	}
+	else
+	{
+		m_pressureFrames = pressure ? m_pressureFrames + 1 : 0;
+	}
+
+	int upperTileCount = memoryTileCount < 0 ? m_maxTileCount : std::max(std::min(m_maxTileCount, memoryTileCount), m_minTileCount);
+	if (m_tileCount > upperTileCount)
+	{
+		//The budget went down or the viewport grew, no waiting for the slack to tell.
+		m_tileCount = upperTileCount;
+		m_stats.shrinks++;
+		m_calmFrames = 0;
+		m_pressureFrames = 0;
+	}
+	else if (m_pressureFrames >= SHRINKFRAMES && m_tileCount > m_minTileCount)
+	{
+		m_tileCount--;
+		m_stats.shrinks++;
+		m_pressureFrames = 0;
+	}
+	else if (m_calmFrames >= GROWFRAMES && m_tileCount < upperTileCount && m_hasCost &&
+		ringTileCount * m_stats.tileCostMs <= m_stats.slackMs * RINGFRAMES)
+	{
+		m_tileCount++;
+		m_stats.grows++;
+		m_calmFrames = 0;
+		m_settleFrames = RINGFRAMES;
+	}
+	return m_tileCount;
+}
+
+//
+//  FUNCTION: Reset
+//
+//  PURPOSE: Forgets the measurements, for example when the tile size changes and the cost per tile with it. The draw
+//	ahead stays where it is.
+//
+void DrawAheadGovernor::Reset()
+{
+	m_hasCost = false;
+	m_calmFrames = 0;
+	m_pressureFrames = 0;
+	m_settleFrames = 0;
+	m_stats.tileCostMs = 0.0;
+	m_stats.slackMs = 0.0;
+	m_stats.frames = 0;
+}
+
+DrawAheadStats DrawAheadGovernor::GetStats() const
+{
+	DrawAheadStats stats = m_stats;
+	stats.tileCount = m_tileCount;
+	stats.minTileCount = IsEnabled() ? m_minTileCount : 0;
+	stats.maxTileCount = m_maxTileCount;
+	return stats;
+}
@@ -0,0 +1,80 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+
+//
+//  STRUCT: DrawAheadStats
+//
+//  PURPOSE: What the DrawAheadGovernor has measured and where it has put the draw ahead, for instrumentation.
+//
+struct DrawAheadStats
+{
+	int      tileCount = 0;//Draw ahead on every edge when the content is at rest
+	int      minTileCount = 0;//Limits set with SetLimits, both 0 when the governor is off
+	int      maxTileCount = 0;
+	int      memoryTileCount = 0;//Most draw ahead the cache budget had room for at the last frame, -1 without a budget
+	double   tileCostMs = 0.0;//Smoothed time to draw one tile
+	double   slackMs = 0.0;//Smoothed time left in a frame once the queued tiles were drawn
+	uint64_t frames = 0;//Frames measured
+	uint64_t grows = 0;//Times the draw ahead went up by a ring of tiles
+	uint64_t shrinks = 0;//Times it went down
+};
+
+//
+//  CLASS: DrawAheadGovernor
+//
+//  PURPOSE: Sizes the draw ahead from what tiles actually cost to draw. Whether one more ring of tiles around the viewport
+//	is affordable depends on the renderer: solid fills are cheap, color managed image tiles are not. The governor keeps a
+//	smoothed cost per tile and a smoothed slack per frame, the part of the frame budget left once the queue was drained.
+//	After GROWFRAMES frames in a row that drained the queue, the draw ahead grows by one ring if that ring could be drawn
+//	in the slack of RINGFRAMES frames and the cache budget has room for it. After SHRINKFRAMES frames in a row that left
+//	work for the next one, it shrinks by one ring. It never leaves the limits, and never goes over the memory bound
+//	unless the minimum does. It only does arithmetic, the scheduler feeds it the measurements and applies the result.
+//
+class DrawAheadGovernor
+{
+public:
+	explicit DrawAheadGovernor(int tileCount);
+	void SetLimits(int minTileCount, int maxTileCount);
+	bool IsEnabled() const;
+	int GetTileCount() const;
+	void AddDrawSample(int tileCount, double elapsedMs);
+	int EndFrame(double elapsedMs, double frameBudgetMs, bool workLeft, int ringTileCount, int memoryTileCount);
+	void Reset();
+	DrawAheadStats GetStats() const;
+
+	//Frames in a row that have to drain the queue before the draw ahead grows.
+	const static int GROWFRAMES = 30;
+	//Frames in a row that have to leave work over before it shrinks.
+	const static int SHRINKFRAMES = 3;
+	//Frames of slack a new ring of tiles may take to draw. Work left over in that many frames after a grow is expected,
+	//and does not count towards a shrink.
+	const static int RINGFRAMES = 4;
+	//Length of a frame when the scheduler has no frame budget and draws everything within the update, in milliseconds.
+	const static int DEFAULTFRAMETIME = 16;
+
+private:
+	//member variables
+	int             m_fixedTileCount;//Draw ahead when the governor is off
+	int             m_tileCount;
+	int             m_minTileCount = 0;
+	int             m_maxTileCount = 0;//0 when the governor is off
+	int             m_calmFrames = 0;//Frames in a row that drained the queue within the budget
+	int             m_pressureFrames = 0;//Frames in a row that left work over or ran over the budget
+	int             m_settleFrames = 0;//Frames left before a grow may be undone
+	bool            m_hasCost = false;
+	DrawAheadStats  m_stats;
+};
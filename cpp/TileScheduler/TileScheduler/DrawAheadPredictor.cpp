@@ -0,0 +1,139 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "DrawAheadPredictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+DrawAheadPredictor::DrawAheadPredictor(int tileSize, int baseTileCount, int maxTileCount) :
+	m_tileSize(tileSize),
+	m_baseTileCount(baseTileCount),
+	m_maxTileCount(maxTileCount)
+{
+}
+
+//
+//  FUNCTION: AddPositionSample
+//
+//  PURPOSE: Feeds the position from an InteractionTracker ValuesChanged callback. The velocity is smoothed over the last
+//	few samples, since the tracker does not report a constant frame rate.
+//
+void DrawAheadPredictor::AddPositionSample(double timeMs, double positionX, double positionY)
+{
+	double elapsed = timeMs - m_lastTimeMs;
+
+	if (!m_hasSample || elapsed > MAXSAMPLEINTERVAL)
+	{
+		//First sample of a new motion, nothing to measure against yet.
+		m_velocityX = 0.0f;
+		m_velocityY = 0.0f;
+	}
+	else if (elapsed > 0.0)
+	{
+		const float smoothing = 0.5f;
+		float instantX = (float)((positionX - m_lastPositionX) / elapsed);
+		float instantY = (float)((positionY - m_lastPositionY) / elapsed);
+		m_velocityX = smoothing * instantX + (1.0f - smoothing) * m_velocityX;
+		m_velocityY = smoothing * instantY + (1.0f - smoothing) * m_velocityY;
+	}
+
+	m_hasSample = true;
+	m_lastTimeMs = timeMs;
+	m_lastPositionX = positionX;
+	m_lastPositionY = positionY;
+}
+
+//
+//  FUNCTION: SetInertiaTarget
+//
+//  PURPOSE: Called when the tracker enters inertia, with the position it will come to rest at.
+//
+void DrawAheadPredictor::SetInertiaTarget(double restingPositionX, double restingPositionY)
+{
+	m_hasInertiaTarget = true;
+	m_restingPositionX = restingPositionX;
+	m_restingPositionY = restingPositionY;
+}
+
+//
+//  FUNCTION: Reset
+//
+//  PURPOSE: Forgets the current motion, for example when the tracker goes idle or the scale changes.
+//
+void DrawAheadPredictor::Reset()
+{
+	m_hasSample = false;
+	m_hasInertiaTarget = false;
+	m_velocityX = 0.0f;
+	m_velocityY = 0.0f;
+}
+
+//
+//  FUNCTION: SetBaseTileCount
+//
+//  PURPOSE: Changes the draw ahead at rest, as a DrawAheadGovernor does when the tiles turn out cheaper or dearer to draw
+//	than planned. The motion seen so far is kept.
+//
+void DrawAheadPredictor::SetBaseTileCount(int baseTileCount)
+{
+	m_baseTileCount = std::max(baseTileCount, 0);
+}
+
+float DrawAheadPredictor::GetVelocityX() const
+{
+	return m_velocityX;
+}
+
+float DrawAheadPredictor::GetVelocityY() const
+{
+	return m_velocityY;
+}
+
+//
+//  FUNCTION: GetMargins
+//
+//  PURPOSE: Draw ahead margins for the current motion. Without motion every edge gets the base count.
+//
+DrawAheadMargins DrawAheadPredictor::GetMargins() const
+{
+	DrawAheadMargins margins;
+	int leading;
+	int trailing;
+
+	GetAxisMargins(m_velocityX, m_lastPositionX, m_restingPositionX, leading, trailing);
+	margins.right = m_velocityX >= 0.0f ? leading : trailing;
+	margins.left = m_velocityX >= 0.0f ? trailing : leading;
+
+	GetAxisMargins(m_velocityY, m_lastPositionY, m_restingPositionY, leading, trailing);
+	margins.bottom = m_velocityY >= 0.0f ? leading : trailing;
+	margins.top = m_velocityY >= 0.0f ? trailing : leading;
+
+	return margins;
+}
+
+void DrawAheadPredictor::GetAxisMargins(float velocity, double position, double restingPosition, int& leading, int& trailing) const
+{
+	float distance = std::fabs(velocity) * LOOKAHEADTIME;
+
+	//No point in drawing beyond the point where inertia is going to stop.
+	if (m_hasInertiaTarget)
+	{
+		float remaining = (float)(velocity >= 0.0f ? restingPosition - position : position - restingPosition);
+		distance = std::min(distance, std::max(remaining, 0.0f));
+	}
+
+	int tiles = (int)std::floor(distance / m_tileSize + 0.5f);
+	leading = std::min(m_baseTileCount + tiles, std::max(m_baseTileCount, m_maxTileCount));
+	trailing = std::max(m_baseTileCount - tiles, 0);
+}
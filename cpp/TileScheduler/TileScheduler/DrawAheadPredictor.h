@@ -0,0 +1,72 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+//
+//  STRUCT: DrawAheadMargins
+//
+//  PURPOSE: Number of tiles drawn ahead of the viewport on each of its four edges.
+//
+struct DrawAheadMargins
+{
+	int left = 0;
+	int top = 0;
+	int right = 0;
+	int bottom = 0;
+};
+
+//
+//  CLASS: DrawAheadPredictor
+//
+//  PURPOSE: Turns the stream of positions coming from the InteractionTracker into per edge draw ahead margins. The band
+//	grows on the edge the content is moving towards, in proportion to the velocity, and shrinks on the trailing edge so
+//	memory goes to tiles that are about to become visible rather than to tiles that were just left behind.
+//	When inertia has started, the leading band never reaches past the position the tracker is going to rest at.
+//
+class DrawAheadPredictor
+{
+public:
+	DrawAheadPredictor(int tileSize, int baseTileCount, int maxTileCount);
+	void AddPositionSample(double timeMs, double positionX, double positionY);
+	void SetInertiaTarget(double restingPositionX, double restingPositionY);
+	void Reset();
+	void SetBaseTileCount(int baseTileCount);
+	DrawAheadMargins GetMargins() const;
+	float GetVelocityX() const;
+	float GetVelocityY() const;
+
+	//How far ahead in time the leading edge tries to stay, in milliseconds.
+	const static int LOOKAHEADTIME = 250;
+	//Samples further apart than this are not considered part of the same motion, in milliseconds.
+	const static int MAXSAMPLEINTERVAL = 100;
+
+private:
+	void GetAxisMargins(float velocity, double position, double restingPosition, int& leading, int& trailing) const;
+
+	//member variables
+	int                     m_tileSize;
+	int                     m_baseTileCount;//Draw ahead when the content is not moving
+	int                     m_maxTileCount;//Upper bound of the leading band, unless the base count is higher
+
+	bool                    m_hasSample = false;
+	double                  m_lastTimeMs = 0.0;
+	double                  m_lastPositionX = 0.0;//Surface positions are doubles, a float is off by a pixel near the 2^24 edge
+	double                  m_lastPositionY = 0.0;
+	float                   m_velocityX = 0.0f;//Smoothed velocity in pixels per millisecond
+	float                   m_velocityY = 0.0f;
+
+	bool                    m_hasInertiaTarget = false;
+	double                  m_restingPositionX = 0.0;
+	double                  m_restingPositionY = 0.0;
+};
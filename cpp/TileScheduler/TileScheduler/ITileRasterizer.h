@@ -0,0 +1,37 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileRange.h"
+
+#include <cstddef>
+#include <cstdint>
+
+//
+//  CLASS: ITileRasterizer
+//
+//  PURPOSE: Produces the pixels of a tile on the CPU, as premultiplied B8G8R8A8, the format of the virtual surfaces. It is
+//	called from the threads of a TileWorkerPool, several tiles at a time, so it must not change any state of its own.
+//	The same tile must always come out the same, whatever the thread, the order or the band it is drawn in.
+//
+class ITileRasterizer
+{
+public:
+	virtual ~ITileRasterizer() = default;
+
+	//Writes lines firstLine to firstLine + lineCount - 1 of the tile, every one of its tileSize pixels. pixels points to
+	//the first pixel of line firstLine, lines are stride pixels apart. At level n the tile covers 2^n by 2^n tiles of
+	//level 0, as in ITileRenderer::DrawLevelOfDetailRange.
+	virtual void RasterizeTile(TileCoordinate tile, int level, int tileSize, int firstLine, int lineCount, uint32_t* pixels, ptrdiff_t stride) const = 0;
+};
@@ -0,0 +1,48 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileRange.h"
+
+#include <vector>
+
+//
+//  CLASS: ITileRenderer
+//
+//  PURPOSE: Abstract renderer the TileScheduler draws through. The samples implement this on top of a
+//	CompositionVirtualDrawingSurface, the benchmark implements it with a recording renderer that never touches a GPU.
+//
+class ITileRenderer
+{
+public:
+	virtual ~ITileRenderer() = default;
+
+	//Draws every tile in the range. Returns false when the draw could not happen (for example on device loss).
+	virtual bool DrawTileRange(TileRange const& range) = 0;
+
+	//Discards the content of every tile that is not in one of the ranges. The ranges do not overlap.
+	virtual void Trim(std::vector<TileRange> const& keepRanges) = 0;
+
+	//Draws every tile in the range at a coarser level of detail, used while zooming. At level n a tile covers 2^n by 2^n
+	//tiles of level 0. Renderers without a tile pyramid never get asked, as long as the TileScheduler is not given any levels.
+	virtual bool DrawLevelOfDetailRange(TileRange const& /*range*/, int /*level*/)
+	{
+		return false;
+	}
+
+	//Discards the content of every tile of the given level outside the range.
+	virtual void TrimLevelOfDetail(TileRange const& /*keepRange*/, int /*level*/)
+	{
+	}
+};
@@ -0,0 +1,36 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileRange.h"
+
+#include <cstddef>
+#include <cstdint>
+
+//
+//  CLASS: ITileUploader
+//
+//  PURPOSE: Copies tiles rasterized on the CPU to the surface. This is the only part of the CPU path that runs on the UI
+//	thread, the samples implement it on top of BeginDraw/EndDraw, the benchmark with a checksum.
+//
+class ITileUploader
+{
+public:
+	virtual ~ITileUploader() = default;
+
+	//Uploads every tile of the range at the given level. pixels holds the whole range as one image, tiles side by side,
+	//its first pixel is the top left pixel of the first tile and lines are stride pixels apart. Returns false when the
+	//upload could not happen (for example on device loss).
+	virtual bool UploadTileRange(TileRange const& range, int level, uint32_t const* pixels, ptrdiff_t stride) = 0;
+};
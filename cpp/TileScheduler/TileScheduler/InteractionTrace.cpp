@@ -0,0 +1,382 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "InteractionTrace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static const char MAGIC[4] = { 'I', 'T', 'R', 'C' };
+static const size_t HEADERSIZE = 12;
+
+static void WriteUint32(std::vector<uint8_t>& data, uint32_t value)
+{
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		data.push_back((uint8_t)(value >> shift));
+	}
+}
+
+static void WriteFloat(std::vector<uint8_t>& data, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	WriteUint32(data, bits);
+}
+
+static void WriteVarint(std::vector<uint8_t>& data, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		data.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	data.push_back((uint8_t)value);
+}
+
+static bool ReadUint32(std::vector<uint8_t> const& data, size_t& offset, uint32_t& value)
+{
+	if (data.size() - offset < 4)
+	{
+		return false;
+	}
+	value = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		value |= (uint32_t)data[offset++] << (i * 8);
+	}
+	return true;
+}
+
+static bool ReadFloat(std::vector<uint8_t> const& data, size_t& offset, float& value)
+{
+	uint32_t bits;
+	if (!ReadUint32(data, offset, bits))
+	{
+		return false;
+	}
+	memcpy(&value, &bits, sizeof(value));
+	return true;
+}
+
+static bool ReadVarint(std::vector<uint8_t> const& data, size_t& offset, uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64 && offset < data.size(); shift += 7)
+	{
+		uint8_t byte = data[offset++];
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//Number of floats stored with each kind of event.
+static int GetFloatCount(InteractionEvent::Kind kind)
+{
+	switch (kind)
+	{
+	case InteractionEvent::Kind::Values: return 3;
+	case InteractionEvent::Kind::Size: return 2;
+	case InteractionEvent::Kind::Inertia: return 2;
+	default: return 0;
+	}
+}
+
+//
+//  FUNCTION: Load
+//
+//  PURPOSE: Appends the events of a binary or text trace to events. Returns false when the file cannot be read or a
+//	binary trace is cut short.
+//
+bool InteractionTrace::Load(char const* path, std::vector<InteractionEvent>& events)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if (data.size() >= sizeof(MAGIC) && memcmp(data.data(), MAGIC, sizeof(MAGIC)) == 0)
+	{
+		return LoadBinary(data, events);
+	}
+	return LoadText(data, events);
+}
+
+bool InteractionTrace::LoadBinary(std::vector<uint8_t> const& data, std::vector<InteractionEvent>& events)
+{
+	size_t offset = sizeof(MAGIC);
+	uint32_t version;
+	uint32_t eventCount;
+	if (!ReadUint32(data, offset, version) || !ReadUint32(data, offset, eventCount) || version != VERSION)
+	{
+		return false;
+	}
+
+	//Every event takes at least two bytes, a corrupt count is not allowed to reserve more than the file can hold.
+	events.reserve(events.size() + std::min<size_t>(eventCount, (data.size() - offset) / 2));
+	uint64_t timeUs = 0;
+	for (uint32_t i = 0; i < eventCount; i++)
+	{
+		if (offset >= data.size() || data[offset] >= (uint8_t)InteractionEvent::Kind::Count)
+		{
+			return false;
+		}
+		InteractionEvent e;
+		e.kind = (InteractionEvent::Kind)data[offset++];
+
+		uint64_t deltaUs;
+		if (!ReadVarint(data, offset, deltaUs))
+		{
+			return false;
+		}
+		timeUs += deltaUs;
+		e.timeMs = (double)timeUs / 1000.0;
+
+		float* values[3] = { &e.x, &e.y, &e.scale };
+		for (int value = 0; value < GetFloatCount(e.kind); value++)
+		{
+			if (!ReadFloat(data, offset, *values[value]))
+			{
+				return false;
+			}
+		}
+		events.push_back(e);
+	}
+	return true;
+}
+
+bool InteractionTrace::LoadText(std::vector<uint8_t> const& data, std::vector<InteractionEvent>& events)
+{
+	std::istringstream text(std::string(data.begin(), data.end()));
+	std::string line;
+	while (std::getline(text, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream stream(line);
+		InteractionEvent e;
+		std::string kind;
+		if (!(stream >> e.timeMs >> kind >> e.x >> e.y))
+		{
+			continue;
+		}
+		stream >> e.scale;
+
+		if (kind == "size") e.kind = InteractionEvent::Kind::Size;
+		else if (kind == "values") e.kind = InteractionEvent::Kind::Values;
+		else if (kind == "inertia") e.kind = InteractionEvent::Kind::Inertia;
+		else if (kind == "idle") e.kind = InteractionEvent::Kind::Idle;
+		else if (kind == "interacting") e.kind = InteractionEvent::Kind::Interacting;
+		else continue;
+
+		events.push_back(e);
+	}
+	return true;
+}
+
+//
+//  FUNCTION: Save
+//
+//  PURPOSE: Writes events as a binary trace. Times are kept to the microsecond, an event earlier than the one before it
+//	is written at the same time as that one.
+//
+bool InteractionTrace::Save(char const* path, std::vector<InteractionEvent> const& events)
+{
+	std::vector<uint8_t> data(MAGIC, MAGIC + sizeof(MAGIC));
+	data.reserve(HEADERSIZE + events.size() * 15);
+	WriteUint32(data, VERSION);
+	WriteUint32(data, (uint32_t)events.size());
+
+	uint64_t timeUs = 0;
+	for (InteractionEvent const& e : events)
+	{
+		uint64_t eventTimeUs = e.timeMs > 0.0 ? (uint64_t)std::llround(e.timeMs * 1000.0) : 0;
+		eventTimeUs = eventTimeUs > timeUs ? eventTimeUs : timeUs;
+		data.push_back((uint8_t)e.kind);
+		WriteVarint(data, eventTimeUs - timeUs);
+		timeUs = eventTimeUs;
+
+		float const values[3] = { e.x, e.y, e.scale };
+		for (int value = 0; value < GetFloatCount(e.kind); value++)
+		{
+			WriteFloat(data, values[value]);
+		}
+	}
+
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	file.write((char const*)data.data(), (std::streamsize)data.size());
+	return (bool)file;
+}
+
+void InteractionTraceRecorder::Start()
+{
+	m_events.clear();
+	m_events.reserve(INITIALCAPACITY);
+	m_start = std::chrono::steady_clock::now();
+	m_recording = true;
+}
+
+bool InteractionTraceRecorder::IsRecording() const
+{
+	return m_recording;
+}
+
+void InteractionTraceRecorder::Record(InteractionEvent::Kind kind, float x, float y, float scale)
+{
+	if (!m_recording)
+	{
+		return;
+	}
+	InteractionEvent e;
+	e.timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+	e.kind = kind;
+	e.x = x;
+	e.y = y;
+	e.scale = scale;
+	m_events.push_back(e);
+}
+
+std::vector<InteractionEvent> const& InteractionTraceRecorder::GetEvents() const
+{
+	return m_events;
+}
+
+bool InteractionTraceRecorder::Save(char const* path) const
+{
+	return InteractionTrace::Save(path, m_events);
+}
+
+InteractionTraceReplayer::InteractionTraceReplayer(TileScheduler& scheduler) :
+	m_scheduler(scheduler)
+{
+}
+
+void InteractionTraceReplayer::SetPace(double pace)
+{
+	m_pace = pace > 0.0 ? pace : 0.0;
+}
+
+void InteractionTraceReplayer::SetViewport(int viewport, double offsetX, double offsetY)
+{
+	m_viewport = viewport;
+	m_offsetX = offsetX;
+	m_offsetY = offsetY;
+}
+
+//
+//  FUNCTION: WaitUntilDue
+//
+//  PURPOSE: Sleeps until the event is due at the current pace, counting from the first event. Returns right away when a
+//	replay runs late, or when there is no pace.
+//
+void InteractionTraceReplayer::WaitUntilDue(InteractionEvent const& e)
+{
+	if (!m_started)
+	{
+		m_started = true;
+		m_start = std::chrono::steady_clock::now();
+		m_firstTimeMs = e.timeMs;
+		return;
+	}
+	if (m_pace > 0.0)
+	{
+		std::chrono::duration<double, std::milli> offset((e.timeMs - m_firstTimeMs) / m_pace);
+		std::this_thread::sleep_until(m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+	}
+}
+
+//
+//  FUNCTION: Apply
+//
+//  PURPOSE: Does what WinComp does on the callback the event stands for. Returns true if the event reached the scheduler.
+//
+bool InteractionTraceReplayer::Apply(InteractionEvent const& e)
+{
+	switch (e.kind)
+	{
+	case InteractionEvent::Kind::Size:
+		m_windowWidth = e.x;
+		m_windowHeight = e.y;
+		m_lastTimeMs = e.timeMs;
+		UpdateViewPort();
+		return true;
+
+	case InteractionEvent::Kind::Values:
+	{
+		bool updated = false;
+		if (m_lastTrackerScale == e.scale)
+		{
+			m_scheduler.UpdateVisibleRegion(m_viewport, e.x / m_lastTrackerScale + m_offsetX, e.y / m_lastTrackerScale + m_offsetY, e.timeMs);
+			updated = true;
+		}
+		else
+		{
+			//The full resolution tiles wait for the zoom to end, coarse tiles fill the viewport in the meantime.
+			m_zooming = true;
+			m_scheduler.UpdateZoom(m_viewport, e.x / e.scale + m_offsetX, e.y / e.scale + m_offsetY, m_windowWidth / e.scale, m_windowHeight / e.scale, e.scale);
+			updated = m_scheduler.GetZoomLevel() > 0;
+		}
+		m_lastTrackerScale = e.scale;
+		m_lastTrackerX = e.x;
+		m_lastTrackerY = e.y;
+		m_lastTimeMs = e.timeMs;
+		return updated;
+	}
+
+	case InteractionEvent::Kind::Idle:
+	{
+		bool updated = m_zooming;
+		m_lastTimeMs = e.timeMs;
+		m_scheduler.ResetDrawAhead(m_viewport);
+		if (m_zooming)
+		{
+			UpdateViewPort();
+		}
+		m_zooming = false;
+		m_scheduler.FlushTrim();
+		return updated;
+	}
+
+	case InteractionEvent::Kind::Inertia:
+		m_scheduler.SetInertiaTarget(m_viewport, e.x / m_lastTrackerScale + m_offsetX, e.y / m_lastTrackerScale + m_offsetY);
+		return false;
+
+	case InteractionEvent::Kind::Interacting:
+		m_scheduler.ResetDrawAhead(m_viewport);
+		return false;
+
+	default:
+		return false;
+	}
+}
+
+void InteractionTraceReplayer::UpdateViewPort()
+{
+	m_scheduler.UpdateViewportSize(m_viewport, m_windowWidth / m_lastTrackerScale, m_windowHeight / m_lastTrackerScale);
+	m_scheduler.UpdateVisibleRegion(m_viewport, m_lastTrackerX / m_lastTrackerScale + m_offsetX, m_lastTrackerY / m_lastTrackerScale + m_offsetY, m_lastTimeMs);
+}
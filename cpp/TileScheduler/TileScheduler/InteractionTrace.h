@@ -0,0 +1,127 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileScheduler.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+//  STRUCT: InteractionEvent
+//
+//  PURPOSE: One InteractionTracker callback (or window resize) as seen by WinComp. Positions are tracker positions, that
+//	is before they are divided by the scale. Times are in milliseconds from the start of the trace.
+//
+struct InteractionEvent
+{
+	enum class Kind : uint8_t { Size, Values, Inertia, Idle, Interacting, Count };
+
+	double  timeMs = 0.0;
+	Kind    kind = Kind::Values;
+	float   x = 0.0f;//Tracker position, resting position for Inertia events, or window width for Size events
+	float   y = 0.0f;//Tracker position, resting position for Inertia events, or window height for Size events
+	float   scale = 1.0f;
+};
+
+//
+//  CLASS: InteractionTrace
+//
+//  PURPOSE: Reads and writes traces of InteractionEvents. The binary format is a 12 byte header, "ITRC", the version and
+//	the number of events as little endian 32 bit integers, followed by the events. Every event is its kind in one byte,
+//	the time since the previous event in microseconds as an unsigned LEB128 varint, then the little endian floats the kind
+//	needs: x, y and scale for Values, x and y for Size and Inertia, nothing for Idle and Interacting. A 60Hz pan costs 15
+//	bytes a frame.
+//	The text format has one "<timeMs> <size|values|inertia|idle|interacting> <x> <y> [scale]" event per line, # starts a
+//	comment. Load tells the two apart from the header.
+//
+class InteractionTrace
+{
+public:
+	static bool Load(char const* path, std::vector<InteractionEvent>& events);
+	static bool Save(char const* path, std::vector<InteractionEvent> const& events);
+
+	const static uint32_t VERSION = 1;
+
+private:
+	static bool LoadBinary(std::vector<uint8_t> const& data, std::vector<InteractionEvent>& events);
+	static bool LoadText(std::vector<uint8_t> const& data, std::vector<InteractionEvent>& events);
+};
+
+//
+//  CLASS: InteractionTraceRecorder
+//
+//  PURPOSE: Collects the InteractionTracker callbacks of a running app, timed from the call to Start. Record does nothing
+//	until then, so the hooks can stay in place when nothing is being recorded.
+//
+class InteractionTraceRecorder
+{
+public:
+	void Start();
+	bool IsRecording() const;
+	void Record(InteractionEvent::Kind kind, float x, float y, float scale);
+	std::vector<InteractionEvent> const& GetEvents() const;
+	bool Save(char const* path) const;
+
+	//Events the recorder has room for before it has to grow, about a minute of 60Hz updates.
+	const static int INITIALCAPACITY = 4096;
+
+private:
+	//member variables
+	bool                                    m_recording = false;
+	std::chrono::steady_clock::time_point   m_start;
+	std::vector<InteractionEvent>           m_events;
+};
+
+//
+//  CLASS: InteractionTraceReplayer
+//
+//  PURPOSE: Drives a TileScheduler exactly like WinComp drives its TileDrawingManager from the InteractionTracker owner
+//	callbacks, so a recorded trace reproduces the work of the original session without a window or a compositor.
+//	WaitUntilDue paces the replay: at a pace of 1 events are applied when they originally happened, at 4 four times as
+//	fast. At a pace of 0, the default, events are applied back to back.
+//	SetViewport makes it drive another viewport of the scheduler, looking at the surface from an offset, so one trace can
+//	stand for a second pane scrolled in step with the first.
+//
+class InteractionTraceReplayer
+{
+public:
+	explicit InteractionTraceReplayer(TileScheduler& scheduler);
+	void SetPace(double pace);
+	void SetViewport(int viewport, double offsetX, double offsetY);
+	void WaitUntilDue(InteractionEvent const& e);
+	bool Apply(InteractionEvent const& e);
+
+private:
+	void UpdateViewPort();
+
+	//member variables
+	TileScheduler&                          m_scheduler;
+	int                                     m_viewport = TileScheduler::DEFAULTVIEWPORT;
+	double                                  m_offsetX = 0.0;//Added to the positions of the trace, in surface pixels
+	double                                  m_offsetY = 0.0;
+	double                                  m_pace = 0.0;
+	bool                                    m_started = false;
+	std::chrono::steady_clock::time_point   m_start;//When the first event was applied
+	double                                  m_firstTimeMs = 0.0;//Time of that event in the trace
+	float                                   m_windowWidth = 0.0f;
+	float                                   m_windowHeight = 0.0f;
+	float                                   m_lastTrackerScale = 1.0f;
+	float                                   m_lastTrackerX = 0.0f;
+	float                                   m_lastTrackerY = 0.0f;
+	double                                  m_lastTimeMs = 0.0;
+	bool                                    m_zooming = false;
+};
@@ -0,0 +1,112 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "LatencyHistogram.h"
+
+uint64_t LatencyHistogram::GetBucketLowerBound(int bucket)
+{
+	if (bucket < SUBBUCKETCOUNT)
+	{
+		return (uint64_t)bucket;
+	}
+	int shift = bucket / SUBBUCKETCOUNT - 1;
+	return (uint64_t)(bucket % SUBBUCKETCOUNT + SUBBUCKETCOUNT) << shift;
+}
+
+uint64_t LatencyHistogram::GetBucketWidth(int bucket)
+{
+	return bucket < SUBBUCKETCOUNT ? 1 : 1ull << (bucket / SUBBUCKETCOUNT - 1);
+}
+
+void LatencyHistogram::Record(uint64_t value)
+{
+	m_buckets[GetBucket(value)]++;
+	m_count++;
+	m_sum += value;
+	m_max = value > m_max ? value : m_max;
+}
+
+void LatencyHistogram::AddBucket(int bucket, uint64_t count)
+{
+	m_buckets[bucket] += count;
+	m_count += count;
+}
+
+//Adds the sum and max of values counted with AddBucket.
+void LatencyHistogram::AddTotals(uint64_t sum, uint64_t max)
+{
+	m_sum += sum;
+	m_max = max > m_max ? max : m_max;
+}
+
+void LatencyHistogram::Merge(LatencyHistogram const& other)
+{
+	for (int bucket = 0; bucket < BUCKETCOUNT; bucket++)
+	{
+		m_buckets[bucket] += other.m_buckets[bucket];
+	}
+	m_count += other.m_count;
+	m_sum += other.m_sum;
+	m_max = other.m_max > m_max ? other.m_max : m_max;
+}
+
+void LatencyHistogram::Clear()
+{
+	*this = LatencyHistogram{};
+}
+
+uint64_t LatencyHistogram::GetCount() const
+{
+	return m_count;
+}
+
+uint64_t LatencyHistogram::GetSum() const
+{
+	return m_sum;
+}
+
+uint64_t LatencyHistogram::GetMax() const
+{
+	return m_max;
+}
+
+double LatencyHistogram::GetMean() const
+{
+	return m_count == 0 ? 0.0 : (double)m_sum / (double)m_count;
+}
+
+//
+//  FUNCTION: GetPercentile
+//
+//  PURPOSE: Value below which the given fraction of the recorded values fall, as the middle of the bucket it lands in,
+//	never above the largest value recorded.
+//
+uint64_t LatencyHistogram::GetPercentile(double percentile) const
+{
+	if (m_count == 0)
+	{
+		return 0;
+	}
+	uint64_t rank = (uint64_t)(percentile * (double)(m_count - 1)) + 1;
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < BUCKETCOUNT; bucket++)
+	{
+		seen += m_buckets[bucket];
+		if (seen >= rank)
+		{
+			uint64_t value = GetBucketLowerBound(bucket) + GetBucketWidth(bucket) / 2;
+			return value < m_max ? value : m_max;
+		}
+	}
+	return m_max;
+}
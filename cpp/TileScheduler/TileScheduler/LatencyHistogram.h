@@ -0,0 +1,86 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//
+//  CLASS: LatencyHistogram
+//
+//  PURPOSE: Histogram with log-linear buckets, in the manner of HDR histograms: every power of two is split into
+//	SUBBUCKETCOUNT equal buckets, so any value is counted to within 1/16 of itself whether it is 40 nanoseconds or 40
+//	seconds, and recording is one bit scan and one increment. Values are unitless, the telemetry records durations in
+//	nanoseconds and tile counts as they are. Values from 2^MAXVALUEBITS up are counted in the last bucket.
+//	The buckets live in the object, so a histogram never allocates.
+//
+class LatencyHistogram
+{
+public:
+	void Record(uint64_t value);
+	void AddBucket(int bucket, uint64_t count);
+	void AddTotals(uint64_t sum, uint64_t max);
+	void Merge(LatencyHistogram const& other);
+	void Clear();
+	uint64_t GetCount() const;
+	uint64_t GetSum() const;
+	uint64_t GetMax() const;
+	double GetMean() const;
+	uint64_t GetPercentile(double percentile) const;
+
+	//Values below SUBBUCKETCOUNT have a bucket each. Above, the highest bit gives the power of two and the next
+	//SUBBUCKETBITS bits the bucket within it. Defined here, the telemetry calls it for every value it records.
+	static int GetBucket(uint64_t value)
+	{
+		if (value < (uint64_t)SUBBUCKETCOUNT)
+		{
+			return (int)value;
+		}
+		if (value >= (1ull << MAXVALUEBITS))
+		{
+			return BUCKETCOUNT - 1;
+		}
+		int shift = HighestBit(value) - SUBBUCKETBITS;
+		return (shift + 1) * SUBBUCKETCOUNT + (int)(value >> shift) - SUBBUCKETCOUNT;
+	}
+	static uint64_t GetBucketLowerBound(int bucket);
+	static uint64_t GetBucketWidth(int bucket);
+
+	const static int SUBBUCKETBITS = 4;
+	const static int SUBBUCKETCOUNT = 1 << SUBBUCKETBITS;
+	const static int MAXVALUEBITS = 40;
+	const static int BUCKETCOUNT = (MAXVALUEBITS - SUBBUCKETBITS + 1) * SUBBUCKETCOUNT;
+
+private:
+	//Index of the highest bit set, value must not be 0.
+	static int HighestBit(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return (int)index;
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+
+	//member variables
+	uint64_t                m_buckets[BUCKETCOUNT] = {};
+	uint64_t                m_count = 0;
+	uint64_t                m_sum = 0;//Kept next to the buckets, so the mean and the max are exact
+	uint64_t                m_max = 0;
+};
@@ -0,0 +1,293 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "ParallelTileRenderer.h"
+#include "TileCodec.h"
+#include "TileTelemetry.h"
+
+#include <algorithm>
+#include <chrono>
+
+ParallelTileRenderer::ParallelTileRenderer(ITileRasterizer const& rasterizer, int tileSize, int threadCount) :
+	m_rasterizer(rasterizer),
+	m_tileSize(tileSize),
+	m_pool(threadCount)
+{
+}
+
+void ParallelTileRenderer::SetUploader(ITileUploader* uploader)
+{
+	m_uploader = uploader;
+}
+
+//
+//  FUNCTION: SetTileStore
+//
+//  PURPOSE: Sets the store tiles are restored from and compressed into, nullptr rasterizes every tile.
+//
+void ParallelTileRenderer::SetTileStore(CompressedTileStore* store)
+{
+	m_store = store;
+}
+
+//
+//  FUNCTION: SetDiskCache
+//
+//  PURPOSE: Sets the disk cache tiles are looked for in after the store, and appended to. The hashes identify the content
+//	the rasterizer draws and the options it draws it with, tiles drawn from anything else are never found.
+//
+void ParallelTileRenderer::SetDiskCache(TileDiskCache* diskCache, uint64_t contentHash, uint64_t optionsHash)
+{
+	m_diskCache = diskCache;
+	m_contentHash = contentHash;
+	m_optionsHash = optionsHash;
+}
+
+void ParallelTileRenderer::SetTileSize(int tileSize)
+{
+	m_tileSize = tileSize;
+}
+
+int ParallelTileRenderer::GetThreadCount() const
+{
+	return m_pool.GetThreadCount();
+}
+
+ParallelRenderStats ParallelTileRenderer::GetStats() const
+{
+	return m_stats;
+}
+
+TileWorkerPoolStats ParallelTileRenderer::GetPoolStats() const
+{
+	return m_pool.GetStats();
+}
+
+//
+//  FUNCTION: DrawTileRange
+//
+//  PURPOSE: Rasterizes every tile of the range on the worker threads, waits for them, then uploads the range in one go.
+//	Returns false when the upload failed, the tiles are then not on the surface.
+//
+bool ParallelTileRenderer::DrawTileRange(TileRange const& range, int level)
+{
+	if (range.IsEmpty() || m_uploader == nullptr)
+	{
+		return false;
+	}
+
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+
+	m_range = range;
+	m_level = level;
+	m_stride = (ptrdiff_t)range.numColumns * m_tileSize;
+	size_t pixelCount = (size_t)m_stride * range.numRows * m_tileSize;
+	if (m_pixels.size() < pixelCount)
+	{
+		m_pixels.resize(pixelCount);
+	}
+
+	int tileCount = range.TileCount();
+	FindStoredTiles();
+
+	int wantedTasks = m_pool.GetThreadCount() * BANDSPERTHREAD;
+	m_bandsPerTile = std::min(std::max((wantedTasks + tileCount - 1) / tileCount, 1), std::max(m_tileSize / MINBANDHEIGHT, 1));
+	int taskCount = tileCount * m_bandsPerTile;
+	m_pool.Run(taskCount, &ParallelTileRenderer::RasterizeBand, this);
+
+	auto rasterized = clock::now();
+	bool uploaded;
+	{
+		TileSpanScope span(TileSpan::Upload, tileCount);
+		uploaded = m_uploader->UploadTileRange(range, level, m_pixels.data(), m_stride);
+	}
+	auto uploadEnd = clock::now();
+	if (m_store != nullptr || m_diskCache != nullptr)
+	{
+		StoreTiles();
+	}
+	auto end = clock::now();
+
+	m_stats.ranges++;
+	m_stats.tiles += tileCount;
+	m_stats.restoredTiles += m_restoredCount;
+	m_stats.diskTiles += m_diskCount;
+	m_stats.tasks += taskCount;
+	m_stats.failedUploads += uploaded ? 0 : 1;
+	m_stats.rasterMs += std::chrono::duration<double, std::milli>(rasterized - start).count();
+	m_stats.uploadMs += std::chrono::duration<double, std::milli>(uploadEnd - rasterized).count();
+	m_stats.compressMs += std::chrono::duration<double, std::milli>(end - uploadEnd).count();
+	return uploaded;
+}
+
+//
+//  FUNCTION: FindStoredTiles
+//
+//  PURPOSE: Looks for every tile of the range in the store, then in the disk cache. The tiles found in neither are
+//	rasterized.
+//
+void ParallelTileRenderer::FindStoredTiles()
+{
+	int tileCount = m_range.TileCount();
+	m_storedTiles.assign(tileCount, StoredTile{});
+	m_restoredCount = 0;
+	m_diskCount = 0;
+	if (m_store != nullptr)
+	{
+		m_store->SetTileSize(m_tileSize);
+	}
+	if (m_diskCache != nullptr)
+	{
+		m_diskCache->Refresh();
+	}
+
+	for (int tileIndex = 0; tileIndex < tileCount && (m_store != nullptr || m_diskCache != nullptr); tileIndex++)
+	{
+		TileCoordinate tile{ m_range.startColumn + tileIndex % m_range.numColumns, m_range.startRow + tileIndex / m_range.numColumns };
+		StoredTile& stored = m_storedTiles[tileIndex];
+		std::vector<uint8_t> const* data = m_store != nullptr ? m_store->Find(tile, m_level) : nullptr;
+		if (data != nullptr)
+		{
+			stored.data = data->data();
+			stored.size = data->size();
+		}
+		else if (m_diskCache != nullptr && m_diskCache->Find(GetDiskKey(tile), stored.data, stored.size))
+		{
+			stored.fromDisk = true;
+			m_diskCount++;
+		}
+		m_restoredCount += stored.data != nullptr ? 1 : 0;
+	}
+	if (m_store != nullptr)
+	{
+		m_store->RecordRestores(m_restoredCount);
+	}
+}
+
+TileDiskKey ParallelTileRenderer::GetDiskKey(TileCoordinate tile) const
+{
+	TileDiskKey key;
+	key.content = m_contentHash;
+	key.options = m_optionsHash;
+	key.column = tile.column;
+	key.row = tile.row;
+	key.level = m_level;
+	key.tileSize = m_tileSize;
+	return key;
+}
+
+//
+//  FUNCTION: StoreTiles
+//
+//  PURPOSE: Compresses the tiles of the range that were rasterized on the worker threads, then adds them to the store
+//	and appends them to the disk cache. Tiles read from the disk cache go to the store as they are. The buffers tiles are
+//	compressed into are kept for the next range.
+//
+void ParallelTileRenderer::StoreTiles()
+{
+	m_compressTiles.clear();
+	for (int tileIndex = 0; tileIndex < (int)m_storedTiles.size(); tileIndex++)
+	{
+		StoredTile const& stored = m_storedTiles[tileIndex];
+		if (stored.data == nullptr)
+		{
+			m_compressTiles.push_back(tileIndex);
+		}
+		else if (stored.fromDisk && m_store != nullptr)
+		{
+			TileCoordinate tile{ m_range.startColumn + tileIndex % m_range.numColumns, m_range.startRow + tileIndex / m_range.numColumns };
+			m_store->Insert(tile, m_level, stored.data, stored.size);
+		}
+	}
+	if (m_compressed.size() < m_compressTiles.size())
+	{
+		m_compressed.resize(m_compressTiles.size());
+	}
+	m_pool.Run((int)m_compressTiles.size(), &ParallelTileRenderer::CompressTile, this);
+
+	for (size_t i = 0; i < m_compressTiles.size(); i++)
+	{
+		int tileIndex = m_compressTiles[i];
+		TileCoordinate tile{ m_range.startColumn + tileIndex % m_range.numColumns, m_range.startRow + tileIndex / m_range.numColumns };
+		if (m_store != nullptr)
+		{
+			m_store->Insert(tile, m_level, m_compressed[i].data(), m_compressed[i].size());
+		}
+		if (m_diskCache != nullptr)
+		{
+			m_diskCache->Append(GetDiskKey(tile), m_compressed[i].data(), m_compressed[i].size());
+		}
+	}
+}
+
+//
+//  FUNCTION: CompressTile
+//
+//  PURPOSE: Task run by the worker pool for StoreTiles, compresses one tile of the staging image.
+//
+void ParallelTileRenderer::CompressTile(void* context, int index)
+{
+	TileSpanScope span(TileSpan::CompressTile);
+	ParallelTileRenderer& renderer = *static_cast<ParallelTileRenderer*>(context);
+	int tileIndex = renderer.m_compressTiles[index];
+	int column = tileIndex % renderer.m_range.numColumns;
+	int row = tileIndex / renderer.m_range.numColumns;
+	int tileSize = renderer.m_tileSize;
+	uint32_t const* pixels = renderer.m_pixels.data() + (ptrdiff_t)row * tileSize * renderer.m_stride + (ptrdiff_t)column * tileSize;
+	TileCodec::Encode(pixels, renderer.m_stride, tileSize, tileSize, renderer.m_compressed[index]);
+}
+
+//
+//  FUNCTION: RasterizeBand
+//
+//  PURPOSE: Task run by the worker pool. Bands of the same tile are next to each other, tiles go row by row, so threads
+//	working through their share walk the staging image from top to bottom.
+//
+void ParallelTileRenderer::RasterizeBand(void* context, int index)
+{
+	TileSpanScope span(TileSpan::RasterizeBand);
+	ParallelTileRenderer& renderer = *static_cast<ParallelTileRenderer*>(context);
+	int tileIndex = index / renderer.m_bandsPerTile;
+	int band = index % renderer.m_bandsPerTile;
+	int column = tileIndex % renderer.m_range.numColumns;
+	int row = tileIndex / renderer.m_range.numColumns;
+
+	int tileSize = renderer.m_tileSize;
+	TileCoordinate tile{ renderer.m_range.startColumn + column, renderer.m_range.startRow + row };
+
+	//A stored tile is decoded whole by its first band, lines depend on the ones above them. Should the data not decode,
+	//the tile is rasterized whole instead.
+	StoredTile const& stored = renderer.m_storedTiles[tileIndex];
+	if (stored.data != nullptr)
+	{
+		if (band != 0)
+		{
+			return;
+		}
+		uint32_t* tilePixels = renderer.m_pixels.data() + (ptrdiff_t)row * tileSize * renderer.m_stride + (ptrdiff_t)column * tileSize;
+		TileSpanScope restoreSpan(TileSpan::RestoreTile);
+		if (!TileCodec::Decode(stored.data, stored.size, tileSize, tileSize, tilePixels, renderer.m_stride))
+		{
+			renderer.m_rasterizer.RasterizeTile(tile, renderer.m_level, tileSize, 0, tileSize, tilePixels, renderer.m_stride);
+		}
+		return;
+	}
+
+	int firstLine = (int)((int64_t)tileSize * band / renderer.m_bandsPerTile);
+	int endLine = (int)((int64_t)tileSize * (band + 1) / renderer.m_bandsPerTile);
+
+	uint32_t* pixels = renderer.m_pixels.data() +
+		((ptrdiff_t)row * tileSize + firstLine) * renderer.m_stride + (ptrdiff_t)column * tileSize;
+	renderer.m_rasterizer.RasterizeTile(tile, renderer.m_level, tileSize, firstLine, endLine - firstLine, pixels, renderer.m_stride);
+}
@@ -0,0 +1,112 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "CompressedTileStore.h"
+#include "ITileRasterizer.h"
+#include "ITileUploader.h"
+#include "TileDiskCache.h"
+#include "TileWorkerPool.h"
+
+#include <cstdint>
+#include <vector>
+
+//
+//  STRUCT: ParallelRenderStats
+//
+//  PURPOSE: Work done by a ParallelTileRenderer, and where the time went.
+//
+struct ParallelRenderStats
+{
+	uint64_t ranges = 0;//Calls to DrawTileRange
+	uint64_t tiles = 0;//Tiles rasterized or restored
+	uint64_t restoredTiles = 0;//Tiles decompressed from the CompressedTileStore or the TileDiskCache instead of rasterized
+	uint64_t diskTiles = 0;//Tiles of those that came from the TileDiskCache
+	uint64_t tasks = 0;//Bands of tiles handed to the worker pool
+	uint64_t failedUploads = 0;//Ranges the uploader could not copy to the surface
+	double   rasterMs = 0.0;//Time the calling thread waited for the workers
+	double   uploadMs = 0.0;//Time spent in the uploader, on the calling thread
+	double   compressMs = 0.0;//Time spent compressing tiles into the store and the disk cache
+};
+
+//
+//  CLASS: ParallelTileRenderer
+//
+//  PURPOSE: CPU path for drawing tile ranges. The tiles of a range are rasterized by an ITileRasterizer on the threads of
+//	a TileWorkerPool, into a staging image that holds the whole range. Once every tile is done the calling thread hands
+//	the image to the ITileUploader, so the surface is only ever touched from the thread that owns it and tiles reach it in
+//	the same order whatever the number of threads.
+//	Tiles are cut into bands of lines when a range has fewer tiles than there are threads, so the small strips a pan
+//	exposes keep every thread busy too. The staging image is reused, it only grows with the largest range seen.
+//	With a CompressedTileStore, tiles found in the store are decompressed instead of rasterized, one task per tile. Once
+//	the range is uploaded, the workers compress the tiles that were rasterized and the calling thread adds them to the
+//	store, so compressing does not delay the upload. A TileDiskCache is looked in after the store, and gets the same
+//	tiles appended. Tiles read from the disk are added to the store, so they are only read from the disk once.
+//
+class ParallelTileRenderer
+{
+public:
+	ParallelTileRenderer(ITileRasterizer const& rasterizer, int tileSize, int threadCount);
+	void SetUploader(ITileUploader* uploader);
+	void SetTileStore(CompressedTileStore* store);
+	void SetDiskCache(TileDiskCache* diskCache, uint64_t contentHash, uint64_t optionsHash);
+	void SetTileSize(int tileSize);
+	bool DrawTileRange(TileRange const& range, int level);
+	int GetThreadCount() const;
+	ParallelRenderStats GetStats() const;
+	TileWorkerPoolStats GetPoolStats() const;
+
+	//Bands are never thinner than this many lines, thinner ones cost more to hand out than to draw.
+	const static int MINBANDHEIGHT = 16;
+	//Bands handed out per thread, more than one so threads that finish early have something left to steal.
+	const static int BANDSPERTHREAD = 4;
+
+private:
+	//Compressed pixels a tile of the range is restored from instead of being rasterized.
+	struct StoredTile
+	{
+		uint8_t const*  data = nullptr;//nullptr rasterizes the tile
+		size_t          size = 0;
+		bool            fromDisk = false;
+	};
+
+	void FindStoredTiles();
+	TileDiskKey GetDiskKey(TileCoordinate tile) const;
+	static void RasterizeBand(void* context, int index);
+	static void CompressTile(void* context, int index);
+	void StoreTiles();
+
+	//member variables
+	ITileRasterizer const&  m_rasterizer;
+	ITileUploader*          m_uploader = nullptr;
+	CompressedTileStore*    m_store = nullptr;
+	TileDiskCache*          m_diskCache = nullptr;
+	uint64_t                m_contentHash = 0;//Content and options the disk cache keys tiles with
+	uint64_t                m_optionsHash = 0;
+	int                     m_tileSize;
+	TileWorkerPool          m_pool;
+	std::vector<uint32_t>   m_pixels;//Staging image of the range being drawn
+	ParallelRenderStats     m_stats;
+
+	//The range being rasterized, read by the worker threads.
+	TileRange               m_range;
+	int                     m_level = 0;
+	int                     m_bandsPerTile = 1;
+	ptrdiff_t               m_stride = 0;
+	std::vector<StoredTile> m_storedTiles;//For each tile of the range
+	int                     m_restoredCount = 0;
+	int                     m_diskCount = 0;
+	std::vector<int>        m_compressTiles;//Tiles of the range to compress into the store
+	std::vector<std::vector<uint8_t>> m_compressed;//Compressed pixels of those tiles
+};
@@ -0,0 +1,66 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "PatternTileRasterizer.h"
+#include "SoftwareTileCanvas.h"
+
+#include <algorithm>
+
+//
+//  FUNCTION: GetTileColor
+//
+//  PURPOSE: Premultiplied B8G8R8A8 color of a tile. The sample steps a counter through [8, 200) by 16 for every tile it
+//	draws and uses it as the red channel of a half transparent green. Here the step is taken from the position of the
+//	tile, coarse tiles use the first full resolution tile they cover.
+//
+uint32_t PatternTileRasterizer::GetTileColor(TileCoordinate tile, int level)
+{
+	int counter = (int)(((uint32_t)(tile.column << level) + (uint32_t)(tile.row << level)) * 16 % 192) + 8;
+	uint32_t alpha = 128;
+	uint32_t red = (uint32_t)(counter * alpha / 256);
+	uint32_t green = alpha;
+	return alpha << 24 | red << 16 | green << 8;
+}
+
+//
+//  FUNCTION: EnableLabels
+//
+//  PURPOSE: Rasterizes the label glyphs for tiles of the given size, 0 turns the labels off. Must not be called while
+//	tiles are being rasterized.
+//
+void PatternTileRasterizer::EnableLabels(int tileSize)
+{
+	m_labelAtlas.Build(tileSize);
+}
+
+void PatternTileRasterizer::RasterizeTile(TileCoordinate tile, int level, int tileSize, int firstLine, int lineCount, uint32_t* pixels, ptrdiff_t stride) const
+{
+	SoftwareTileCanvas canvas(pixels, stride, 0, firstLine, tileSize, lineCount);
+	float fillSize = (float)std::max(tileSize - BORDERMARGIN, 0);
+	CanvasRect tileRectangle{ 0.0f, 0.0f, fillSize, fillSize };
+	//The same bits as clearing the tile and blending the rectangle over it, with every pixel written once.
+	float size = (float)tileSize;
+	canvas.SetPrimitiveBlend(CanvasBlend::Copy);
+	canvas.FillRectangle(tileRectangle, GetTileColor(tile, level));
+	canvas.FillRectangle(CanvasRect{ fillSize, 0.0f, size, fillSize }, 0);
+	canvas.FillRectangle(CanvasRect{ 0.0f, fillSize, size, size }, 0);
+	canvas.SetPrimitiveBlend(CanvasBlend::SourceOver);
+
+	//Coarse tiles are labelled with the first full resolution tile they cover, as in the sample.
+	if (m_labelAtlas.GetTileSize() == tileSize && tileSize > 0)
+	{
+		uint8_t glyphs[TileLabel::MAXGLYPHCOUNT];
+		int glyphCount = TileLabel::GetGlyphs(tile.row << level, tile.column << level, glyphs);
+		canvas.DrawLabel(m_labelAtlas, glyphs, glyphCount, tileRectangle, LABELCOLOR);
+	}
+}
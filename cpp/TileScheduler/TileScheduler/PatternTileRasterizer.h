@@ -0,0 +1,46 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "ITileRasterizer.h"
+#include "TileGlyphAtlas.h"
+
+//
+//  CLASS: PatternTileRasterizer
+//
+//  PURPOSE: Deterministic software stand in for the content of the Virtual Surfaces sample: every tile is a rectangle of
+//	one shade of green at half alpha, 5 pixels short of the next tile, on a transparent background. The shade comes from
+//	the tile coordinates instead of the order tiles are drawn in, so the output does not depend on the number of threads.
+//	After EnableLabels every tile of that size also gets its "row,column" label, in half transparent gray like the
+//	sample's, blended from a TileGlyphAtlas. Tiles of any other size are drawn without. Everything is drawn with a
+//	SoftwareTileCanvas, the same calls the sample makes to Direct2D.
+//
+class PatternTileRasterizer : public ITileRasterizer
+{
+public:
+	void RasterizeTile(TileCoordinate tile, int level, int tileSize, int firstLine, int lineCount, uint32_t* pixels, ptrdiff_t stride) const override;
+
+	void EnableLabels(int tileSize);
+
+	static uint32_t GetTileColor(TileCoordinate tile, int level);
+
+	//Gap left between a tile and the next one, as in the sample.
+	const static int BORDERMARGIN = 5;
+	//Premultiplied B8G8R8A8 DimGray at half alpha, the color of the sample's labels.
+	const static uint32_t LABELCOLOR = 0x80343434;
+
+private:
+	//member variables
+	TileGlyphAtlas  m_labelAtlas;
+};
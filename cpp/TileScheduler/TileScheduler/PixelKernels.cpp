@@ -0,0 +1,304 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "PixelKernels.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || (defined(__i386__) && defined(__SSE2__))
+#define PIXELKERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+//MSVC compiles AVX2 intrinsics in any function, GCC and Clang only in functions marked for it.
+#define PIXELKERNELS_AVX2_FUNCTION
+#else
+#define PIXELKERNELS_AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define PIXELKERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+//
+//  FUNCTION: BlendOver
+//
+//  PURPOSE: Blends a premultiplied color over a premultiplied pixel. The pixel is scaled by 255 - alpha two channels at
+//	a time, with the division by 255 rounded exactly. This is the reference every kernel set has to match.
+//
+uint32_t PixelKernels::BlendOver(uint32_t pixel, uint32_t color)
+{
+	uint32_t inverseAlpha = 255 - (color >> 24);
+	uint32_t redBlue = (pixel & 0x00FF00FF) * inverseAlpha + 0x00800080;
+	redBlue = ((redBlue + ((redBlue >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+	uint32_t alphaGreen = ((pixel >> 8) & 0x00FF00FF) * inverseAlpha + 0x00800080;
+	alphaGreen = (alphaGreen + ((alphaGreen >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+	return color + (redBlue | alphaGreen);
+}
+
+static void FillScalar(uint32_t* pixels, size_t count, uint32_t color)
+{
+	std::fill_n(pixels, count, color);
+}
+
+static void BlendColorScalar(uint32_t* pixels, size_t count, uint32_t color)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		pixels[i] = PixelKernels::BlendOver(pixels[i], color);
+	}
+}
+
+static void BlendPixelsScalar(uint32_t* pixels, uint32_t const* source, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		pixels[i] = PixelKernels::BlendOver(pixels[i], source[i]);
+	}
+}
+
+static const PixelKernels s_scalarKernels = { "scalar", FillScalar, BlendColorScalar, BlendPixelsScalar };
+
+#if defined(PIXELKERNELS_X86)
+//Scales 16 bit channels by 16 bit factors in [0, 255] and divides by 255, rounded the same way as BlendOver. Products
+//are at most 255 * 255, so the sums below never leave 16 bits.
+static inline __m128i ScaleSse2(__m128i channels, __m128i factors)
+{
+	__m128i product = _mm_add_epi16(_mm_mullo_epi16(channels, factors), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+}
+
+//255 - alpha of every pixel in 16 bit channels, in all four channels of the pixel.
+static inline __m128i InverseAlphaSse2(__m128i channels)
+{
+	__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(channels, 0xFF), 0xFF);
+	return _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+}
+
+static void FillSse2(uint32_t* pixels, size_t count, uint32_t color)
+{
+	__m128i colors = _mm_set1_epi32((int)color);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_si128((__m128i*)(pixels + i), colors);
+	}
+	FillScalar(pixels + i, count - i, color);
+}
+
+static void BlendColorSse2(uint32_t* pixels, size_t count, uint32_t color)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i inverseAlpha = _mm_set1_epi16((short)(255 - (color >> 24)));
+	__m128i colors = _mm_set1_epi32((int)color);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i destination = _mm_loadu_si128((__m128i const*)(pixels + i));
+		__m128i low = ScaleSse2(_mm_unpacklo_epi8(destination, zero), inverseAlpha);
+		__m128i high = ScaleSse2(_mm_unpackhi_epi8(destination, zero), inverseAlpha);
+		//Added as whole pixels, as BlendOver does.
+		_mm_storeu_si128((__m128i*)(pixels + i), _mm_add_epi32(_mm_packus_epi16(low, high), colors));
+	}
+	BlendColorScalar(pixels + i, count - i, color);
+}
+
+static void BlendPixelsSse2(uint32_t* pixels, uint32_t const* source, size_t count)
+{
+	__m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i colors = _mm_loadu_si128((__m128i const*)(source + i));
+		__m128i destination = _mm_loadu_si128((__m128i const*)(pixels + i));
+		__m128i low = ScaleSse2(_mm_unpacklo_epi8(destination, zero), InverseAlphaSse2(_mm_unpacklo_epi8(colors, zero)));
+		__m128i high = ScaleSse2(_mm_unpackhi_epi8(destination, zero), InverseAlphaSse2(_mm_unpackhi_epi8(colors, zero)));
+		_mm_storeu_si128((__m128i*)(pixels + i), _mm_add_epi32(_mm_packus_epi16(low, high), colors));
+	}
+	BlendPixelsScalar(pixels + i, source + i, count - i);
+}
+
+static const PixelKernels s_sse2Kernels = { "sse2", FillSse2, BlendColorSse2, BlendPixelsSse2 };
+
+//The AVX2 kernels are the SSE2 ones on 8 pixels at a time. Unpacking and packing work within each 128 bit half, so the
+//pixels come back in the order they were loaded. The last pixels are left to the SSE2 kernels, after clearing the upper halves of the
+//registers, which the compilers do not always do before a tail call and which makes SSE2 instructions slow.
+PIXELKERNELS_AVX2_FUNCTION static inline __m256i ScaleAvx2(__m256i channels, __m256i factors)
+{
+	__m256i product = _mm256_add_epi16(_mm256_mullo_epi16(channels, factors), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(product, _mm256_srli_epi16(product, 8)), 8);
+}
+
+PIXELKERNELS_AVX2_FUNCTION static inline __m256i InverseAlphaAvx2(__m256i channels)
+{
+	__m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(channels, 0xFF), 0xFF);
+	return _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+}
+
+PIXELKERNELS_AVX2_FUNCTION static void FillAvx2(uint32_t* pixels, size_t count, uint32_t color)
+{
+	__m256i colors = _mm256_set1_epi32((int)color);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_si256((__m256i*)(pixels + i), colors);
+	}
+	_mm256_zeroupper();
+	FillSse2(pixels + i, count - i, color);
+}
+
+PIXELKERNELS_AVX2_FUNCTION static void BlendColorAvx2(uint32_t* pixels, size_t count, uint32_t color)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i inverseAlpha = _mm256_set1_epi16((short)(255 - (color >> 24)));
+	__m256i colors = _mm256_set1_epi32((int)color);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i destination = _mm256_loadu_si256((__m256i const*)(pixels + i));
+		__m256i low = ScaleAvx2(_mm256_unpacklo_epi8(destination, zero), inverseAlpha);
+		__m256i high = ScaleAvx2(_mm256_unpackhi_epi8(destination, zero), inverseAlpha);
+		_mm256_storeu_si256((__m256i*)(pixels + i), _mm256_add_epi32(_mm256_packus_epi16(low, high), colors));
+	}
+	_mm256_zeroupper();
+	BlendColorSse2(pixels + i, count - i, color);
+}
+
+PIXELKERNELS_AVX2_FUNCTION static void BlendPixelsAvx2(uint32_t* pixels, uint32_t const* source, size_t count)
+{
+	__m256i zero = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i colors = _mm256_loadu_si256((__m256i const*)(source + i));
+		__m256i destination = _mm256_loadu_si256((__m256i const*)(pixels + i));
+		__m256i low = ScaleAvx2(_mm256_unpacklo_epi8(destination, zero), InverseAlphaAvx2(_mm256_unpacklo_epi8(colors, zero)));
+		__m256i high = ScaleAvx2(_mm256_unpackhi_epi8(destination, zero), InverseAlphaAvx2(_mm256_unpackhi_epi8(colors, zero)));
+		_mm256_storeu_si256((__m256i*)(pixels + i), _mm256_add_epi32(_mm256_packus_epi16(low, high), colors));
+	}
+	_mm256_zeroupper();
+	BlendPixelsSse2(pixels + i, source + i, count - i);
+}
+
+static const PixelKernels s_avx2Kernels = { "avx2", FillAvx2, BlendColorAvx2, BlendPixelsAvx2 };
+
+//AVX2 instructions, and an operating system that saves the AVX registers.
+static bool HasAvx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	bool avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return avx && (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#if defined(PIXELKERNELS_NEON)
+//Scales 8 channels by factors in [0, 255] and divides by 255, rounded the same way as BlendOver: the rounding shift
+//adds the 128 of BlendOver before the shift by 8 and the rounding narrow adds it after.
+static inline uint8x8_t ScaleNeon(uint8x8_t channels, uint8x8_t factors)
+{
+	uint16x8_t product = vmull_u8(channels, factors);
+	return vraddhn_u16(product, vrshrq_n_u16(product, 8));
+}
+
+static void FillNeon(uint32_t* pixels, size_t count, uint32_t color)
+{
+	uint32x4_t colors = vdupq_n_u32(color);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		vst1q_u32(pixels + i, colors);
+	}
+	FillScalar(pixels + i, count - i, color);
+}
+
+static void BlendColorNeon(uint32_t* pixels, size_t count, uint32_t color)
+{
+	uint8x8_t inverseAlpha = vdup_n_u8((uint8_t)(255 - (color >> 24)));
+	uint32x4_t colors = vdupq_n_u32(color);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		uint8x16_t destination = vreinterpretq_u8_u32(vld1q_u32(pixels + i));
+		uint8x16_t scaled = vcombine_u8(ScaleNeon(vget_low_u8(destination), inverseAlpha), ScaleNeon(vget_high_u8(destination), inverseAlpha));
+		//Added as whole pixels, as BlendOver does.
+		vst1q_u32(pixels + i, vaddq_u32(vreinterpretq_u32_u8(scaled), colors));
+	}
+	BlendColorScalar(pixels + i, count - i, color);
+}
+
+static void BlendPixelsNeon(uint32_t* pixels, uint32_t const* source, size_t count)
+{
+	static const uint8_t alphaIndices[16] = { 3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15 };
+	uint8x16_t indices = vld1q_u8(alphaIndices);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		uint32x4_t colors = vld1q_u32(source + i);
+		uint8x16_t inverseAlpha = vsubq_u8(vdupq_n_u8(255), vqtbl1q_u8(vreinterpretq_u8_u32(colors), indices));
+		uint8x16_t destination = vreinterpretq_u8_u32(vld1q_u32(pixels + i));
+		uint8x16_t scaled = vcombine_u8(ScaleNeon(vget_low_u8(destination), vget_low_u8(inverseAlpha)), ScaleNeon(vget_high_u8(destination), vget_high_u8(inverseAlpha)));
+		vst1q_u32(pixels + i, vaddq_u32(vreinterpretq_u32_u8(scaled), colors));
+	}
+	BlendPixelsScalar(pixels + i, source + i, count - i);
+}
+
+static const PixelKernels s_neonKernels = { "neon", FillNeon, BlendColorNeon, BlendPixelsNeon };
+#endif
+
+//
+//  FUNCTION: GetSupported
+//
+//  PURPOSE: The kernel sets this CPU runs, scalar first and the best last, nullptr past the end. For benchmarks and for
+//	checking the sets against each other.
+//
+PixelKernels const* PixelKernels::GetSupported(int index)
+{
+	PixelKernels const* supported[3] = { &s_scalarKernels };
+	int count = 1;
+#if defined(PIXELKERNELS_X86)
+	supported[count++] = &s_sse2Kernels;
+	if (HasAvx2())
+	{
+		supported[count++] = &s_avx2Kernels;
+	}
+#elif defined(PIXELKERNELS_NEON)
+	supported[count++] = &s_neonKernels;
+#endif
+	return index >= 0 && index < count ? supported[index] : nullptr;
+}
+
+//The best kernel set for this CPU, looked up once.
+PixelKernels const& PixelKernels::Get()
+{
+	static PixelKernels const* best = []()
+	{
+		PixelKernels const* kernels = GetSupported(0);
+		for (int i = 1; GetSupported(i) != nullptr; i++)
+		{
+			kernels = GetSupported(i);
+		}
+		return kernels;
+	}();
+	return *best;
+}
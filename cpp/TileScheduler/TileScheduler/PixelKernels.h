@@ -0,0 +1,37 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//
+//  STRUCT: PixelKernels
+//
+//  PURPOSE: The inner loops of the SoftwareTileCanvas, over one line of premultiplied B8G8R8A8 pixels: filling with a
+//	color, blending a color over the pixels and blending pixels over the pixels. There is a set of them for every
+//	instruction set the build supports, scalar, SSE2, AVX2 and NEON, and Get picks the best one the CPU runs the first
+//	time it is called. Every set computes the same bits as BlendOver, so which one runs never shows in the tiles.
+//
+struct PixelKernels
+{
+	static PixelKernels const& Get();
+	static PixelKernels const* GetSupported(int index);
+	static uint32_t BlendOver(uint32_t pixel, uint32_t color);
+
+	char const* name;
+	void (*fill)(uint32_t* pixels, size_t count, uint32_t color);
+	void (*blendColor)(uint32_t* pixels, size_t count, uint32_t color);
+	void (*blendPixels)(uint32_t* pixels, uint32_t const* source, size_t count);
+};
@@ -0,0 +1,247 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "SoftwareTileCanvas.h"
+
+#include <algorithm>
+#include <cmath>
+
+//Canvas coordinates are clamped to this, so snapped edges and the sums of them never overflow an int.
+static const float MAXCOORDINATE = (float)(1 << 30);
+
+//The pixels are (left, top) to (left + width, top + height) of the canvas, pixels points at (left, top).
+SoftwareTileCanvas::SoftwareTileCanvas(uint32_t* pixels, ptrdiff_t stride, int left, int top, int width, int height) :
+	m_pixels(pixels),
+	m_stride(stride),
+	m_bounds{ left, top, left + std::max(width, 0), top + std::max(height, 0) },
+	m_kernels(&PixelKernels::Get())
+{
+	m_clips[0] = m_bounds;
+}
+
+//
+//  FUNCTION: GetPremultipliedColor
+//
+//  PURPOSE: Converts a straight alpha color with channels in [0, 1], as a D2D1_COLOR_F, to a premultiplied B8G8R8A8
+//	pixel. Every channel is first rounded to 8 bits, then scaled by the alpha with the division by 255 rounded.
+//
+uint32_t SoftwareTileCanvas::GetPremultipliedColor(float red, float green, float blue, float alpha)
+{
+	auto quantize = [](float channel) -> uint32_t
+	{
+		//Written so that NaN comes out as 0.
+		return channel > 0.0f ? (uint32_t)(std::min(channel, 1.0f) * 255.0f + 0.5f) : 0u;
+	};
+	uint32_t alpha8 = quantize(alpha);
+	auto premultiply = [alpha8](uint32_t channel)
+	{
+		return (channel * alpha8 + 127) / 255;
+	};
+	return alpha8 << 24 | premultiply(quantize(red)) << 16 | premultiply(quantize(green)) << 8 | premultiply(quantize(blue));
+}
+
+//
+//  FUNCTION: Clear
+//
+//  PURPOSE: Sets every pixel inside the clip to the color, whatever the primitive blend, as ID2D1RenderTarget::Clear.
+//
+void SoftwareTileCanvas::Clear(uint32_t color)
+{
+	FillPixels(GetClip(), color, CanvasBlend::Copy);
+}
+
+void SoftwareTileCanvas::FillRectangle(CanvasRect const& rect, uint32_t color)
+{
+	FillPixels(Intersect(GetClip(), Snap(rect)), color, m_blend);
+}
+
+//
+//  FUNCTION: DrawRectangle
+//
+//  PURPOSE: Draws the outline of a rectangle. As with Direct2D the stroke is centered on the edges, half of it inside
+//	the rectangle and half outside. The outline is filled as four bands that do not overlap, so the corners are not
+//	blended twice.
+//
+void SoftwareTileCanvas::DrawRectangle(CanvasRect const& rect, uint32_t color, float strokeWidth)
+{
+	if (!(strokeWidth > 0.0f))
+	{
+		return;
+	}
+	float half = strokeWidth / 2;
+	PixelRect outer = Snap(CanvasRect{ rect.left - half, rect.top - half, rect.right + half, rect.bottom + half });
+	PixelRect inner = Intersect(outer, Snap(CanvasRect{ rect.left + half, rect.top + half, rect.right - half, rect.bottom - half }));
+	PixelRect clip = GetClip();
+	if (inner.left == inner.right || inner.top == inner.bottom)
+	{
+		FillPixels(Intersect(clip, outer), color, m_blend);
+		return;
+	}
+	FillPixels(Intersect(clip, PixelRect{ outer.left, outer.top, outer.right, inner.top }), color, m_blend);
+	FillPixels(Intersect(clip, PixelRect{ outer.left, inner.top, inner.left, inner.bottom }), color, m_blend);
+	FillPixels(Intersect(clip, PixelRect{ inner.right, inner.top, outer.right, inner.bottom }), color, m_blend);
+	FillPixels(Intersect(clip, PixelRect{ outer.left, inner.bottom, outer.right, outer.bottom }), color, m_blend);
+}
+
+//
+//  FUNCTION: DrawLabel
+//
+//  PURPOSE: Draws a TileLabel centered in the box with the glyphs of the atlas, the software counterpart of the sample's
+//	centered DrawText. Nothing is drawn outside the box. An atlas that was not built draws nothing.
+//
+void SoftwareTileCanvas::DrawLabel(TileGlyphAtlas const& atlas, uint8_t const* glyphs, int glyphCount, CanvasRect const& box, uint32_t color)
+{
+	if (atlas.GetTileSize() == 0)
+	{
+		return;
+	}
+	PixelRect boxPixels = Snap(box);
+	PixelRect clip = Intersect(GetClip(), boxPixels);
+	int height = atlas.GetLabelHeight();
+	int x = boxPixels.left + (boxPixels.right - boxPixels.left - atlas.GetLabelWidth(glyphs, glyphCount)) / 2;
+	int y = boxPixels.top + (boxPixels.bottom - boxPixels.top - height) / 2;
+	int top = std::max(y, clip.top);
+	int bottom = std::min(y + height, clip.bottom);
+	if (top >= bottom)
+	{
+		return;
+	}
+
+	for (int i = 0; i < glyphCount; i++)
+	{
+		int width = atlas.GetGlyphWidth(glyphs[i]);
+		int left = std::max(x, clip.left);
+		int right = std::min(x + width, clip.right);
+		for (int line = top; line < bottom && left < right; line++)
+		{
+			uint8_t const* coverage = atlas.GetGlyphLine(glyphs[i], line - y) + (left - x);
+			uint32_t* destination = GetPixel(left, line);
+			for (int column = 0; column < right - left; column++)
+			{
+				if (coverage[column] != 0)
+				{
+					destination[column] = m_blend == CanvasBlend::Copy ? color : PixelKernels::BlendOver(destination[column], color);
+				}
+			}
+		}
+		x += width + atlas.GetGlyphSpacing();
+	}
+}
+
+//
+//  FUNCTION: DrawBitmap
+//
+//  PURPOSE: Draws premultiplied B8G8R8A8 pixels with their top left corner at (x, y), one pixel per pixel, as DrawBitmap
+//	with nearest neighbor interpolation and no scaling. With the Copy primitive blend they replace the pixels under them.
+//
+void SoftwareTileCanvas::DrawBitmap(uint32_t const* pixels, ptrdiff_t stride, int width, int height, int x, int y)
+{
+	PixelRect rect = Intersect(GetClip(), PixelRect{ x, y, x + std::max(width, 0), y + std::max(height, 0) });
+	for (int line = rect.top; line < rect.bottom; line++)
+	{
+		uint32_t const* source = pixels + (ptrdiff_t)(line - y) * stride + (rect.left - x);
+		uint32_t* destination = GetPixel(rect.left, line);
+		if (m_blend == CanvasBlend::Copy)
+		{
+			std::copy_n(source, rect.right - rect.left, destination);
+		}
+		else
+		{
+			m_kernels->blendPixels(destination, source, (size_t)(rect.right - rect.left));
+		}
+	}
+}
+
+//
+//  FUNCTION: PushAxisAlignedClip
+//
+//  PURPOSE: Restricts drawing to the pixels whose centers are inside the rectangle, and inside the clips pushed before,
+//	until the matching PopAxisAlignedClip. As with Direct2D the clips nest.
+//
+void SoftwareTileCanvas::PushAxisAlignedClip(CanvasRect const& rect)
+{
+	m_clipDepth++;
+	if (m_clipDepth <= MAXCLIPDEPTH)
+	{
+		m_clips[m_clipDepth] = Intersect(m_clips[m_clipDepth - 1], Snap(rect));
+	}
+}
+
+void SoftwareTileCanvas::PopAxisAlignedClip()
+{
+	if (m_clipDepth > 0)
+	{
+		m_clipDepth--;
+	}
+}
+
+void SoftwareTileCanvas::SetPrimitiveBlend(CanvasBlend blend)
+{
+	m_blend = blend;
+}
+
+//Draws with another set of kernels than the best one for the CPU, to compare them.
+void SoftwareTileCanvas::SetKernels(PixelKernels const& kernels)
+{
+	m_kernels = &kernels;
+}
+
+SoftwareTileCanvas::PixelRect SoftwareTileCanvas::GetClip() const
+{
+	return m_clipDepth <= MAXCLIPDEPTH ? m_clips[m_clipDepth] : PixelRect{ m_bounds.left, m_bounds.top, m_bounds.left, m_bounds.top };
+}
+
+//
+//  FUNCTION: Snap
+//
+//  PURPOSE: The pixels whose centers are inside a rectangle, the aliased rasterization rule of Direct2D. Edges that are
+//	whole numbers are kept as they are.
+//
+SoftwareTileCanvas::PixelRect SoftwareTileCanvas::Snap(CanvasRect const& rect)
+{
+	auto snapEdge = [](float edge)
+	{
+		//Written so that NaN comes out as -MAXCOORDINATE.
+		edge = edge > -MAXCOORDINATE ? std::min(edge, MAXCOORDINATE) : -MAXCOORDINATE;
+		return (int)std::ceil(edge - 0.5f);
+	};
+	return PixelRect{ snapEdge(rect.left), snapEdge(rect.top), snapEdge(rect.right), snapEdge(rect.bottom) };
+}
+
+//The rectangle both cover. An empty result keeps right >= left and bottom >= top.
+SoftwareTileCanvas::PixelRect SoftwareTileCanvas::Intersect(PixelRect const& a, PixelRect const& b)
+{
+	PixelRect rect{ std::max(a.left, b.left), std::max(a.top, b.top), std::min(a.right, b.right), std::min(a.bottom, b.bottom) };
+	rect.right = std::max(rect.right, rect.left);
+	rect.bottom = std::max(rect.bottom, rect.top);
+	return rect;
+}
+
+uint32_t* SoftwareTileCanvas::GetPixel(int x, int y) const
+{
+	return m_pixels + (ptrdiff_t)(y - m_bounds.top) * m_stride + (x - m_bounds.left);
+}
+
+void SoftwareTileCanvas::FillPixels(PixelRect const& rect, uint32_t color, CanvasBlend blend)
+{
+	if (blend == CanvasBlend::SourceOver && color == 0)
+	{
+		return;
+	}
+	size_t width = (size_t)(rect.right - rect.left);
+	auto kernel = blend == CanvasBlend::Copy || color >> 24 == 255 ? m_kernels->fill : m_kernels->blendColor;
+	for (int line = rect.top; line < rect.bottom; line++)
+	{
+		kernel(GetPixel(rect.left, line), width, color);
+	}
+}
@@ -0,0 +1,92 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "PixelKernels.h"
+#include "TileGlyphAtlas.h"
+
+#include <cstddef>
+#include <cstdint>
+
+//A rectangle in canvas pixels, as the D2D1_RECT_F the Direct2D tile drawing passes around.
+struct CanvasRect
+{
+	float left;
+	float top;
+	float right;
+	float bottom;
+};
+
+//How the canvas combines what it draws with the pixels already there, as D2D1_PRIMITIVE_BLEND.
+enum class CanvasBlend
+{
+	SourceOver,
+	Copy
+};
+
+//
+//  CLASS: SoftwareTileCanvas
+//
+//  PURPOSE: The handful of Direct2D operations the tile samples draw with, done on the CPU into premultiplied B8G8R8A8
+//	pixels: Clear, FillRectangle, DrawRectangle, axis aligned clips, labels from a TileGlyphAtlas and bitmaps. Rectangles
+//	are aliased, a pixel is drawn when its center is inside, and every blend is integer math with exact rounding, so
+//	the same calls give the same bits on every machine, compiler and thread. The canvas draws into a window of lines of
+//	a larger image, so a tile drawn band by band comes out the same as drawn whole. Lines are filled and blended by the
+//	PixelKernels for the CPU. It owns no memory and does not allocate.
+//
+class SoftwareTileCanvas
+{
+public:
+	SoftwareTileCanvas(uint32_t* pixels, ptrdiff_t stride, int left, int top, int width, int height);
+
+	void Clear(uint32_t color);
+	void FillRectangle(CanvasRect const& rect, uint32_t color);
+	void DrawRectangle(CanvasRect const& rect, uint32_t color, float strokeWidth);
+	void DrawLabel(TileGlyphAtlas const& atlas, uint8_t const* glyphs, int glyphCount, CanvasRect const& box, uint32_t color);
+	void DrawBitmap(uint32_t const* pixels, ptrdiff_t stride, int width, int height, int x, int y);
+	void PushAxisAlignedClip(CanvasRect const& rect);
+	void PopAxisAlignedClip();
+	void SetPrimitiveBlend(CanvasBlend blend);
+	void SetKernels(PixelKernels const& kernels);
+
+	static uint32_t GetPremultipliedColor(float red, float green, float blue, float alpha);
+
+	//Clips nested deeper than this clip everything away until they are popped.
+	const static int MAXCLIPDEPTH = 8;
+
+private:
+	//A rectangle of whole pixels, right and bottom excluded.
+	struct PixelRect
+	{
+		int left;
+		int top;
+		int right;
+		int bottom;
+	};
+
+	PixelRect GetClip() const;
+	static PixelRect Snap(CanvasRect const& rect);
+	static PixelRect Intersect(PixelRect const& a, PixelRect const& b);
+	uint32_t* GetPixel(int x, int y) const;
+	void FillPixels(PixelRect const& rect, uint32_t color, CanvasBlend blend);
+
+	//member variables
+	uint32_t*       m_pixels;//Pixel (m_bounds.left, m_bounds.top)
+	ptrdiff_t       m_stride;
+	PixelRect       m_bounds;//Part of the canvas the pixels cover
+	PixelRect       m_clips[MAXCLIPDEPTH + 1];//m_clips[n] is the clip with n clips pushed, m_clips[0] is m_bounds
+	int             m_clipDepth = 0;
+	CanvasBlend     m_blend = CanvasBlend::SourceOver;
+	PixelKernels const* m_kernels;//The best for the CPU, unless SetKernels picked others
+};
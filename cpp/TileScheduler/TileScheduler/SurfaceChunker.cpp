@@ -0,0 +1,59 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "SurfaceChunker.h"
+#include "SurfaceFrame.h"
+
+#include <algorithm>
+
+//
+//  FUNCTION: Split
+//
+//  PURPOSE: Fills chunks with the update rects of range, row by row, clipped to the size of the surface. The tiles of a
+//	chunk are worked out from its edges, so nothing is enumerated here and chunks does not allocate once it has grown to
+//	the largest split seen.
+//
+void SurfaceChunker::Split(TileRange const& range, int tileSize, int surfaceSize, std::vector<SurfaceChunk>& chunks)
+{
+	chunks.clear();
+	if (range.IsEmpty())
+	{
+		return;
+	}
+
+	//making sure the update rect doesnt go past the maximum size of the surface. The edges are worked out in 64 bits, tiles
+	//past the end of a large surface would overflow an int before the clamp.
+	int left = (int)std::min(SurfaceFrame::ToPixel(range.startColumn, tileSize), (int64_t)surfaceSize);
+	int top = (int)std::min(SurfaceFrame::ToPixel(range.startRow, tileSize), (int64_t)surfaceSize);
+	int right = (int)std::min(SurfaceFrame::ToPixel(range.startColumn + range.numColumns, tileSize), (int64_t)surfaceSize);
+	int bottom = (int)std::min(SurfaceFrame::ToPixel(range.startRow + range.numRows, tileSize), (int64_t)surfaceSize);
+
+	for (int y = top; y < bottom; y += MAXCHUNKSIZE)
+	{
+		for (int x = left; x < right; x += MAXCHUNKSIZE)
+		{
+			SurfaceChunk chunk;
+			chunk.left = x;
+			chunk.top = y;
+			chunk.right = std::min(x + MAXCHUNKSIZE, right);
+			chunk.bottom = std::min(y + MAXCHUNKSIZE, bottom);
+
+			int startColumn = chunk.left / tileSize;
+			int startRow = chunk.top / tileSize;
+			int endColumn = (chunk.right - 1) / tileSize;
+			int endRow = (chunk.bottom - 1) / tileSize;
+			chunk.tiles = TileRange{ startColumn, startRow, endColumn - startColumn + 1, endRow - startRow + 1 };
+			chunks.push_back(chunk);
+		}
+	}
+}
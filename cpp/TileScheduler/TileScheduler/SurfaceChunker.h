@@ -0,0 +1,50 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileRange.h"
+
+#include <vector>
+
+//
+//  STRUCT: SurfaceChunk
+//
+//  PURPOSE: One BeginDraw/EndDraw session of a tile range, in surface pixels, with the tiles that intersect it.
+//
+struct SurfaceChunk
+{
+	int       left = 0;
+	int       top = 0;
+	int       right = 0;
+	int       bottom = 0;
+	TileRange tiles;
+};
+
+//
+//  CLASS: SurfaceChunker
+//
+//  PURPOSE: A surface can not be updated in a rect larger than the maximum texture size of the hardware, so a large tile
+//	range has to be drawn in several sessions. SurfaceChunker splits the pixels of a range into such rects and buckets the
+//	tiles by the rect they intersect, so each session only goes through its own tiles instead of the whole range. A tile
+//	that straddles two rects is in both, each session draws its own part of it.
+//
+class SurfaceChunker
+{
+public:
+	static void Split(TileRange const& range, int tileSize, int surfaceSize, std::vector<SurfaceChunk>& chunks);
+
+	//Largest update rect, D3D_FL9_1_REQ_TEXTURE2D_U_OR_V_DIMENSION minus a small buffer. 2048X2048 is the lowest max
+	//texture size for relevant hardware.
+	const static int MAXCHUNKSIZE = 2048 - 3;
+};
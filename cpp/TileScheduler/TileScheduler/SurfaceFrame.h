@@ -0,0 +1,120 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+//
+//  CLASS: SurfaceFrame
+//
+//  PURPOSE: Turns the floating point positions of the caller into whole surface pixels, in 64 bit integers. A float has
+//	24 bits of mantissa, so near the 2^24 pixel edge of the largest virtual surface it only holds a position to a pixel or
+//	two, and every division or addition rounds it again, which shows up as tiles picked one off from their neighbours.
+//	Positions are therefore taken relative to an origin held here in 64 bits. They are floored to pixels once, the origin
+//	is added in integers, and everything from there on, tile columns and rows or the pixel rect of a tile, is integer math.
+//	Callers keep their positions small by rebasing. Once a position is further than REBASEDISTANCE from the origin, Rebase
+//	moves the origin onto it and returns the shift, which the caller takes off its own positions. Within REBASEDISTANCE a
+//	float still holds 1/8 of a pixel.
+//
+class SurfaceFrame
+{
+public:
+	void SetOrigin(int64_t originX, int64_t originY)
+	{
+		m_originX = originX;
+		m_originY = originY;
+	}
+
+	int64_t GetOriginX() const
+	{
+		return m_originX;
+	}
+
+	int64_t GetOriginY() const
+	{
+		return m_originY;
+	}
+
+	//Position relative to the origin, as a surface position. Exact as long as it is below 2^53 pixels.
+	double ToSurfaceX(double localX) const
+	{
+		return (double)m_originX + localX;
+	}
+
+	double ToSurfaceY(double localY) const
+	{
+		return (double)m_originY + localY;
+	}
+
+	//Surface pixels under the two edges of the span from localStart to localStart + length, along the x or y axis.
+	void GetPixelSpanX(double localStart, double length, int64_t& first, int64_t& last) const
+	{
+		GetPixelSpan(m_originX, localStart, length, first, last);
+	}
+
+	void GetPixelSpanY(double localStart, double length, int64_t& first, int64_t& last) const
+	{
+		GetPixelSpan(m_originY, localStart, length, first, last);
+	}
+
+	//
+	//  FUNCTION: Rebase
+	//
+	//  PURPOSE: Moves the origin onto the given position once it is further than REBASEDISTANCE from it. Returns true when
+	//	it did, with the whole number of pixels the origin moved by, which the caller subtracts from its positions.
+	//
+	bool Rebase(double localX, double localY, int64_t& shiftX, int64_t& shiftY)
+	{
+		shiftX = 0;
+		shiftY = 0;
+		if (std::fabs(localX) <= (double)REBASEDISTANCE && std::fabs(localY) <= (double)REBASEDISTANCE)
+		{
+			return false;
+		}
+		shiftX = (int64_t)std::floor(localX);
+		shiftY = (int64_t)std::floor(localY);
+		m_originX += shiftX;
+		m_originY += shiftY;
+		return true;
+	}
+
+	//Tile holding a surface pixel. Rounds down for negative pixels too, and saturates at the range of a tile index.
+	static int ToTile(int64_t pixel, int tileSize)
+	{
+		int64_t tile = pixel >= 0 ? pixel / tileSize : -((-pixel + tileSize - 1) / tileSize);
+		return tile > INT_MAX ? INT_MAX : tile < INT_MIN ? INT_MIN : (int)tile;
+	}
+
+	//First surface pixel of a tile.
+	static int64_t ToPixel(int tile, int tileSize)
+	{
+		return (int64_t)tile * tileSize;
+	}
+
+	//Distance from the origin past which Rebase moves it. Floats hold 1/8 of a pixel up to here.
+	const static int64_t REBASEDISTANCE = 1 << 20;
+
+private:
+	static void GetPixelSpan(int64_t origin, double localStart, double length, int64_t& first, int64_t& last)
+	{
+		first = origin + (int64_t)std::floor(localStart);
+		last = origin + (int64_t)std::floor(localStart + (length > 0.0 ? length : 0.0));
+	}
+
+	//member variables
+	int64_t     m_originX = 0;
+	int64_t     m_originY = 0;
+};
@@ -0,0 +1,199 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileCodec.h"
+
+#include <cstring>
+
+//Token kinds, in the low two bits of the varint that starts every token. The rest of the varint is the pixel count.
+enum TokenKind : uint32_t
+{
+	Run = 0,//One pixel value follows, repeated count times
+	Literal = 1,//count pixel values follow
+	Above = 2//count pixels are the same as on the line above, nothing follows
+};
+
+static void AppendVarint(std::vector<uint8_t>& data, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		data.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	data.push_back((uint8_t)value);
+}
+
+static bool ReadVarint(uint8_t const*& data, uint8_t const* end, uint32_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if (data == end)
+		{
+			return false;
+		}
+		uint8_t byte = *data++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void AppendToken(std::vector<uint8_t>& data, TokenKind kind, int count, uint32_t const* pixels)
+{
+	AppendVarint(data, (uint32_t)count << 2 | kind);
+	int pixelCount = kind == Run ? 1 : kind == Literal ? count : 0;
+	size_t offset = data.size();
+	data.resize(offset + (size_t)pixelCount * sizeof(uint32_t));
+	if (pixelCount > 0)
+	{
+		memcpy(data.data() + offset, pixels, (size_t)pixelCount * sizeof(uint32_t));
+	}
+}
+
+//
+//  FUNCTION: Encode
+//
+//  PURPOSE: Replaces data with the compressed form of a width by height image. Each pixel goes in the longest of a run
+//	and a copy from above that starts on it, literal pixels gather until one of those is at least MINRUN long.
+//
+void TileCodec::Encode(uint32_t const* pixels, ptrdiff_t stride, int width, int height, std::vector<uint8_t>& data)
+{
+	data.clear();
+	for (int y = 0; y < height; y++)
+	{
+		uint32_t const* line = pixels + y * stride;
+		uint32_t const* above = y > 0 ? line - stride : nullptr;
+		if (above != nullptr && memcmp(line, above, (size_t)width * sizeof(uint32_t)) == 0)
+		{
+			AppendToken(data, Above, width, nullptr);
+			continue;
+		}
+
+		int literalStart = 0;
+		int x = 0;
+		while (x < width)
+		{
+			int runEnd = x + 1;
+			while (runEnd < width && line[runEnd] == line[x])
+			{
+				runEnd++;
+			}
+			int aboveEnd = x;
+			if (above != nullptr)
+			{
+				while (aboveEnd < width && line[aboveEnd] == above[aboveEnd])
+				{
+					aboveEnd++;
+				}
+			}
+
+			int runLength = runEnd - x;
+			int aboveLength = aboveEnd - x;
+			if (runLength < MINRUN && aboveLength < MINRUN)
+			{
+				x++;
+				continue;
+			}
+			if (literalStart < x)
+			{
+				AppendToken(data, Literal, x - literalStart, line + literalStart);
+			}
+			if (aboveLength >= runLength)
+			{
+				AppendToken(data, Above, aboveLength, nullptr);
+				x = aboveEnd;
+			}
+			else
+			{
+				AppendToken(data, Run, runLength, line + x);
+				x = runEnd;
+			}
+			literalStart = x;
+		}
+		if (literalStart < width)
+		{
+			AppendToken(data, Literal, width - literalStart, line + literalStart);
+		}
+	}
+}
+
+//
+//  FUNCTION: Decode
+//
+//  PURPOSE: Writes the image Encode compressed into data. Returns false, with the image partly written, when the data does
+//	not decode to exactly width by height pixels.
+//
+bool TileCodec::Decode(uint8_t const* data, size_t size, int width, int height, uint32_t* pixels, ptrdiff_t stride)
+{
+	uint8_t const* end = data + size;
+	for (int y = 0; y < height; y++)
+	{
+		uint32_t* line = pixels + y * stride;
+		int x = 0;
+		while (x < width)
+		{
+			uint32_t token;
+			if (!ReadVarint(data, end, token))
+			{
+				return false;
+			}
+			uint32_t count = token >> 2;
+			if (count == 0 || count > (uint32_t)(width - x))
+			{
+				return false;
+			}
+
+			switch (token & 3)
+			{
+			case Run:
+			{
+				if (end - data < (ptrdiff_t)sizeof(uint32_t))
+				{
+					return false;
+				}
+				uint32_t value;
+				memcpy(&value, data, sizeof(value));
+				data += sizeof(value);
+				for (uint32_t i = 0; i < count; i++)
+				{
+					line[x + i] = value;
+				}
+				break;
+			}
+			case Literal:
+				if ((size_t)(end - data) < count * sizeof(uint32_t))
+				{
+					return false;
+				}
+				memcpy(line + x, data, count * sizeof(uint32_t));
+				data += count * sizeof(uint32_t);
+				break;
+			case Above:
+				if (y == 0)
+				{
+					return false;
+				}
+				memcpy(line + x, line - stride + x, count * sizeof(uint32_t));
+				break;
+			default:
+				return false;
+			}
+			x += (int)count;
+		}
+	}
+	return data == end;
+}
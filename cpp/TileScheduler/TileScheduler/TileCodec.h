@@ -0,0 +1,37 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+//  CLASS: TileCodec
+//
+//  PURPOSE: Fast lossless compression for rasterized tiles. Every line is coded on its own as a sequence of tokens: a run
+//	of one pixel value, a copy of the same pixels on the line above, or literal pixels. Flat fills and the lines a fill
+//	repeats down a tile take a couple of bytes each, so synthetic content shrinks by orders of magnitude, while images
+//	with noise in every pixel come out about the size they went in. Decode checks every token against the data and the
+//	tile, so damaged data is rejected instead of writing outside the tile.
+//
+class TileCodec
+{
+public:
+	static void Encode(uint32_t const* pixels, ptrdiff_t stride, int width, int height, std::vector<uint8_t>& data);
+	static bool Decode(uint8_t const* data, size_t size, int width, int height, uint32_t* pixels, ptrdiff_t stride);
+
+	//Shortest run or copy from above that is worth a token of its own inside a stretch of literal pixels.
+	const static int MINRUN = 3;
+};
@@ -0,0 +1,420 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileDiskCache.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Start of the file, followed by the records.
+struct FileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t reserved;
+};
+
+//Start of every record, followed by dataSize bytes of data and padding to the next multiple of 8.
+struct RecordHeader
+{
+	uint32_t    magic;
+	uint32_t    dataSize;
+	TileDiskKey key;
+	uint32_t    dataChecksum;
+	uint32_t    headerChecksum;//Of the bytes above
+};
+
+static const uint32_t FILEMAGIC = 0x434C4954;//"TILC"
+static const uint32_t RECORDMAGIC = 0x43455254;//"TREC"
+
+//Checksum of the records, a multiply and rotate over 8 bytes at a time, fast enough to check tiles as they are read.
+static uint32_t Checksum(uint8_t const* data, size_t size)
+{
+	uint64_t hash = 0x9E3779B97F4A7C15ull ^ size;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 29;
+	}
+	for (; i < size; i++)
+	{
+		hash = (hash ^ data[i]) * 0x100000001B3ull;
+	}
+	hash ^= hash >> 32;
+	return (uint32_t)hash;
+}
+
+static uint64_t RecordSize(uint32_t dataSize)
+{
+	return (sizeof(RecordHeader) + (uint64_t)dataSize + 7) & ~(uint64_t)7;
+}
+
+size_t TileDiskCache::KeyHash::operator()(TileDiskKey const& key) const
+{
+	uint64_t hash = key.content * 0x9E3779B97F4A7C15ull ^ key.options;
+	hash = (hash ^ ((uint64_t)(uint32_t)key.column << 32 | (uint32_t)key.row)) * 0xFF51AFD7ED558CCDull;
+	hash = (hash ^ ((uint64_t)(uint32_t)key.level << 32 | (uint32_t)key.tileSize)) * 0xC4CEB9FE1A85EC53ull;
+	return (size_t)(hash ^ (hash >> 32));
+}
+
+TileDiskCache::~TileDiskCache()
+{
+	Close();
+}
+
+//
+//  FUNCTION: Open
+//
+//  PURPOSE: Opens the cache file, creating it if needed. The records are not read until the first lookup. Returns false
+//	when the file cannot be opened, the cache then finds nothing and stores nothing.
+//
+bool TileDiskCache::Open(std::filesystem::path const& path)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	m_file = (intptr_t)file;
+	LARGE_INTEGER fileSize{};
+	GetFileSizeEx(file, &fileSize);
+	uint64_t size = (uint64_t)fileSize.QuadPart;
+#else
+	int file = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (file < 0)
+	{
+		return false;
+	}
+	m_file = file;
+	if (flock(file, LOCK_EX | LOCK_NB) != 0)
+	{
+		Close();
+		return false;
+	}
+	struct stat status {};
+	fstat(file, &status);
+	uint64_t size = (uint64_t)status.st_size;
+#endif
+
+	//A new file, or one of another version, is emptied and starts over with a header of this version.
+	FileHeader header{};
+	bool valid = size >= sizeof(header);
+	if (valid)
+	{
+		valid = Map(size);
+		if (valid)
+		{
+			memcpy(&header, m_view, sizeof(header));
+			valid = header.magic == FILEMAGIC && header.version == VERSION;
+		}
+	}
+	if (!valid)
+	{
+		Unmap();
+#ifdef _WIN32
+		LARGE_INTEGER start{};
+		SetFilePointerEx(file, start, nullptr, FILE_BEGIN);
+		SetEndOfFile(file);
+#else
+		if (ftruncate(file, 0) != 0)
+		{
+			Close();
+			return false;
+		}
+#endif
+		header = FileHeader{ FILEMAGIC, VERSION, 0 };
+		if (!Write(0, &header, sizeof(header)) || !Map(sizeof(header)))
+		{
+			Close();
+			return false;
+		}
+		size = sizeof(header);
+	}
+	m_end = size;
+	m_stats = TileDiskCacheStats{};
+	return true;
+}
+
+void TileDiskCache::Close()
+{
+	Unmap();
+	if (m_file != -1)
+	{
+#ifdef _WIN32
+		CloseHandle((HANDLE)m_file);
+#else
+		close((int)m_file);
+#endif
+		m_file = -1;
+	}
+	m_index.clear();
+	m_indexLoaded = false;
+	m_end = 0;
+}
+
+bool TileDiskCache::IsOpen() const
+{
+	return m_file != -1;
+}
+
+//
+//  FUNCTION: LoadIndex
+//
+//  PURPOSE: Walks the record headers from the start of the file and indexes every record up to the first one that is
+//	torn or not a record, which is where the next append goes. Only the headers are read, the data is checked on lookup.
+//
+void TileDiskCache::LoadIndex()
+{
+	auto start = std::chrono::steady_clock::now();
+	m_indexLoaded = true;
+	uint64_t offset = sizeof(FileHeader);
+	while (offset + sizeof(RecordHeader) <= m_viewSize)
+	{
+		RecordHeader header;
+		memcpy(&header, m_view + offset, sizeof(header));
+		if (header.magic != RECORDMAGIC ||
+			header.headerChecksum != Checksum((uint8_t const*)&header, offsetof(RecordHeader, headerChecksum)) ||
+			offset + RecordSize(header.dataSize) > m_viewSize)
+		{
+			break;
+		}
+		m_index[header.key] = IndexEntry{ offset, false };
+		m_stats.indexedRecords++;
+		offset += RecordSize(header.dataSize);
+	}
+	if (offset < m_viewSize)
+	{
+		m_stats.damagedRecords++;
+	}
+	m_end = offset;
+	m_stats.fileBytes = offset;
+	m_stats.indexMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//
+//  FUNCTION: Refresh
+//
+//  PURPOSE: Maps the records appended since the file was last mapped, so Find can return them. Pointers returned by Find
+//	before are no longer valid afterwards.
+//
+void TileDiskCache::Refresh()
+{
+	if (IsOpen() && m_end > m_viewSize)
+	{
+		Unmap();
+		Map(m_end);
+	}
+}
+
+//
+//  FUNCTION: Find
+//
+//  PURPOSE: Points data at the compressed pixels of the tile with the given key, in the mapped file. Returns false when
+//	the file does not have the tile, or its data is damaged. The data stays valid until the next Refresh or Close.
+//
+bool TileDiskCache::Find(TileDiskKey const& key, uint8_t const*& data, size_t& size)
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+	if (!m_indexLoaded)
+	{
+		LoadIndex();
+	}
+	auto found = m_index.find(key);
+	if (found == m_index.end() || found->second.offset + sizeof(RecordHeader) > m_viewSize)
+	{
+		m_stats.misses++;
+		return false;
+	}
+
+	RecordHeader header;
+	memcpy(&header, m_view + found->second.offset, sizeof(header));
+	uint8_t const* recordData = m_view + found->second.offset + sizeof(RecordHeader);
+	if (!found->second.verified)
+	{
+		if (Checksum(recordData, header.dataSize) != header.dataChecksum)
+		{
+			m_index.erase(found);
+			m_stats.damagedRecords++;
+			m_stats.misses++;
+			return false;
+		}
+		found->second.verified = true;
+	}
+	data = recordData;
+	size = header.dataSize;
+	m_stats.hits++;
+	return true;
+}
+
+//
+//  FUNCTION: Append
+//
+//  PURPOSE: Writes a record for the tile at the end of the file in a single write. Returns false when it could not be
+//	written, the file is then left as it was as far as the index is concerned.
+//
+bool TileDiskCache::Append(TileDiskKey const& key, uint8_t const* data, size_t size)
+{
+	if (!IsOpen() || size > UINT32_MAX)
+	{
+		return false;
+	}
+	if (!m_indexLoaded)
+	{
+		LoadIndex();
+	}
+
+	RecordHeader header{};
+	header.magic = RECORDMAGIC;
+	header.dataSize = (uint32_t)size;
+	header.key = key;
+	header.dataChecksum = Checksum(data, size);
+	header.headerChecksum = Checksum((uint8_t const*)&header, offsetof(RecordHeader, headerChecksum));
+
+	uint64_t recordSize = RecordSize(header.dataSize);
+	m_record.assign((size_t)recordSize, 0);
+	memcpy(m_record.data(), &header, sizeof(header));
+	if (size > 0)
+	{
+		memcpy(m_record.data() + sizeof(header), data, size);
+	}
+	if (!Write(m_end, m_record.data(), m_record.size()))
+	{
+		return false;
+	}
+
+	m_index[key] = IndexEntry{ m_end, true };
+	m_end += recordSize;
+	m_stats.appends++;
+	m_stats.appendedBytes += recordSize;
+	m_stats.fileBytes = m_end;
+	return true;
+}
+
+//
+//  FUNCTION: Flush
+//
+//  PURPOSE: Asks the system to write the appended records to the disk. Not needed for the file to stay consistent, only
+//	for the records to survive a power loss.
+//
+void TileDiskCache::Flush()
+{
+	if (IsOpen())
+	{
+#ifdef _WIN32
+		FlushFileBuffers((HANDLE)m_file);
+#else
+		fsync((int)m_file);
+#endif
+	}
+}
+
+TileDiskCacheStats TileDiskCache::GetStats() const
+{
+	return m_stats;
+}
+
+bool TileDiskCache::Map(uint64_t size)
+{
+	if (size == 0)
+	{
+		return false;
+	}
+#ifdef _WIN32
+	HANDLE mapping = CreateFileMappingW((HANDLE)m_file, nullptr, PAGE_READONLY, (DWORD)(size >> 32), (DWORD)size, nullptr);
+	if (mapping == nullptr)
+	{
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+	m_mapping = mapping;
+#else
+	void* view = mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED, (int)m_file, 0);
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+#endif
+	m_view = static_cast<uint8_t const*>(view);
+	m_viewSize = size;
+	return true;
+}
+
+void TileDiskCache::Unmap()
+{
+	if (m_view != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_view);
+		CloseHandle((HANDLE)m_mapping);
+		m_mapping = nullptr;
+#else
+		munmap(const_cast<uint8_t*>(m_view), (size_t)m_viewSize);
+#endif
+	}
+	m_view = nullptr;
+	m_viewSize = 0;
+}
+
+bool TileDiskCache::Write(uint64_t offset, void const* data, size_t size)
+{
+#ifdef _WIN32
+	OVERLAPPED overlapped{};
+	overlapped.Offset = (DWORD)offset;
+	overlapped.OffsetHigh = (DWORD)(offset >> 32);
+	DWORD written = 0;
+	return WriteFile((HANDLE)m_file, data, (DWORD)size, &written, &overlapped) && written == size;
+#else
+	uint8_t const* bytes = static_cast<uint8_t const*>(data);
+	while (size > 0)
+	{
+		ssize_t written = pwrite((int)m_file, bytes, size, (off_t)offset);
+		if (written <= 0)
+		{
+			return false;
+		}
+		bytes += written;
+		offset += (uint64_t)written;
+		size -= (size_t)written;
+	}
+	return true;
+#endif
+}
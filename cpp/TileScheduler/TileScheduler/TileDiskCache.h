@@ -0,0 +1,121 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+//
+//  STRUCT: TileDiskKey
+//
+//  PURPOSE: What a tile in the disk cache is looked up by. The content and options hashes come from the application:
+//	the document or image the tiles are drawn from, and every setting that changes their pixels.
+//
+struct TileDiskKey
+{
+	uint64_t content = 0;
+	uint64_t options = 0;
+	int32_t  column = 0;
+	int32_t  row = 0;
+	int32_t  level = 0;
+	int32_t  tileSize = 0;
+
+	bool operator==(TileDiskKey const& other) const
+	{
+		return content == other.content && options == other.options && column == other.column && row == other.row &&
+			level == other.level && tileSize == other.tileSize;
+	}
+};
+
+//
+//  STRUCT: TileDiskCacheStats
+//
+//  PURPOSE: Lookups and appends made on the disk cache, and what loading its index found.
+//
+struct TileDiskCacheStats
+{
+	uint64_t hits = 0;//Tiles found with intact data
+	uint64_t misses = 0;//Tiles not in the file
+	uint64_t damagedRecords = 0;//Records whose data did not match its checksum, and torn records cut off the end
+	uint64_t appends = 0;//Tiles written to the file
+	uint64_t appendedBytes = 0;//Bytes written to the file, headers included
+	uint64_t indexedRecords = 0;//Records found when the index was loaded
+	uint64_t fileBytes = 0;//Bytes of valid records in the file
+	double   indexMs = 0.0;//Time spent loading the index
+};
+
+//
+//  CLASS: TileDiskCache
+//
+//  PURPOSE: Compressed tiles kept in a file across runs of the application, so a document viewed before comes back at
+//	the speed the disk reads it instead of being drawn again. The file is an append-only log of records, each one a
+//	header with the key, the size and a checksum of the data, then the TileCodec data. It is read through a memory
+//	mapping and only ever written past the last valid record.
+//	There is no separate index to damage. The index is built in memory from the record headers, on the first lookup
+//	rather than when the file is opened. A crash in the middle of an append leaves a torn record at the end, which fails
+//	its checksum and is written over by the next append. Data is checked against its checksum the first time it is read,
+//	so a damaged record reads as a miss. A later record for the same key replaces an earlier one.
+//	Only one process may have the file open at a time. The cache is used from the thread drawing the ranges.
+//
+class TileDiskCache
+{
+public:
+	TileDiskCache() = default;
+	~TileDiskCache();
+	TileDiskCache(TileDiskCache const&) = delete;
+	TileDiskCache& operator=(TileDiskCache const&) = delete;
+
+	bool Open(std::filesystem::path const& path);
+	void Close();
+	bool IsOpen() const;
+	void Refresh();
+	bool Find(TileDiskKey const& key, uint8_t const*& data, size_t& size);
+	bool Append(TileDiskKey const& key, uint8_t const* data, size_t size);
+	void Flush();
+	TileDiskCacheStats GetStats() const;
+
+	//Changes whenever the file layout does. Files of another version are emptied when opened.
+	const static uint32_t VERSION = 1;
+
+private:
+	struct KeyHash
+	{
+		size_t operator()(TileDiskKey const& key) const;
+	};
+
+	struct IndexEntry
+	{
+		uint64_t  offset = 0;//Of the record header
+		bool      verified = false;//The data has been checked against its checksum
+	};
+
+	void LoadIndex();
+	bool Map(uint64_t size);
+	void Unmap();
+	bool Write(uint64_t offset, void const* data, size_t size);
+
+	//member variables
+	intptr_t                m_file = -1;//File descriptor, or HANDLE on Windows
+	void*                   m_mapping = nullptr;//File mapping object on Windows
+	uint8_t const*          m_view = nullptr;
+	uint64_t                m_viewSize = 0;
+	uint64_t                m_end = 0;//End of the last valid record, where the next one goes
+	bool                    m_indexLoaded = false;
+	std::unordered_map<TileDiskKey, IndexEntry, KeyHash> m_index;
+	std::vector<uint8_t>    m_record;//Scratch space for Append
+	TileDiskCacheStats      m_stats;
+};
@@ -0,0 +1,114 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileGlyphAtlas.h"
+
+#include <algorithm>
+
+//Rows of the built in font, top to bottom, the leftmost font pixel in the highest of the glyph's width bits.
+static const uint8_t s_fontRows[TileLabel::GLYPHCOUNT][TileGlyphAtlas::FONTHEIGHT] = {
+	{ 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },//0
+	{ 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },//1
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },//2
+	{ 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },//3
+	{ 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },//4
+	{ 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },//5
+	{ 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },//6
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },//7
+	{ 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },//8
+	{ 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },//9
+	{ 0x00, 0x00, 0x00, 0x00, 0x03, 0x01, 0x02 },//,
+	{ 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } //-
+};
+
+//Width of each glyph of the built in font, in font pixels.
+static const int s_fontWidths[TileLabel::GLYPHCOUNT] = { 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 2, 5 };
+
+//
+//  FUNCTION: Build
+//
+//  PURPOSE: Rasterizes the glyphs for labels on tiles of the given size. The sample's labels are min(60, 0.24 * tileSize)
+//	pixels, and the digits of Segoe UI are about 0.7 of that tall. A size of 0 empties the atlas.
+//
+void TileGlyphAtlas::Build(int tileSize)
+{
+	m_tileSize = std::max(tileSize, 0);
+	float fontSize = std::min(60.0f, m_tileSize * 0.24f);
+	m_scale = std::max((int)(fontSize * 0.7f / FONTHEIGHT + 0.5f), 1);
+
+	m_width = 0;
+	for (int glyph = 0; glyph < TileLabel::GLYPHCOUNT; glyph++)
+	{
+		m_glyphX[glyph] = m_width;
+		m_glyphWidth[glyph] = s_fontWidths[glyph] * m_scale;
+		m_width += m_glyphWidth[glyph];
+	}
+	if (m_tileSize == 0)
+	{
+		m_coverage.clear();
+		return;
+	}
+
+	m_coverage.assign((size_t)m_width * FONTHEIGHT * m_scale, 0);
+	for (int glyph = 0; glyph < TileLabel::GLYPHCOUNT; glyph++)
+	{
+		for (int y = 0; y < FONTHEIGHT * m_scale; y++)
+		{
+			uint8_t fontRow = s_fontRows[glyph][y / m_scale];
+			uint8_t* line = m_coverage.data() + (size_t)y * m_width + m_glyphX[glyph];
+			for (int x = 0; x < m_glyphWidth[glyph]; x++)
+			{
+				int bit = s_fontWidths[glyph] - 1 - x / m_scale;
+				line[x] = (fontRow >> bit) & 1 ? 255 : 0;
+			}
+		}
+	}
+}
+
+int TileGlyphAtlas::GetTileSize() const
+{
+	return m_tileSize;
+}
+
+//Width of a label in pixels, with one font pixel between glyphs.
+int TileGlyphAtlas::GetLabelWidth(uint8_t const* glyphs, int glyphCount) const
+{
+	int width = 0;
+	for (int i = 0; i < glyphCount; i++)
+	{
+		width += m_glyphWidth[glyphs[i]] + (i > 0 ? m_scale : 0);
+	}
+	return width;
+}
+
+int TileGlyphAtlas::GetLabelHeight() const
+{
+	return FONTHEIGHT * m_scale;
+}
+
+int TileGlyphAtlas::GetGlyphWidth(int glyph) const
+{
+	return m_glyphWidth[glyph];
+}
+
+//Pixels left between two glyphs of a label, one font pixel.
+int TileGlyphAtlas::GetGlyphSpacing() const
+{
+	return m_scale;
+}
+
+//Coverage of line [0, GetLabelHeight()) of a glyph, GetGlyphWidth(glyph) values. Only valid once built.
+uint8_t const* TileGlyphAtlas::GetGlyphLine(int glyph, int line) const
+{
+	return m_coverage.data() + (size_t)line * m_width + m_glyphX[glyph];
+}
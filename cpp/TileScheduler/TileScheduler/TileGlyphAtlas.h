@@ -0,0 +1,54 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileLabel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+//  CLASS: TileGlyphAtlas
+//
+//  PURPOSE: The TileLabel glyphs rasterized once on the CPU, for the software path. The glyphs come from a built in 5 by 7
+//	pixel font, scaled by a whole number to about the cap height of the label font the Virtual Surfaces sample uses for
+//	that tile size, into one 8 bit coverage image with the glyphs side by side. SoftwareTileCanvas::DrawLabel blends a
+//	label into a tile one glyph at a time, so a label costs a handful of small blits. The atlas is only read once built,
+//	so any number of threads can draw with it.
+//
+class TileGlyphAtlas
+{
+public:
+	void Build(int tileSize);
+	int GetTileSize() const;
+	int GetLabelWidth(uint8_t const* glyphs, int glyphCount) const;
+	int GetLabelHeight() const;
+	int GetGlyphWidth(int glyph) const;
+	int GetGlyphSpacing() const;
+	uint8_t const* GetGlyphLine(int glyph, int line) const;
+
+	//Size of the glyphs of the built in font, in font pixels.
+	const static int FONTWIDTH = 5;
+	const static int FONTHEIGHT = 7;
+
+private:
+	//member variables
+	int                     m_tileSize = 0;//Tile size the atlas was built for, 0 before Build
+	int                     m_scale = 1;//Atlas pixels per font pixel
+	int                     m_width = 0;
+	int                     m_glyphX[TileLabel::GLYPHCOUNT] = {};//Left edge of each glyph in the atlas
+	int                     m_glyphWidth[TileLabel::GLYPHCOUNT] = {};
+	std::vector<uint8_t>    m_coverage;//m_width by FONTHEIGHT * m_scale, 255 where a glyph covers the pixel
+};
@@ -0,0 +1,64 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileLabel.h"
+
+//Appends the glyphs of a number, returns the new glyph count.
+static int AppendNumber(int value, uint8_t glyphs[], int count)
+{
+	uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+	if (value < 0)
+	{
+		glyphs[count++] = (uint8_t)TileLabel::MINUSGLYPH;
+	}
+
+	uint8_t digits[10];
+	int digitCount = 0;
+	do
+	{
+		digits[digitCount++] = (uint8_t)(magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+
+	while (digitCount > 0)
+	{
+		glyphs[count++] = digits[--digitCount];
+	}
+	return count;
+}
+
+//
+//  FUNCTION: GetGlyphs
+//
+//  PURPOSE: Fills glyphs, which has room for MAXGLYPHCOUNT, with the label of a tile and returns the number of glyphs.
+//	The label reads the same as std::to_wstring(row) + L"," + std::to_wstring(column).
+//
+int TileLabel::GetGlyphs(int row, int column, uint8_t glyphs[])
+{
+	int count = AppendNumber(row, glyphs, 0);
+	glyphs[count++] = (uint8_t)COMMAGLYPH;
+	return AppendNumber(column, glyphs, count);
+}
+
+wchar_t TileLabel::GetCharacter(int glyph)
+{
+	if (glyph == COMMAGLYPH)
+	{
+		return L',';
+	}
+	if (glyph == MINUSGLYPH)
+	{
+		return L'-';
+	}
+	return (wchar_t)(L'0' + glyph);
+}
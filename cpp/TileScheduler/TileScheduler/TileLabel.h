@@ -0,0 +1,36 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+
+//
+//  CLASS: TileLabel
+//
+//  PURPOSE: The "row,column" label drawn on every tile, as indices into a fixed set of GLYPHCOUNT glyphs: the ten digits,
+//	the comma and the minus sign. Renderers shape or rasterize those glyphs once and put every label together from them,
+//	so labelling a tile neither formats a string nor allocates.
+//
+class TileLabel
+{
+public:
+	static int GetGlyphs(int row, int column, uint8_t glyphs[]);
+	static wchar_t GetCharacter(int glyph);
+
+	const static int COMMAGLYPH = 10;
+	const static int MINUSGLYPH = 11;
+	const static int GLYPHCOUNT = 12;
+	//Longest label: two numbers of a sign and 10 digits each, and the comma.
+	const static int MAXGLYPHCOUNT = 23;
+};
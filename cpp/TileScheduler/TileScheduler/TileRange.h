@@ -0,0 +1,141 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+//
+//  STRUCT: TileCoordinate
+//
+//  PURPOSE: Column and row of a single tile.
+//
+struct TileCoordinate
+{
+	int column = 0;
+	int row = 0;
+};
+
+//
+//  STRUCT: TileRange
+//
+//  PURPOSE: A rectangular block of tiles, in tile coordinates. This is the unit of work exchanged between the TileScheduler
+//	and the renderer, so the scheduler never has to know about pixels, surfaces or a specific graphics API.
+//	A range can be iterated directly. The tiles are computed on the fly, column by column, so enumerating a range never
+//	allocates no matter how many tiles it holds.
+//
+struct TileRange
+{
+	int startColumn = 0;
+	int startRow = 0;
+	int numColumns = 0;
+	int numRows = 0;
+
+	class Iterator
+	{
+	public:
+		Iterator(int column, int row, int startRow, int endRow) :
+			m_column(column), m_row(row), m_startRow(startRow), m_endRow(endRow)
+		{
+		}
+
+		TileCoordinate operator*() const
+		{
+			return TileCoordinate{ m_column, m_row };
+		}
+
+		Iterator& operator++()
+		{
+			if (++m_row == m_endRow)
+			{
+				m_row = m_startRow;
+				++m_column;
+			}
+			return *this;
+		}
+
+		bool operator==(Iterator const& other) const
+		{
+			return m_column == other.m_column && m_row == other.m_row;
+		}
+
+		bool operator!=(Iterator const& other) const
+		{
+			return !(*this == other);
+		}
+
+	private:
+		int m_column;
+		int m_row;
+		int m_startRow;
+		int m_endRow;
+	};
+
+	bool IsEmpty() const
+	{
+		return numColumns <= 0 || numRows <= 0;
+	}
+
+	int TileCount() const
+	{
+		return IsEmpty() ? 0 : numColumns * numRows;
+	}
+
+	bool Contains(TileRange const& other) const
+	{
+		return other.startColumn >= startColumn &&
+			other.startRow >= startRow &&
+			other.startColumn + other.numColumns <= startColumn + numColumns &&
+			other.startRow + other.numRows <= startRow + numRows;
+	}
+
+	//The tiles that are in both ranges. The result is empty when they do not overlap.
+	TileRange Intersect(TileRange const& other) const
+	{
+		int left = startColumn > other.startColumn ? startColumn : other.startColumn;
+		int top = startRow > other.startRow ? startRow : other.startRow;
+		int right = startColumn + numColumns < other.startColumn + other.numColumns ? startColumn + numColumns : other.startColumn + other.numColumns;
+		int bottom = startRow + numRows < other.startRow + other.numRows ? startRow + numRows : other.startRow + other.numRows;
+		if (right <= left || bottom <= top)
+		{
+			return TileRange{ left, top, 0, 0 };
+		}
+		return TileRange{ left, top, right - left, bottom - top };
+	}
+
+	//Level of detail conversions. A tile at level n covers 2^n by 2^n tiles of level 0. ToLevel returns the level n tiles
+	//covering this level 0 range, FromLevel the level 0 tiles covered by this level n range.
+	TileRange ToLevel(int level) const
+	{
+		if (IsEmpty())
+		{
+			return TileRange{ startColumn >> level, startRow >> level, 0, 0 };
+		}
+		int left = startColumn >> level;
+		int top = startRow >> level;
+		return TileRange{ left, top, ((startColumn + numColumns - 1) >> level) - left + 1, ((startRow + numRows - 1) >> level) - top + 1 };
+	}
+
+	TileRange FromLevel(int level) const
+	{
+		return TileRange{ startColumn << level, startRow << level, numColumns << level, numRows << level };
+	}
+
+	Iterator begin() const
+	{
+		return IsEmpty() ? end() : Iterator(startColumn, startRow, startRow, startRow + numRows);
+	}
+
+	Iterator end() const
+	{
+		return Iterator(startColumn + (IsEmpty() ? 0 : numColumns), startRow, startRow, startRow + numRows);
+	}
+};
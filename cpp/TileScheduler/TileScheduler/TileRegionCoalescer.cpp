@@ -0,0 +1,293 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileRegionCoalescer.h"
+
+#include <algorithm>
+#include <cstdint>
+
+TileRegionCoalescer::TileRegionCoalescer(int sessionCost) :
+	m_sessionCost(std::max(sessionCost, 0)),
+	m_candidates(MAXCOSTMERGERANGES * MAXCOSTMERGERANGES)
+{
+	m_rangeSessions.reserve(MAXCOSTMERGERANGES);
+}
+
+void TileRegionCoalescer::SetSessionCost(int sessionCost)
+{
+	m_sessionCost = std::max(sessionCost, 0);
+}
+
+int TileRegionCoalescer::GetSessionCost() const
+{
+	return m_sessionCost;
+}
+
+//
+//  FUNCTION: CountSessions
+//
+//  PURPOSE: Number of BeginDraw/EndDraw sessions a range is drawn in: one for every block the queue cuts it into when
+//	it is pushed with that visible range, or a single one without a queue.
+//
+int TileRegionCoalescer::CountSessions(TileRange const& range, TileWorkQueue const* queue, TileRange const& visibleRange)
+{
+	return queue ? queue->CountChunks(range, 0, visibleRange) : 1;
+}
+
+//
+//  FUNCTION: IsCheaper
+//
+//  PURPOSE: Returns true when the first merge costs fewer extra tiles for every session it saves than the second one.
+//
+bool TileRegionCoalescer::IsCheaper(MergeCandidate const& a, MergeCandidate const& b)
+{
+	return (int64_t)a.extraTiles * b.savedSessions < (int64_t)b.extraTiles * a.savedSessions;
+}
+
+TileRange TileRegionCoalescer::Bounds(TileRange const& a, TileRange const& b)
+{
+	int left = std::min(a.startColumn, b.startColumn);
+	int top = std::min(a.startRow, b.startRow);
+	int right = std::max(a.startColumn + a.numColumns, b.startColumn + b.numColumns);
+	int bottom = std::max(a.startRow + a.numRows, b.startRow + b.numRows);
+	return TileRange{ left, top, right - left, bottom - top };
+}
+
+//
+//  FUNCTION: Coalesce
+//
+//  PURPOSE: Merges ranges in place. The ranges are expected to be vertical runs of single columns, sorted by column then
+//	row, as a column by column scan produces them. Runs of neighbouring columns that cover the same rows are merged first,
+//	that never costs anything. Then pairs of ranges are merged into their bounding range, the one that draws the fewest
+//	extra tiles for every session it saves first, for as long as that is fewer tiles than a session costs. The order of
+//	the merges does not depend on the session cost, a higher cost only goes on merging further, and every merge saves a
+//	session, so a higher cost never ends up with more sessions. A bounding range that overlaps other ranges is grown to
+//	take them in as well, so the result never overlaps. Every pair is priced once, after a merge only the pairs it can
+//	have changed are priced again. With a queue, sessions are counted in the blocks it cuts the ranges into when they
+//	are pushed with the visible range.
+//
+void TileRegionCoalescer::Coalesce(std::vector<TileRange>& ranges, TileWorkQueue const* queue, TileRange const& visibleRange)
+{
+	MergeColumns(ranges);
+	if (ranges.size() > MAXCOSTMERGERANGES)
+	{
+		return;
+	}
+
+	m_queue = queue;
+	m_visibleRange = visibleRange;
+	m_rangeSessions.clear();
+	for (TileRange const& range : ranges)
+	{
+		m_rangeSessions.push_back(CountSessions(range, m_queue, m_visibleRange));
+	}
+
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		for (size_t j = i + 1; j < ranges.size(); j++)
+		{
+			m_candidates[i * MAXCOSTMERGERANGES + j] = PriceMerge(ranges, i, j);
+		}
+	}
+
+	size_t first = 0;
+	size_t second = 0;
+	while (FindBestMerge(ranges.size(), first, second))
+	{
+		RemoveMerged(ranges, first, m_candidates[first * MAXCOSTMERGERANGES + second]);
+	}
+}
+
+//
+//  FUNCTION: RemoveMerged
+//
+//  PURPOSE: Drops every range inside the merged range and puts the merged range in the place of the first one, moving
+//	the prices of the pairs left along with their ranges. A pair whose grown bounds stay clear of the merged range keeps
+//	its price: nothing it took in went away, and nothing new cuts through it. A pair whose bounds take in all of the
+//	merged range keeps its bounds too, and its extra tiles and saved sessions go down by those of the merge. The pairs
+//	of the merged range, and the ones whose bounds cut through it, are priced again.
+//
+void TileRegionCoalescer::RemoveMerged(std::vector<TileRange>& ranges, size_t first, MergeCandidate merge)
+{
+	TileRange const& merged = merge.bounds;
+
+	//The pairs with the ranges kept move along with them. Both indices only go down and the pairs are visited by their
+	//second range, so no price is overwritten before it was moved.
+	size_t kept = 0;
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		if (i != first && merged.Contains(ranges[i]))
+		{
+			continue;
+		}
+		size_t keptPartner = 0;
+		for (size_t j = 0; j < i; j++)
+		{
+			if (j == first || !merged.Contains(ranges[j]))
+			{
+				m_candidates[keptPartner * MAXCOSTMERGERANGES + kept] = m_candidates[j * MAXCOSTMERGERANGES + i];
+				keptPartner++;
+			}
+		}
+		kept++;
+	}
+
+	kept = 0;
+	size_t mergedIndex = 0;
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		if (i == first)
+		{
+			mergedIndex = kept;
+			m_rangeSessions[kept] = CountSessions(merged, m_queue, m_visibleRange);
+			ranges[kept++] = merged;
+		}
+		else if (!merged.Contains(ranges[i]))
+		{
+			m_rangeSessions[kept] = m_rangeSessions[i];
+			ranges[kept++] = ranges[i];
+		}
+	}
+	ranges.resize(kept);
+	m_rangeSessions.resize(kept);
+
+	for (size_t i = 0; i < kept; i++)
+	{
+		for (size_t j = i + 1; j < kept; j++)
+		{
+			MergeCandidate& candidate = m_candidates[i * MAXCOSTMERGERANGES + j];
+			if (i == mergedIndex || j == mergedIndex)
+			{
+				candidate = PriceMerge(ranges, i, j);
+			}
+			else if (candidate.bounds.Contains(merged))
+			{
+				candidate.extraTiles -= merge.extraTiles;
+				candidate.savedSessions -= merge.savedSessions;
+			}
+			else if (!candidate.bounds.Intersect(merged).IsEmpty())
+			{
+				candidate = PriceMerge(ranges, i, j);
+			}
+		}
+	}
+}
+
+//
+//  FUNCTION: MergeColumns
+//
+//  PURPOSE: Merges column runs into wider ranges when neighbouring columns have runs over the same rows. Ranges extended
+//	into a column stay where they are, so the ones that can still be extended start at the first range still reaching
+//	the previous column.
+//
+void TileRegionCoalescer::MergeColumns(std::vector<TileRange>& ranges)
+{
+	size_t kept = 0;
+	size_t previousColumnStart = 0;
+	size_t columnStart = 0;
+	int currentColumn = 0;
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		TileRange run = ranges[i];
+		if (i == 0 || run.startColumn != currentColumn)
+		{
+			while (previousColumnStart < kept && ranges[previousColumnStart].startColumn + ranges[previousColumnStart].numColumns < run.startColumn)
+			{
+				previousColumnStart++;
+			}
+			columnStart = kept;
+			currentColumn = run.startColumn;
+		}
+
+		bool merged = false;
+		for (size_t j = previousColumnStart; j < columnStart && !merged; j++)
+		{
+			TileRange& previous = ranges[j];
+			if (previous.startColumn + previous.numColumns == run.startColumn && previous.startRow == run.startRow && previous.numRows == run.numRows)
+			{
+				previous.numColumns += run.numColumns;
+				merged = true;
+			}
+		}
+		if (!merged)
+		{
+			ranges[kept++] = run;
+		}
+	}
+	ranges.resize(kept);
+}
+
+//
+//  FUNCTION: PriceMerge
+//
+//  PURPOSE: Grows the bounding range of a pair of ranges until it takes in every range it overlaps, and works out what
+//	drawing it costs: the tiles it draws that none of the ranges it takes in needed, and the sessions it saves against
+//	drawing those ranges on their own.
+//
+TileRegionCoalescer::MergeCandidate TileRegionCoalescer::PriceMerge(std::vector<TileRange> const& ranges, size_t first, size_t second) const
+{
+	MergeCandidate candidate;
+	candidate.bounds = Bounds(ranges[first], ranges[second]);
+
+	//Grows the bounds until they cut through no other range.
+	bool grown = true;
+	while (grown)
+	{
+		grown = false;
+		for (TileRange const& other : ranges)
+		{
+			if (!candidate.bounds.Intersect(other).IsEmpty() && !candidate.bounds.Contains(other))
+			{
+				candidate.bounds = Bounds(candidate.bounds, other);
+				grown = true;
+			}
+		}
+	}
+
+	candidate.extraTiles = candidate.bounds.TileCount();
+	candidate.savedSessions = -CountSessions(candidate.bounds, m_queue, m_visibleRange);
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		if (candidate.bounds.Contains(ranges[i]))
+		{
+			candidate.extraTiles -= ranges[i].TileCount();
+			candidate.savedSessions += m_rangeSessions[i];
+		}
+	}
+	return candidate;
+}
+
+//
+//  FUNCTION: FindBestMerge
+//
+//  PURPOSE: Looks for the priced pair that saves sessions for the fewest extra tiles each, the first one in range order
+//	on a tie. Returns false when no merge saves a session for fewer extra tiles than the session costs.
+//
+bool TileRegionCoalescer::FindBestMerge(size_t count, size_t& first, size_t& second) const
+{
+	MergeCandidate const* best = nullptr;
+	for (size_t i = 0; i < count; i++)
+	{
+		for (size_t j = i + 1; j < count; j++)
+		{
+			MergeCandidate const& candidate = m_candidates[i * MAXCOSTMERGERANGES + j];
+			if (candidate.savedSessions > 0 && (!best || IsCheaper(candidate, *best)))
+			{
+				best = &candidate;
+				first = i;
+				second = j;
+			}
+		}
+	}
+	return best && best->extraTiles < (int64_t)m_sessionCost * best->savedSessions;
+}
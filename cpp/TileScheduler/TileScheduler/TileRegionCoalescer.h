@@ -0,0 +1,76 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileRange.h"
+#include "TileWorkQueue.h"
+
+#include <cstddef>
+#include <vector>
+
+//
+//  CLASS: TileRegionCoalescer
+//
+//  PURPOSE: Turns the tiles an update needs into as few non overlapping ranges as is worth it. Every range ends up as at
+//	least one BeginDraw/EndDraw session, which has a fixed cost of its own, so two ranges are merged into their bounding
+//	range whenever the tiles that have to be drawn again to fill it cost less than the sessions that are saved. Costs are
+//	counted in tiles: a session costs sessionCost tiles, a tile in a range costs one whether it was needed or not. Given
+//	the TileWorkQueue the ranges go to, a range costs a session for every block the queue will cut it into, so merging
+//	only pays when it leaves fewer blocks. Without one, a range is a single session.
+//	It only works on tile coordinates, so it can be driven headless with hand made ranges.
+//
+class TileRegionCoalescer
+{
+public:
+	explicit TileRegionCoalescer(int sessionCost = DEFAULTSESSIONCOST);
+	void SetSessionCost(int sessionCost);
+	int GetSessionCost() const;
+	void Coalesce(std::vector<TileRange>& ranges, TileWorkQueue const* queue = nullptr, TileRange const& visibleRange = TileRange{});
+
+	static int CountSessions(TileRange const& range, TileWorkQueue const* queue, TileRange const& visibleRange);
+
+	//Cost of a BeginDraw/EndDraw session, in tiles, unless told otherwise.
+	const static int DEFAULTSESSIONCOST = 4;
+	//Above this many ranges only the exact merges are made. Pricing a pair takes a pass over the ranges, so the cost based
+	//merges take cubic time to price every pair up front, then only the pairs each merge touched are priced again.
+	const static int MAXCOSTMERGERANGES = 64;
+
+private:
+	//
+	//  STRUCT: MergeCandidate
+	//
+	//  PURPOSE: Bounding range of a pair of ranges, grown to take in every range it overlaps, the tiles it draws that were
+	//	not needed and the sessions it saves.
+	//
+	struct MergeCandidate
+	{
+		TileRange   bounds;
+		int         extraTiles = 0;
+		int         savedSessions = 0;
+	};
+
+	static void MergeColumns(std::vector<TileRange>& ranges);
+	static TileRange Bounds(TileRange const& a, TileRange const& b);
+	static bool IsCheaper(MergeCandidate const& a, MergeCandidate const& b);
+	MergeCandidate PriceMerge(std::vector<TileRange> const& ranges, size_t first, size_t second) const;
+	bool FindBestMerge(size_t count, size_t& first, size_t& second) const;
+	void RemoveMerged(std::vector<TileRange>& ranges, size_t first, MergeCandidate merge);
+
+	//member variables
+	int                         m_sessionCost;
+	TileWorkQueue const*        m_queue = nullptr;//Of the Coalesce call under way
+	TileRange                   m_visibleRange;
+	std::vector<int>            m_rangeSessions;//Sessions of each range, along with the ranges
+	std::vector<MergeCandidate> m_candidates;//Pair i, j with i < j at i * MAXCOSTMERGERANGES + j
+};
@@ -0,0 +1,394 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileResidencyCache.h"
+
+#include <algorithm>
+
+TileResidencyCache::TileResidencyCache(int tileSize) :
+	m_tileBytes((size_t)tileSize * (size_t)tileSize * 4)
+{
+	m_slots.resize(256);
+	m_mask = m_slots.size() - 1;
+	m_candidates.reserve(256);
+	m_keys.reserve(256);
+	m_keepRanges.reserve(256);
+}
+
+//
+//  FUNCTION: SetBudget
+//
+//  PURPOSE: Sets how much memory the resident tiles may use, counting 4 bytes per pixel, and how many tiles around the
+//	required range are always kept. A budget of 0 discards everything outside the trim margin on every update.
+//
+void TileResidencyCache::SetBudget(size_t budgetBytes, int trimMarginTiles)
+{
+	m_budgetBytes = budgetBytes;
+	m_trimMarginTiles = std::max(trimMarginTiles, 0);
+
+	//Makes room up front for twice the budget, so the table and the scratch space do not grow while panning.
+	size_t capacity = budgetBytes / m_tileBytes * 2;
+	while (m_slots.size() < capacity * 2)
+	{
+		Grow();
+	}
+	m_candidates.reserve(capacity);
+	m_keys.reserve(capacity);
+	m_keepRanges.reserve(capacity);
+}
+
+size_t TileResidencyCache::GetBudget() const
+{
+	return m_budgetBytes;
+}
+
+int TileResidencyCache::GetTrimMargin() const
+{
+	return m_trimMarginTiles;
+}
+
+size_t TileResidencyCache::GetTileBytes() const
+{
+	return m_tileBytes;
+}
+
+uint64_t TileResidencyCache::Key(int column, int row)
+{
+	return ((uint64_t)(uint32_t)column << 32) | (uint32_t)row;
+}
+
+int TileResidencyCache::KeyColumn(uint64_t key)
+{
+	return (int)(uint32_t)(key >> 32);
+}
+
+int TileResidencyCache::KeyRow(uint64_t key)
+{
+	return (int)(uint32_t)(key & 0xFFFFFFFF);
+}
+
+size_t TileResidencyCache::Find(uint64_t key) const
+{
+	size_t index = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & m_mask;
+	while (m_slots[index].used)
+	{
+		if (m_slots[index].key == key)
+		{
+			return index;
+		}
+		index = (index + 1) & m_mask;
+	}
+	return NOTFOUND;
+}
+
+size_t TileResidencyCache::Insert(uint64_t key)
+{
+	//Keeps the table at most half full, so probe sequences stay short.
+	if ((size_t)(m_count + 1) * 2 > m_slots.size())
+	{
+		Grow();
+	}
+
+	size_t index = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & m_mask;
+	while (m_slots[index].used)
+	{
+		if (m_slots[index].key == key)
+		{
+			return index;
+		}
+		index = (index + 1) & m_mask;
+	}
+	m_slots[index].key = key;
+	m_slots[index].used = true;
+	m_count++;
+	return index;
+}
+
+//
+//  FUNCTION: Erase
+//
+//  PURPOSE: Removes a key with backward shift deletion, which keeps the probe sequences intact without tombstones.
+//
+void TileResidencyCache::Erase(uint64_t key)
+{
+	size_t index = Find(key);
+	if (index == NOTFOUND)
+	{
+		return;
+	}
+
+	size_t next = (index + 1) & m_mask;
+	while (m_slots[next].used)
+	{
+		size_t home = (size_t)((m_slots[next].key * 0x9E3779B97F4A7C15ull) >> 32) & m_mask;
+		//The entry at next can move into the hole unless its home slot lies cyclically between the hole and next.
+		bool canMove = index <= next ? (home <= index || home > next) : (home <= index && home > next);
+		if (canMove)
+		{
+			m_slots[index] = m_slots[next];
+			index = next;
+		}
+		next = (next + 1) & m_mask;
+	}
+	m_slots[index] = Slot{};
+	m_count--;
+}
+
+void TileResidencyCache::Grow()
+{
+	std::vector<Slot> oldSlots;
+	oldSlots.swap(m_slots);
+	m_slots.resize(oldSlots.size() * 2);
+	m_mask = m_slots.size() - 1;
+	m_count = 0;
+	for (Slot const& slot : oldSlots)
+	{
+		if (slot.used)
+		{
+			size_t index = Insert(slot.key);
+			m_slots[index] = slot;
+		}
+	}
+}
+
+//
+//  FUNCTION: Touch
+//
+//  PURPOSE: Marks a tile as needed at tick. Returns false when the tile is neither resident nor queued, in which case the
+//	caller has to schedule it.
+//
+bool TileResidencyCache::Touch(int column, int row, uint32_t tick)
+{
+	size_t index = Find(Key(column, row));
+	if (index == NOTFOUND)
+	{
+		return false;
+	}
+	m_slots[index].lastUse = tick;
+	return true;
+}
+
+//
+//  FUNCTION: Schedule
+//
+//  PURPOSE: Adds a tile that has been queued for drawing. It counts against the budget from now on, so it is not
+//	scheduled a second time while it waits.
+//
+void TileResidencyCache::Schedule(int column, int row, uint32_t tick)
+{
+	TileRange tile{ column, row, 1, 1 };
+	if (m_index.Get(column, row) == TileState::Evicted)
+	{
+		m_stats.refills++;
+	}
+	size_t index = Insert(Key(column, row));
+	m_slots[index].lastUse = tick;
+	m_index.Set(tile, TileState::Pending);
+	UpdateResidentBytes();
+}
+
+//
+//  FUNCTION: MarkDrawn
+//
+//  PURPOSE: Marks a range that was just drawn as valid. Every tile of a queued range is in the cache, queued tiles
+//	that get evicted are clipped out of the queue at the same time.
+//
+void TileResidencyCache::MarkDrawn(TileRange const& range)
+{
+	m_index.Set(range, TileState::Valid);
+}
+
+//
+//  FUNCTION: Remove
+//
+//  PURPOSE: Forgets the tiles in the range, for example when drawing them failed, so they get scheduled again.
+//
+void TileResidencyCache::Remove(TileRange const& range)
+{
+	for (TileCoordinate coordinate : range)
+	{
+		Erase(Key(coordinate.column, coordinate.row));
+	}
+	m_index.Set(range, TileState::Empty);
+	UpdateResidentBytes();
+}
+
+bool TileResidencyCache::IsDrawn(TileRange const& range) const
+{
+	return m_index.All(range, TileState::Valid);
+}
+
+TileState TileResidencyCache::GetState(int column, int row) const
+{
+	return m_index.Get(column, row);
+}
+
+void TileResidencyCache::RecordLookup(bool hit)
+{
+	if (hit)
+	{
+		m_stats.hits++;
+	}
+	else
+	{
+		m_stats.misses++;
+	}
+}
+
+int TileResidencyCache::GetTileCount() const
+{
+	return m_count;
+}
+
+TileCacheStats TileResidencyCache::GetStats() const
+{
+	return m_stats;
+}
+
+void TileResidencyCache::UpdateResidentBytes()
+{
+	m_stats.residentBytes = (size_t)m_count * m_tileBytes;
+	m_stats.peakResidentBytes = std::max(m_stats.peakResidentBytes, m_stats.residentBytes);
+}
+
+//
+//  FUNCTION: Evict
+//
+//  PURPOSE: When the tiles go over the budget, discards the least recently used ones outside every protected range until
+//	the cache is EVICTIONPERCENT below the budget. Queued tiles outside the protected ranges are always dropped at that
+//	point, they were never drawn. There is a protected range per viewport, a tile any of them holds on to stays.
+//	Returns true when something was evicted. GetKeepRanges then returns the tiles that remain, in as few ranges as the
+//	column by column layout allows, ready to be handed to a single Trim call. They are kept in space reserved by
+//	SetBudget, so a trim does not allocate.
+//
+bool TileResidencyCache::Evict(TileRange const* protectedRanges, int protectedRangeCount)
+{
+	std::vector<TileRange>& keepRanges = m_keepRanges;
+	size_t budgetTiles = m_budgetBytes / m_tileBytes;
+	if ((size_t)m_count <= budgetTiles)
+	{
+		return false;
+	}
+	size_t targetTiles = budgetTiles - budgetTiles * EVICTIONPERCENT / 100;
+
+	m_candidates.clear();
+	for (Slot const& slot : m_slots)
+	{
+		if (!slot.used)
+		{
+			continue;
+		}
+		TileRange tile{ KeyColumn(slot.key), KeyRow(slot.key), 1, 1 };
+		bool isProtected = false;
+		for (int i = 0; i < protectedRangeCount && !isProtected; i++)
+		{
+			isProtected = protectedRanges[i].Contains(tile);
+		}
+		if (!isProtected)
+		{
+			bool pending = m_index.Get(tile.startColumn, tile.startRow) == TileState::Pending;
+			m_candidates.push_back(EvictionCandidate{ slot.key, slot.lastUse, pending });
+		}
+	}
+	if (m_candidates.empty())
+	{
+		return false;
+	}
+
+	//Queued tiles first, then the drawn ones from the oldest.
+	std::sort(m_candidates.begin(), m_candidates.end(), [](EvictionCandidate const& a, EvictionCandidate const& b)
+	{
+		if (a.pending != b.pending)
+		{
+			return a.pending;
+		}
+		return a.lastUse < b.lastUse;
+	});
+
+	for (EvictionCandidate const& candidate : m_candidates)
+	{
+		if (!candidate.pending && (size_t)m_count <= targetTiles)
+		{
+			break;
+		}
+		Erase(candidate.key);
+		TileRange tile{ KeyColumn(candidate.key), KeyRow(candidate.key), 1, 1 };
+		if (candidate.pending)
+		{
+			m_index.Set(tile, TileState::Empty);
+		}
+		else
+		{
+			m_index.Set(tile, TileState::Evicted);
+			m_stats.evictions++;
+		}
+	}
+	UpdateResidentBytes();
+
+	//What is left, sorted column by column, turned into vertical runs, and runs of neighbouring columns with the same
+	//rows merged together.
+	m_keys.clear();
+	for (Slot const& slot : m_slots)
+	{
+		if (slot.used)
+		{
+			m_keys.push_back(slot.key);
+		}
+	}
+	std::sort(m_keys.begin(), m_keys.end());
+
+	keepRanges.clear();
+	for (uint64_t key : m_keys)
+	{
+		int column = KeyColumn(key);
+		int row = KeyRow(key);
+		if (!keepRanges.empty())
+		{
+			TileRange& last = keepRanges.back();
+			if (last.startColumn == column && last.startRow + last.numRows == row)
+			{
+				last.numRows++;
+				continue;
+			}
+		}
+		keepRanges.push_back(TileRange{ column, row, 1, 1 });
+	}
+
+	size_t kept = 0;
+	for (size_t i = 0; i < keepRanges.size(); i++)
+	{
+		TileRange run = keepRanges[i];
+		bool merged = false;
+		for (size_t j = 0; j < kept && !merged; j++)
+		{
+			TileRange& previous = keepRanges[j];
+			if (previous.startColumn + previous.numColumns == run.startColumn && previous.startRow == run.startRow && previous.numRows == run.numRows)
+			{
+				previous.numColumns++;
+				merged = true;
+			}
+		}
+		if (!merged)
+		{
+			keepRanges[kept++] = run;
+		}
+	}
+	keepRanges.resize(kept);
+	m_stats.trims++;
+	return true;
+}
+
+std::vector<TileRange> const& TileResidencyCache::GetKeepRanges() const
+{
+	return m_keepRanges;
+}
@@ -0,0 +1,117 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileRange.h"
+#include "TileStateIndex.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+//  STRUCT: TileCacheStats
+//
+//  PURPOSE: Counters describing how well the residency cache saves redraws, and what it costs in memory.
+//
+struct TileCacheStats
+{
+	uint64_t hits = 0;//Tiles that came into the required range and were still resident
+	uint64_t misses = 0;//Tiles that came into the required range and had to be drawn
+	uint64_t evictions = 0;//Tiles discarded to stay within the budget
+	uint64_t refills = 0;//Misses on tiles that had been evicted, drawn again because the budget was too small
+	uint64_t trims = 0;//Trim calls made to the renderer
+	size_t   residentBytes = 0;//Memory held by the tiles currently resident or queued
+	size_t   peakResidentBytes = 0;//Highest value residentBytes has reached
+
+	double HitRate() const
+	{
+		return hits + misses == 0 ? 0.0 : (double)hits / (double)(hits + misses);
+	}
+};
+
+//
+//  CLASS: TileResidencyCache
+//
+//  PURPOSE: Keeps track of which full resolution tiles are held by the surface, and when each one was last needed. Tiles
+//	are only discarded when the cache goes over its byte budget, and then down to a lower watermark, least recently used
+//	first, so moving back and forth over the same area does not draw the same tiles again and trims come in batches.
+//	Tiles within the trim margin of the required range of any viewport are never evicted.
+//	The recency of each tile lives in an open addressing hash table that only allocates when it grows, so a steady state
+//	pan does not allocate. Whether a tile is pending, valid or evicted lives in a TileStateIndex, so ranges are marked
+//	and checked a row of tiles at a time.
+//
+class TileResidencyCache
+{
+public:
+	explicit TileResidencyCache(int tileSize);
+	void SetBudget(size_t budgetBytes, int trimMarginTiles);
+	size_t GetBudget() const;
+	int GetTrimMargin() const;
+	size_t GetTileBytes() const;
+
+	bool Touch(int column, int row, uint32_t tick);
+	void Schedule(int column, int row, uint32_t tick);
+	void MarkDrawn(TileRange const& range);
+	void Remove(TileRange const& range);
+	bool IsDrawn(TileRange const& range) const;
+	TileState GetState(int column, int row) const;
+	bool Evict(TileRange const* protectedRanges, int protectedRangeCount);
+	std::vector<TileRange> const& GetKeepRanges() const;
+	void RecordLookup(bool hit);
+	int GetTileCount() const;
+	TileCacheStats GetStats() const;
+
+	//Fraction of the budget that is evicted at once when the cache goes over it.
+	const static int EVICTIONPERCENT = 25;
+
+private:
+	struct Slot
+	{
+		uint64_t  key = 0;
+		uint32_t  lastUse = 0;
+		bool      used = false;
+	};
+
+	struct EvictionCandidate
+	{
+		uint64_t  key;
+		uint32_t  lastUse;
+		bool      pending;
+	};
+
+	static uint64_t Key(int column, int row);
+	static int KeyColumn(uint64_t key);
+	static int KeyRow(uint64_t key);
+	size_t Find(uint64_t key) const;
+	size_t Insert(uint64_t key);
+	void Erase(uint64_t key);
+	void Grow();
+	void UpdateResidentBytes();
+
+	//member variables
+	std::vector<Slot>       m_slots;
+	size_t                  m_mask = 0;
+	int                     m_count = 0;
+	size_t                  m_tileBytes;
+	size_t                  m_budgetBytes = 0;//0 keeps only the protected range
+	int                     m_trimMarginTiles = 0;
+	TileStateIndex          m_index;
+	std::vector<EvictionCandidate> m_candidates;//Scratch space for Evict
+	std::vector<uint64_t>   m_keys;//Scratch space for Evict
+	std::vector<TileRange>  m_keepRanges;//Tiles left after the last Evict, reserved along with the scratch space
+	TileCacheStats          m_stats;
+
+	const static size_t     NOTFOUND = (size_t)-1;
+};
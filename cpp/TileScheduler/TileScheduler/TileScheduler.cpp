@@ -0,0 +1,1038 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileScheduler.h"
+#include "TileTelemetry.h"
+
+#include <algorithm>
+#include <cmath>
+
+//The memory bound of the draw ahead is not looked for past this many tiles, far more than anyone draws ahead.
+static const int MAXMEMORYDRAWAHEAD = 256;
+
+TileScheduler::TileScheduler(int tileSize, int drawAheadTileCount, int maxDrawAheadTileCount) :
+	m_tileSize(tileSize),
+	m_drawAheadTileCount(drawAheadTileCount),
+	m_maxDrawAheadTileCount(maxDrawAheadTileCount),
+	m_governor(drawAheadTileCount),
+	m_cache(tileSize)
+{
+	m_viewports.assign(MAXVIEWPORTCOUNT, Viewport(DrawAheadPredictor(tileSize, drawAheadTileCount, maxDrawAheadTileCount)));
+	m_viewports[DEFAULTVIEWPORT].used = true;
+	m_missRanges.reserve(TileRegionCoalescer::MAXCOSTMERGERANGES);
+	m_keepPieces.reserve(MAXTILESPERDRAW);
+}
+
+void TileScheduler::SetRenderer(ITileRenderer* renderer)
+{
+	m_currentRenderer = renderer;
+}
+
+ITileRenderer* TileScheduler::GetRenderer()
+{
+	return m_currentRenderer;
+}
+
+int TileScheduler::GetTileSize() const
+{
+	return m_tileSize;
+}
+
+//
+//  FUNCTION: SetTileSize
+//
+//  PURPOSE: Switches to tiles of another size, typically the one picked by a TileSizeCalibrator. Nothing drawn at the old
+//	size lines up with the new tiles, so the queue, the cache and the zoom state are dropped and the renderer is asked to
+//	trim everything. The budgets are kept. The next update draws the viewport again at the new size.
+//
+void TileScheduler::SetTileSize(int tileSize)
+{
+	if (tileSize <= 0 || tileSize == m_tileSize)
+	{
+		return;
+	}
+
+	m_tileSize = tileSize;
+	m_governor.Reset();
+	for (Viewport& view : m_viewports)
+	{
+		view.predictor = DrawAheadPredictor(tileSize, m_drawAheadTileCount, m_maxDrawAheadTileCount);
+		view.margins = view.predictor.GetMargins();
+	}
+	DropTiles();
+}
+
+//
+//  FUNCTION: Invalidate
+//
+//  PURPOSE: The content behind the tiles has changed, a new image or new render options, so nothing on the surface is
+//	valid any more. The queue and the cache are dropped, the surface is trimmed, and the tiles every viewport requires
+//	are queued again right away.
+//
+void TileScheduler::Invalidate()
+{
+	DropTiles();
+	for (int viewport = 0; viewport < MAXVIEWPORTCOUNT; viewport++)
+	{
+		Viewport const& view = m_viewports[viewport];
+		if (view.used && view.width > 0.0f && view.height > 0.0f)
+		{
+			UpdateRequiredTiles(viewport);
+		}
+	}
+	if (m_frameBudgetMs == 0.0)
+	{
+		ProcessPendingTiles();
+	}
+}
+
+//Forgets every tile, queued, drawn or coarse, and asks the renderer to trim them all. The budgets are kept.
+void TileScheduler::DropTiles()
+{
+	for (Viewport& view : m_viewports)
+	{
+		view.requiredRange = TileRange{};
+	}
+
+	size_t budgetBytes = m_cache.GetBudget();
+	int trimMarginTiles = m_cache.GetTrimMargin();
+	m_cache = TileResidencyCache(m_tileSize);
+	m_cache.SetBudget(budgetBytes, trimMarginTiles);
+	m_queue.Clear();
+	m_trimDue = false;
+
+	m_zoomLevel = 0;
+	for (int level = 1; level <= m_levelOfDetailCount; level++)
+	{
+		m_levelDrawnRanges[level] = TileRange{};
+	}
+
+	if (m_currentRenderer != nullptr)
+	{
+		m_currentRenderer->Trim(m_keepRanges);
+		for (int level = 1; level <= m_levelOfDetailCount; level++)
+		{
+			m_currentRenderer->TrimLevelOfDetail(TileRange{}, level);
+		}
+	}
+}
+
+//
+//  FUNCTION: GetVisibleRange
+//
+//  PURPOSE: Tiles that intersect the viewport at the current position, without any draw ahead.
+//
+TileRange TileScheduler::GetVisibleRange() const
+{
+	return GetVisibleRange(DEFAULTVIEWPORT);
+}
+
+TileRange TileScheduler::GetVisibleRange(int viewport) const
+{
+	if (!IsViewport(viewport))
+	{
+		return TileRange{};
+	}
+	if (m_zoomLevel > 0 && viewport == m_zoomViewport)
+	{
+		return m_zoomVisibleRange;
+	}
+
+	Viewport const& view = m_viewports[viewport];
+	return GetCoveredRange(view.positionX, view.positionY, view.width, view.height, m_tileSize);
+}
+
+//Visible range of every viewport in use, returns how many there are.
+int TileScheduler::GetVisibleRanges(TileRange visibleRanges[MAXVIEWPORTCOUNT]) const
+{
+	int count = 0;
+	for (int viewport = 0; viewport < MAXVIEWPORTCOUNT; viewport++)
+	{
+		if (m_viewports[viewport].used)
+		{
+			visibleRanges[count++] = GetVisibleRange(viewport);
+		}
+	}
+	return count;
+}
+
+//Required range of every viewport in use that has been updated, returns how many there are.
+int TileScheduler::GetRequiredRanges(TileRange requiredRanges[MAXVIEWPORTCOUNT]) const
+{
+	int count = 0;
+	for (Viewport const& view : m_viewports)
+	{
+		if (view.used && !view.requiredRange.IsEmpty())
+		{
+			requiredRanges[count++] = view.requiredRange;
+		}
+	}
+	return count;
+}
+
+//
+//  FUNCTION: GetCoveredRange
+//
+//  PURPOSE: Tiles of the given size covered by a rect at a position relative to the surface origin. The edges are floored
+//	to surface pixels once and the tiles come from those by integer division, so a position far out on the surface lands
+//	on the same tile as the same position near the origin. Pixels left or above the surface are taken as its first row and
+//	column.
+//
+TileRange TileScheduler::GetCoveredRange(double positionX, double positionY, double width, double height, int tileSize) const
+{
+	int64_t left, right, top, bottom;
+	m_frame.GetPixelSpanX(positionX, width, left, right);
+	m_frame.GetPixelSpanY(positionY, height, top, bottom);
+	int leftColumn = SurfaceFrame::ToTile(std::max(left, (int64_t)0), tileSize);
+	int topRow = SurfaceFrame::ToTile(std::max(top, (int64_t)0), tileSize);
+	int rightColumn = SurfaceFrame::ToTile(std::max(right, (int64_t)0), tileSize);
+	int bottomRow = SurfaceFrame::ToTile(std::max(bottom, (int64_t)0), tileSize);
+	return TileRange{ leftColumn, topRow, rightColumn - leftColumn + 1, bottomRow - topRow + 1 };
+}
+
+DrawAheadMargins TileScheduler::GetDrawAheadMargins() const
+{
+	return GetDrawAheadMargins(DEFAULTVIEWPORT);
+}
+
+DrawAheadMargins TileScheduler::GetDrawAheadMargins(int viewport) const
+{
+	return IsViewport(viewport) ? m_viewports[viewport].margins : DrawAheadMargins{};
+}
+
+bool TileScheduler::IsViewport(int viewport) const
+{
+	return viewport >= 0 && viewport < MAXVIEWPORTCOUNT && m_viewports[viewport].used;
+}
+
+//
+//  FUNCTION: AddViewport
+//
+//  PURPOSE: Adds a view of the surface, with its own position, size and draw ahead. Returns the viewport to pass to the
+//	methods that take one, or -1 when MAXVIEWPORTCOUNT are in use already. Nothing is drawn for it until it is given a
+//	size and a position.
+//
+int TileScheduler::AddViewport()
+{
+	for (int viewport = 0; viewport < MAXVIEWPORTCOUNT; viewport++)
+	{
+		Viewport& view = m_viewports[viewport];
+		if (!view.used)
+		{
+			view = Viewport(DrawAheadPredictor(m_tileSize, m_drawAheadTileCount, m_maxDrawAheadTileCount));
+			view.used = true;
+			return viewport;
+		}
+	}
+	return -1;
+}
+
+//
+//  FUNCTION: RemoveViewport
+//
+//  PURPOSE: Removes a view added by AddViewport. What only it needed stays cached until evicted, and work queued for it
+//	alone is dropped when its turn comes, as if the view had moved away.
+//
+void TileScheduler::RemoveViewport(int viewport)
+{
+	if (viewport == DEFAULTVIEWPORT || !IsViewport(viewport))
+	{
+		return;
+	}
+	if (viewport == m_zoomViewport)
+	{
+		EndZoom();
+		m_zoomViewport = DEFAULTVIEWPORT;
+	}
+	m_viewports[viewport].used = false;
+	m_viewports[viewport].requiredRange = TileRange{};
+
+	//Everything queued so far becomes work of an earlier update, which ProcessPendingTiles cuts down to the viewports left.
+	m_tick++;
+}
+
+int TileScheduler::GetViewportCount() const
+{
+	int count = 0;
+	for (Viewport const& view : m_viewports)
+	{
+		count += view.used ? 1 : 0;
+	}
+	return count;
+}
+
+//
+//  FUNCTION: SetInertiaTarget
+//
+//  PURPOSE: Tells the draw ahead predictor where the current inertia is going to come to rest, relative to the origin.
+//
+void TileScheduler::SetInertiaTarget(double restingPositionX, double restingPositionY)
+{
+	SetInertiaTarget(DEFAULTVIEWPORT, restingPositionX, restingPositionY);
+}
+
+void TileScheduler::SetInertiaTarget(int viewport, double restingPositionX, double restingPositionY)
+{
+	if (IsViewport(viewport))
+	{
+		m_viewports[viewport].predictor.SetInertiaTarget(m_frame.ToSurfaceX(restingPositionX), m_frame.ToSurfaceY(restingPositionY));
+	}
+}
+
+//
+//  FUNCTION: SetSurfaceOrigin
+//
+//  PURPOSE: Sets the surface pixel the positions passed in from now on are relative to. The tiles already drawn and queued
+//	are in surface tiles, so they stay valid.
+//
+void TileScheduler::SetSurfaceOrigin(int64_t originX, int64_t originY)
+{
+	for (Viewport& view : m_viewports)
+	{
+		view.positionX = m_frame.ToSurfaceX(view.positionX) - (double)originX;
+		view.positionY = m_frame.ToSurfaceY(view.positionY) - (double)originY;
+	}
+	m_frame.SetOrigin(originX, originY);
+}
+
+SurfaceFrame const& TileScheduler::GetSurfaceFrame() const
+{
+	return m_frame;
+}
+
+//
+//  FUNCTION: RebaseSurface
+//
+//  PURPOSE: Moves the origin onto the given position once it has gone further than SurfaceFrame::REBASEDISTANCE from it.
+//	Returns true when it did, with the shift in pixels, which the caller takes off the positions it passes in from now on,
+//	for every viewport.
+//
+bool TileScheduler::RebaseSurface(double positionX, double positionY, int64_t& shiftX, int64_t& shiftY)
+{
+	if (!m_frame.Rebase(positionX, positionY, shiftX, shiftY))
+	{
+		return false;
+	}
+	for (Viewport& view : m_viewports)
+	{
+		view.positionX -= (double)shiftX;
+		view.positionY -= (double)shiftY;
+	}
+	return true;
+}
+
+//
+//  FUNCTION: ResetDrawAhead
+//
+//  PURPOSE: Forgets the current motion, so the next update uses the base draw ahead on every edge.
+//
+void TileScheduler::ResetDrawAhead()
+{
+	ResetDrawAhead(DEFAULTVIEWPORT);
+}
+
+void TileScheduler::ResetDrawAhead(int viewport)
+{
+	if (IsViewport(viewport))
+	{
+		m_viewports[viewport].predictor.Reset();
+	}
+}
+
+//
+//  FUNCTION: SetFrameBudget
+//
+//  PURPOSE: Sets how long a single call to ProcessPendingTiles may spend drawing. With a budget of 0 every scheduled tile
+//	is drawn straight away, inside the update that scheduled it.
+//
+void TileScheduler::SetFrameBudget(double budgetMs)
+{
+	m_frameBudgetMs = std::max(budgetMs, 0.0);
+}
+
+//
+//  FUNCTION: ProcessPendingTiles
+//
+//  PURPOSE: Draws queued tiles, most urgent first, until the queue is empty or the frame budget is spent. At least one
+//	range is drawn per call so the queue always makes progress. Returns true when work is left for the next frame.
+//	When a frame budget is set this has to be called once per frame, it is the only place queued tiles get drawn. The work
+//	of every viewport is drawn by the same call.
+//
+bool TileScheduler::ProcessPendingTiles()
+{
+	if (m_queue.IsEmpty())
+	{
+		return false;
+	}
+	m_queueStats.peakPendingTiles = std::max(m_queueStats.peakPendingTiles, m_queue.GetPendingTileCount());
+	int drawnTileCount = 0;
+
+	//The spans of the frame and of every draw are timed with the clock reads the budget and the governor need anyway.
+	uint64_t startNs = TileTelemetry::Now();
+	uint64_t endNs = startNs;
+	double elapsedMs = 0.0;
+	TileRange visibleRanges[MAXVIEWPORTCOUNT];
+	int visibleRangeCount = GetVisibleRanges(visibleRanges);
+	TileRange requiredRanges[MAXVIEWPORTCOUNT];
+	int requiredRangeCount = GetRequiredRanges(requiredRanges);
+	TileWork work;
+
+	while (m_queue.Pop(visibleRanges, visibleRangeCount, m_drawAheadTileCount, work))
+	{
+		//Work queued by an earlier update may have been left behind by the viewports since, only what one of them still
+		//requires is drawn. A range that straddles two viewports comes back in pieces, the first is drawn now and the
+		//others go back in the queue.
+		bool required = false;
+		for (int i = 0; i < requiredRangeCount && !required; i++)
+		{
+			required = requiredRanges[i].Contains(work.range);
+		}
+		if (work.level == 0 && work.epoch != m_tick && !required)
+		{
+			m_keepPieces.clear();
+			TileWorkQueue::SplitInside(work.range, requiredRanges, requiredRangeCount, m_keepPieces);
+			CancelTiles(work.range, m_keepPieces);
+			if (m_keepPieces.empty())
+			{
+				continue;
+			}
+			work.range = m_keepPieces[0];
+			for (size_t piece = 1; piece < m_keepPieces.size(); piece++)
+			{
+				m_queue.Push(m_keepPieces[piece], 0, TileRange{}, m_tick);
+			}
+		}
+
+		int tileCount = work.range.TileCount();
+		uint64_t drawStartNs = TileTelemetry::Now();
+		if (work.level == 0)
+		{
+			//Tiles that could not be drawn are forgotten, so the next update schedules them again.
+			if (m_currentRenderer->DrawTileRange(work.range))
+			{
+				m_cache.MarkDrawn(work.range);
+			}
+			else
+			{
+				m_cache.Remove(work.range);
+			}
+		}
+		else
+		{
+			m_currentRenderer->DrawLevelOfDetailRange(work.range, work.level);
+		}
+		uint64_t drawEndNs = TileTelemetry::Now();
+		TileTelemetry::RecordDraw(work.level == 0 ? TileSpan::DrawTileRange : TileSpan::DrawLevelOfDetailRange, drawStartNs, drawEndNs, tileCount);
+		double drawMs = (double)(drawEndNs - drawStartNs) / 1000000.0;
+		m_governor.AddDrawSample(tileCount, drawMs);
+		drawnTileCount += tileCount;
+		endNs = drawEndNs;
+		elapsedMs = (double)(endNs - startNs) / 1000000.0;
+		if (m_frameBudgetMs > 0.0 && elapsedMs >= m_frameBudgetMs)
+		{
+			break;
+		}
+	}
+
+	TileTelemetry::RecordSpan(TileSpan::ProcessPendingTiles, startNs, endNs, drawnTileCount);
+	m_queueStats.frames++;
+	if (m_frameBudgetMs > 0.0 && elapsedMs > m_frameBudgetMs)
+	{
+		m_queueStats.budgetOverruns++;
+	}
+	if (!m_queue.IsEmpty())
+	{
+		m_queueStats.carriedOverFrames++;
+	}
+	if (drawnTileCount > 0)
+	{
+		GovernDrawAhead(elapsedMs, !m_queue.IsEmpty());
+	}
+	//A frame that emptied the queue with time to spare is the moment a deferred trim was waiting for.
+	if (m_queue.IsEmpty() && m_frameBudgetMs > 0.0 && elapsedMs < m_frameBudgetMs)
+	{
+		FlushTrim();
+	}
+	return !m_queue.IsEmpty();
+}
+
+//
+//  FUNCTION: SetAdaptiveDrawAhead
+//
+//  PURPOSE: Lets a DrawAheadGovernor move the draw ahead at rest between the two counts, from the time tiles take to draw
+//	and the time left in the frame. The frame is the frame budget, or DrawAheadGovernor::DEFAULTFRAMETIME without one.
+//	The cache budget bounds it as well. A maximum of 0 goes back to the draw ahead the scheduler was created with.
+//
+void TileScheduler::SetAdaptiveDrawAhead(int minTileCount, int maxTileCount)
+{
+	m_governor.SetLimits(minTileCount, maxTileCount);
+	SetDrawAheadTileCount(m_governor.GetTileCount());
+}
+
+DrawAheadStats TileScheduler::GetDrawAheadStats() const
+{
+	return m_governor.GetStats();
+}
+
+//
+//  FUNCTION: GovernDrawAhead
+//
+//  PURPOSE: Hands the measurements of a frame to the governor, along with the tiles of the next ring around every
+//	viewport and the largest draw ahead whose tiles, with the trim margin around them, fit in the cache budget. The
+//	leading band of a fling comes on top of that for a while. Without a cache budget memory is not a bound.
+//
+void TileScheduler::GovernDrawAhead(double elapsedMs, bool workLeft)
+{
+	TileRange visibleRanges[MAXVIEWPORTCOUNT];
+	int visibleRangeCount = GetVisibleRanges(visibleRanges);
+	int tileCount = m_governor.GetTileCount();
+	int ringTileCount = 0;
+	for (int i = 0; i < visibleRangeCount; i++)
+	{
+		if (!visibleRanges[i].IsEmpty())
+		{
+			ringTileCount += 2 * (visibleRanges[i].numColumns + visibleRanges[i].numRows + 4 * tileCount) + 4;
+		}
+	}
+
+	int memoryTileCount = -1;
+	size_t budgetTiles = m_cache.GetBudget() / m_cache.GetTileBytes();
+	if (budgetTiles > 0)
+	{
+		auto fits = [&](int count)
+		{
+			size_t tiles = 0;
+			int border = 2 * (count + m_cache.GetTrimMargin());
+			for (int i = 0; i < visibleRangeCount; i++)
+			{
+				if (!visibleRanges[i].IsEmpty())
+				{
+					tiles += (size_t)(visibleRanges[i].numColumns + border) * (size_t)(visibleRanges[i].numRows + border);
+				}
+			}
+			return tiles <= budgetTiles;
+		};
+		memoryTileCount = 0;
+		while (memoryTileCount < MAXMEMORYDRAWAHEAD && fits(memoryTileCount + 1))
+		{
+			memoryTileCount++;
+		}
+	}
+
+	tileCount = m_governor.EndFrame(elapsedMs, m_frameBudgetMs, workLeft, ringTileCount, memoryTileCount);
+	TileTelemetry::RecordValue(TileValue::DrawAheadTiles, tileCount);
+	SetDrawAheadTileCount(tileCount);
+}
+
+//The new count is used from the next update of every viewport on.
+void TileScheduler::SetDrawAheadTileCount(int tileCount)
+{
+	if (tileCount == m_drawAheadTileCount)
+	{
+		return;
+	}
+	m_drawAheadTileCount = tileCount;
+	for (Viewport& view : m_viewports)
+	{
+		view.predictor.SetBaseTileCount(tileCount);
+	}
+}
+
+//
+//  FUNCTION: CancelTiles
+//
+//  PURPOSE: Forgets the tiles of a popped range that are outside keepRanges without drawing them. The cache no longer
+//	counts them as scheduled, so they are queued again if a viewport comes back to them.
+//
+void TileScheduler::CancelTiles(TileRange const& range, std::vector<TileRange> const& keepRanges)
+{
+	int keptTileCount = 0;
+	for (TileRange const& keepRange : keepRanges)
+	{
+		keptTileCount += keepRange.TileCount();
+	}
+	for (TileCoordinate coordinate : range)
+	{
+		TileRange tile{ coordinate.column, coordinate.row, 1, 1 };
+		bool kept = false;
+		for (size_t i = 0; i < keepRanges.size() && !kept; i++)
+		{
+			kept = keepRanges[i].Contains(tile);
+		}
+		if (!kept)
+		{
+			m_cache.Remove(tile);
+		}
+	}
+	m_queueStats.cancelledRanges++;
+	CountCancelledTiles(range.TileCount() - keptTileCount);
+}
+
+void TileScheduler::CountCancelledTiles(int tileCount)
+{
+	if (tileCount > 0)
+	{
+		m_queueStats.cancelledTiles += tileCount;
+		TileTelemetry::Add(TileCounter::TilesCancelled, tileCount);
+	}
+}
+
+bool TileScheduler::HasPendingTiles() const
+{
+	return !m_queue.IsEmpty();
+}
+
+TileWorkQueueStats TileScheduler::GetQueueStats() const
+{
+	TileWorkQueueStats stats = m_queueStats;
+	stats.pendingTiles = m_queue.GetPendingTileCount();
+	return stats;
+}
+
+//
+//  FUNCTION: SetCacheBudget
+//
+//  PURPOSE: Sets how much memory the full resolution tiles may hold on to, and how many tiles around the draw ahead band
+//	are never trimmed. With a budget of 0 everything outside that margin is trimmed on every update.
+//
+void TileScheduler::SetCacheBudget(size_t budgetBytes, int trimMarginTiles)
+{
+	m_cache.SetBudget(budgetBytes, trimMarginTiles);
+}
+
+//
+//  FUNCTION: SetTrimDeferral
+//
+//  PURPOSE: Sets how many update batches a trim that is due may wait for a frame with time to spare. A batch is one update
+//	of every viewport that moves, see Trim. 0 trims within the update that went over the budget, as the scheduler used to.
+//
+void TileScheduler::SetTrimDeferral(int batchCount)
+{
+	m_trimDeferral = std::max(batchCount, 0);
+}
+
+TileCacheStats TileScheduler::GetCacheStats() const
+{
+	return m_cache.GetStats();
+}
+
+//
+//  FUNCTION: SetSessionCost
+//
+//  PURPOSE: Sets what a BeginDraw/EndDraw session costs, in tiles, when deciding whether to draw some resident tiles again
+//	so that newly required ones go out in fewer ranges. 0 only merges ranges that fit together exactly.
+//
+void TileScheduler::SetSessionCost(int sessionCostTiles)
+{
+	m_coalescer.SetSessionCost(sessionCostTiles);
+}
+
+//
+//  FUNCTION: SetTileOrder
+//
+//  PURPOSE: Sets the order the blocks of a newly required range are drawn in, see TileOrder. The default, CenterOut,
+//	fills in the middle of the viewport first. Work that is already queued keeps its order.
+//
+void TileScheduler::SetTileOrder(TileOrder order)
+{
+	m_queue.SetOrder(order);
+}
+
+//
+//  FUNCTION: UpdateVisibleRegion
+//
+//  PURPOSE: More unloaded surface is now visible on screen because of some event like manipulations(zoom, pan, etc.). This method, figures
+//	out the new areas that need to be rendered and fires the draw calls. This is the core of the tile drawing logic
+//
+void TileScheduler::UpdateVisibleRegion(double positionX, double positionY, double timeMs)
+{
+	UpdateVisibleRegion(DEFAULTVIEWPORT, positionX, positionY, timeMs);
+}
+
+void TileScheduler::UpdateVisibleRegion(int viewport, double positionX, double positionY, double timeMs)
+{
+	if (!IsViewport(viewport))
+	{
+		return;
+	}
+	TileSpanScope span(TileSpan::UpdateVisibleRegion);
+	Viewport& view = m_viewports[viewport];
+	view.positionX = positionX;
+	view.positionY = positionY;
+
+	view.predictor.AddPositionSample(timeMs, m_frame.ToSurfaceX(positionX), m_frame.ToSurfaceY(positionY));
+	view.margins = view.predictor.GetMargins();
+
+	span.SetArgument(UpdateRequiredTiles(viewport));
+	Trim(viewport);
+
+	//Without a frame budget the tiles are drawn right away, otherwise they wait for the next frame.
+	if (m_frameBudgetMs == 0.0)
+	{
+		ProcessPendingTiles();
+	}
+}
+
+//
+//  FUNCTION: UpdateViewportSize
+//
+//  PURPOSE: Updates the Viewport Size of the application.
+//
+void TileScheduler::UpdateViewportSize(float width, float height)
+{
+	UpdateViewportSize(DEFAULTVIEWPORT, width, height);
+}
+
+void TileScheduler::UpdateViewportSize(int viewport, float width, float height)
+{
+	if (!IsViewport(viewport))
+	{
+		return;
+	}
+	Viewport& view = m_viewports[viewport];
+	view.width = width;
+	view.height = height;
+
+	//A new viewport size usually comes with a new scale, which makes the positions seen so far meaningless for prediction.
+	view.predictor.Reset();
+
+	if (viewport == m_zoomViewport)
+	{
+		EndZoom();
+	}
+
+	view.margins = view.predictor.GetMargins();
+	UpdateRequiredTiles(viewport);
+	if (m_frameBudgetMs == 0.0)
+	{
+		ProcessPendingTiles();
+	}
+}
+
+//
+//  FUNCTION: EndZoom
+//
+//  PURPOSE: The zoom is over. Coarse tiles that are still queued would only be covered by the full resolution ones drawn
+//	next, what is already drawn stays as a backdrop until the next zoom trims it.
+//
+void TileScheduler::EndZoom()
+{
+	m_zoomLevel = 0;
+	for (int level = 1; level <= m_levelOfDetailCount; level++)
+	{
+		CountCancelledTiles(m_queue.Clip(TileRange{}, level));
+		m_levelDrawnRanges[level] = TileRange{};
+	}
+}
+
+void TileScheduler::SetLevelOfDetailCount(int levelCount)
+{
+	m_levelOfDetailCount = std::min(std::max(levelCount, 0), (int)MAXLEVELOFDETAILCOUNT);
+}
+
+int TileScheduler::GetZoomLevel() const
+{
+	return m_zoomLevel;
+}
+
+//
+//  FUNCTION: GetLevelForScale
+//
+//  PURPOSE: Picks the level of detail for a zoom scale. Level n has one texel for every 2^n surface pixels, the level is
+//	the first one that is not more detailed than the screen, so zooming out never costs more than filling the window once.
+//
+int TileScheduler::GetLevelForScale(float scale, int levelCount)
+{
+	if (scale >= 1.0f || levelCount <= 0)
+	{
+		return 0;
+	}
+	int level = (int)std::ceil(std::log2(1.0f / scale));
+	return std::min(std::max(level, 0), levelCount);
+}
+
+//
+//  FUNCTION: UpdateZoom
+//
+//  PURPOSE: Called instead of UpdateVisibleRegion while the scale is changing. Position and viewport are in surface pixels
+//	at the new scale. When zooming out shows more than the full resolution tiles cover, the viewport is filled with tiles
+//	of the level picked by GetLevelForScale. Only the viewport itself is covered, there is no draw ahead during a zoom.
+//	The renderer has one surface per level, so the coarse levels follow whichever viewport zoomed last.
+//
+void TileScheduler::UpdateZoom(double positionX, double positionY, float viewportWidth, float viewportHeight, float scale)
+{
+	UpdateZoom(DEFAULTVIEWPORT, positionX, positionY, viewportWidth, viewportHeight, scale);
+}
+
+void TileScheduler::UpdateZoom(int viewport, double positionX, double positionY, float viewportWidth, float viewportHeight, float scale)
+{
+	int level = GetLevelForScale(scale, m_levelOfDetailCount);
+	if (level == 0 || !IsViewport(viewport))
+	{
+		return;
+	}
+	TileSpanScope span(TileSpan::UpdateZoom);
+
+	TileRange requiredRange = GetCoveredRange(positionX, positionY, viewportWidth, viewportHeight, m_tileSize << level);
+
+	m_zoomViewport = viewport;
+	m_zoomLevel = level;
+	m_zoomVisibleRange = requiredRange.FromLevel(level);
+
+	//Queues what is not drawn at this level yet, skipping the parts the resident full resolution tiles already cover.
+	TileRange drawnRange = m_levelDrawnRanges[level];
+	TileRange pieces[4];
+	int pieceCount = Subtract(requiredRange, drawnRange, pieces);
+	int scheduledTileCount = 0;
+	for (int i = 0; i < pieceCount; i++)
+	{
+		if (!m_cache.IsDrawn(pieces[i].FromLevel(level)))
+		{
+			m_queue.Push(pieces[i], level, m_zoomVisibleRange, m_tick);
+			scheduledTileCount += pieces[i].TileCount();
+		}
+	}
+	span.SetArgument(scheduledTileCount);
+
+	if (!drawnRange.IsEmpty() && !requiredRange.Contains(drawnRange))
+	{
+		CountCancelledTiles(m_queue.Clip(requiredRange, level));
+		m_currentRenderer->TrimLevelOfDetail(requiredRange, level);
+	}
+	m_levelDrawnRanges[level] = requiredRange;
+
+	if (m_frameBudgetMs == 0.0)
+	{
+		ProcessPendingTiles();
+	}
+}
+
+//
+//  FUNCTION: Subtract
+//
+//  PURPOSE: Splits the tiles of range that are not in hole into at most four ranges: the rows above and below the hole,
+//	then the columns left and right of it. Returns the number of ranges written to pieces.
+//
+int TileScheduler::Subtract(TileRange const& range, TileRange const& hole, TileRange pieces[4])
+{
+	TileRange overlap = range.Intersect(hole);
+	if (overlap.IsEmpty())
+	{
+		pieces[0] = range;
+		return 1;
+	}
+
+	int count = 0;
+	int rangeRight = range.startColumn + range.numColumns;
+	int rangeBottom = range.startRow + range.numRows;
+	int overlapRight = overlap.startColumn + overlap.numColumns;
+	int overlapBottom = overlap.startRow + overlap.numRows;
+	TileRange candidates[4] = {
+		{ range.startColumn, range.startRow, range.numColumns, overlap.startRow - range.startRow },
+		{ range.startColumn, overlapBottom, range.numColumns, rangeBottom - overlapBottom },
+		{ range.startColumn, overlap.startRow, overlap.startColumn - range.startColumn, overlap.numRows },
+		{ overlapRight, overlap.startRow, rangeRight - overlapRight, overlap.numRows } };
+	for (TileRange const& candidate : candidates)
+	{
+		if (!candidate.IsEmpty())
+		{
+			pieces[count++] = candidate;
+		}
+	}
+	return count;
+}
+
+//
+//  FUNCTION: UpdateRequiredTiles
+//
+//  PURPOSE: Works out the tiles that have to be on the surface at the current position of a viewport, the visible ones
+//	plus the draw ahead margins, and queues the ones the cache does not hold, which includes the ones another viewport
+//	has queued or drawn already. Missing tiles are gathered column by column into runs, and
+//	the TileRegionCoalescer turns those into as few ranges as is worth it, so a newly exposed strip, or the L shape left
+//	by a diagonal pan, goes out in one range when that is cheaper than drawing it in pieces. Returns the number of tiles
+//	queued.
+//
+int TileScheduler::UpdateRequiredTiles(int viewport)
+{
+	Viewport& view = m_viewports[viewport];
+	TileRange viewportRange = GetCoveredRange(view.positionX, view.positionY, view.width, view.height, m_tileSize);
+	int requiredTopTileRow = std::max(viewportRange.startRow - view.margins.top, 0);
+	int requiredBottomTileRow = viewportRange.startRow + viewportRange.numRows - 1 + view.margins.bottom;
+	int requiredLeftTileColumn = std::max(viewportRange.startColumn - view.margins.left, 0);
+	int requiredRightTileColumn = viewportRange.startColumn + viewportRange.numColumns - 1 + view.margins.right;
+	TileRange requiredRange{
+		requiredLeftTileColumn,
+		requiredTopTileRow,
+		requiredRightTileColumn - requiredLeftTileColumn + 1,
+		requiredBottomTileRow - requiredTopTileRow + 1 };
+
+	m_tick++;
+	m_missRanges.clear();
+	for (int column = requiredRange.startColumn; column <= requiredRightTileColumn; column++)
+	{
+		int runStart = -1;
+		for (int row = requiredRange.startRow; row <= requiredBottomTileRow + 1; row++)
+		{
+			bool missing = false;
+			if (row <= requiredBottomTileRow && !m_cache.Touch(column, row, m_tick))
+			{
+				m_cache.Schedule(column, row, m_tick);
+				missing = true;
+			}
+			//Only tiles that just came into range count towards the hit rate, the others were counted already.
+			if (row <= requiredBottomTileRow && !view.requiredRange.Contains(TileRange{ column, row, 1, 1 }))
+			{
+				m_cache.RecordLookup(!missing);
+			}
+
+			if (missing && runStart < 0)
+			{
+				runStart = row;
+			}
+			else if (!missing && runStart >= 0)
+			{
+				m_missRanges.push_back(TileRange{ column, runStart, 1, row - runStart });
+				runStart = -1;
+			}
+		}
+	}
+	TileRange visibleRange = GetVisibleRange(viewport);
+	m_coalescer.Coalesce(m_missRanges, &m_queue, visibleRange);
+
+	int scheduledTileCount = 0;
+	for (TileRange const& range : m_missRanges)
+	{
+		m_queue.Push(range, 0, visibleRange, m_tick);
+		scheduledTileCount += range.TileCount();
+	}
+	//Most updates schedule nothing, those are left out of the histogram rather than paid for on every one of them.
+	if (scheduledTileCount > 0)
+	{
+		TileTelemetry::RecordValue(TileValue::TilesPerUpdate, scheduledTileCount);
+	}
+
+	view.requiredRange = requiredRange;
+	return scheduledTileCount;
+}
+
+//
+//  FUNCTION: Trim
+//
+//  PURPOSE: Called on every position update of a viewport. Updates of several viewports that come together, one after the
+//	other for the same frame, make one update batch, numbered by the updates of the viewport that has had the most. A
+//	viewport left behind catches up to one short of that, so it joins the next batch rather than starting batches of its
+//	own. The budget is only checked once the batch is complete, see IsUpdateBatchComplete, and the trim deferral is
+//	counted in batches, so two viewports in the same place trim exactly as one would.
+//	Once the cache is over its budget, a trim becomes due. It is left to FlushTrim from a frame with time to spare or
+//	from the tracker going idle, and only run here when it has waited for the trim deferral, or when the cache has gone
+//	EVICTIONPERCENT over its budget, so memory stays bounded during a long fling. With a cache budget of 0 the trim is
+//	never deferred.
+//
+void TileScheduler::Trim(int viewport)
+{
+	Viewport& view = m_viewports[viewport];
+	view.updateBatch = std::max(view.updateBatch + 1, m_updateBatch > 0 ? m_updateBatch - 1 : 0);
+	m_updateBatch = std::max(m_updateBatch, view.updateBatch);
+	if (!IsUpdateBatchComplete())
+	{
+		return;
+	}
+
+	size_t budgetTiles = m_cache.GetBudget() / m_cache.GetTileBytes();
+	size_t tileCount = (size_t)m_cache.GetTileCount();
+	if (tileCount <= budgetTiles)
+	{
+		m_trimDue = false;
+		return;
+	}
+	if (!m_trimDue)
+	{
+		m_trimDue = true;
+		m_trimDueBatch = m_updateBatch;
+	}
+	if (tileCount > budgetTiles + budgetTiles * TileResidencyCache::EVICTIONPERCENT / 100 ||
+		m_updateBatch - m_trimDueBatch >= (uint32_t)m_trimDeferral)
+	{
+		RunTrim();
+	}
+}
+
+//
+//  FUNCTION: FlushTrim
+//
+//  PURPOSE: Runs the trim that is due, if any, outside of an update. The samples call it when the tracker goes idle. It
+//	waits for the update batch to be complete as well, a trim in the middle of one would only keep what the viewports
+//	updated so far require.
+//
+void TileScheduler::FlushTrim()
+{
+	if (m_trimDue && IsUpdateBatchComplete() && RunTrim())
+	{
+		TileTelemetry::Add(TileCounter::TrimsDeferred);
+	}
+}
+
+//
+//  FUNCTION: IsUpdateBatchComplete
+//
+//  PURPOSE: Whether every viewport that took part in the last update batch has been updated in the current one. One
+//	that was not updated in the last batch either is taken as idle and not waited for.
+//
+bool TileScheduler::IsUpdateBatchComplete() const
+{
+	for (Viewport const& view : m_viewports)
+	{
+		if (view.used && view.updateBatch + 1 == m_updateBatch)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//
+//  FUNCTION: RunTrim
+//
+//  PURPOSE: Lets the cache evict tiles, and trims the surface down to what the cache still holds in a single call, with
+//	the fewest keep ranges the cache can make of it. Nothing within the trim margin around the required range of any
+//	viewport is ever trimmed. Returns true when the renderer was asked to trim.
+//
+bool TileScheduler::RunTrim()
+{
+	m_trimDue = false;
+	int margin = m_cache.GetTrimMargin();
+	TileRange protectedRanges[MAXVIEWPORTCOUNT];
+	int protectedRangeCount = GetRequiredRanges(protectedRanges);
+	for (int i = 0; i < protectedRangeCount; i++)
+	{
+		TileRange& range = protectedRanges[i];
+		range = TileRange{ range.startColumn - margin, range.startRow - margin, range.numColumns + 2 * margin, range.numRows + 2 * margin };
+	}
+
+	if (m_cache.Evict(protectedRanges, protectedRangeCount))
+	{
+		std::vector<TileRange> const& keepRanges = m_cache.GetKeepRanges();
+		//Queued tiles outside the protected ranges were dropped by the cache, they are not drawn either.
+		CountCancelledTiles(m_queue.Clip(protectedRanges, protectedRangeCount, 0));
+		int keptTileCount = 0;
+		for (TileRange const& range : keepRanges)
+		{
+			keptTileCount += range.TileCount();
+		}
+		TileSpanScope span(TileSpan::Trim, keptTileCount);
+		TileTelemetry::Add(TileCounter::TrimCalls);
+		m_currentRenderer->Trim(keepRanges);
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,173 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "DrawAheadGovernor.h"
+#include "DrawAheadPredictor.h"
+#include "ITileRenderer.h"
+#include "SurfaceFrame.h"
+#include "TileRegionCoalescer.h"
+#include "TileResidencyCache.h"
+#include "TileWorkQueue.h"
+
+//
+//  CLASS: TileScheduler
+//
+//  PURPOSE: Platform neutral core of the tile drawing logic. Given the viewport size and the current position (both in
+//	surface pixels), it works out which tiles are visible, which ones are drawn ahead of the viewport and which ones can be
+//	trimmed, and hands that work to an ITileRenderer. It has no dependency on winrt or DirectX, so it can be driven headless.
+//	The draw ahead band is sized by a DrawAheadPredictor from the recent motion, between drawAheadTileCount when the content
+//	is at rest and maxDrawAheadTileCount on the leading edge of a fast fling. With SetAdaptiveDrawAhead, the count at rest
+//	is moved at runtime by a DrawAheadGovernor, from what tiles cost to draw and how much of the frame is left over.
+//	Tiles are not drawn as soon as they are scheduled. They go through a TileWorkQueue that renders visible tiles first and
+//	stops once the frame budget is spent; the remainder is drawn by the next calls to ProcessPendingTiles. Queued work is
+//	stamped with the update that queued it, and work left over from an earlier update is cut down to the current required
+//	range before it is drawn, so a fling that outruns the renderer does not pay for strips it has already left behind.
+//	Which tiles the surface holds is tracked by a TileResidencyCache. Tiles that leave the draw ahead band stay resident
+//	until the cache goes over its budget, so going back over an area does not draw it again. Going over the budget does
+//	not trim straight away either: the eviction and the Trim call wait for a frame with time to spare, the tracker going
+//	idle, or at most the trim deferral in update batches, so a pan does not pay for them in its input callbacks.
+//	While zooming out, the full resolution tiles are left alone and UpdateZoom fills the viewport with tiles from a coarser
+//	level of detail instead, picked from the scale so the number of tiles per frame stays about the same at any zoom.
+//	Positions are relative to a 64 bit surface origin held by a SurfaceFrame, and tile columns and rows are worked out
+//	from whole surface pixels, so they stay exact on surfaces far larger than a float can address to the pixel.
+//	Several viewports can look at the same surface, a main view and a minimap or split panes. Each one has its own
+//	position, size and draw ahead, and all of them share the cache and the queue: a tile needed by two viewports is drawn
+//	once, queued work is ordered by the viewport it is closest to, and eviction keeps what any viewport still needs. The
+//	methods without a viewport argument work on DEFAULTVIEWPORT, which always exists.
+//
+class TileScheduler
+{
+public:
+	TileScheduler(int tileSize, int drawAheadTileCount, int maxDrawAheadTileCount);
+	void UpdateVisibleRegion(double positionX, double positionY, double timeMs);
+	void UpdateViewportSize(float width, float height);
+	void UpdateZoom(double positionX, double positionY, float viewportWidth, float viewportHeight, float scale);
+	void SetLevelOfDetailCount(int levelCount);
+	int GetZoomLevel() const;
+	void SetInertiaTarget(double restingPositionX, double restingPositionY);
+	int AddViewport();
+	void RemoveViewport(int viewport);
+	int GetViewportCount() const;
+	void UpdateVisibleRegion(int viewport, double positionX, double positionY, double timeMs);
+	void UpdateViewportSize(int viewport, float width, float height);
+	void UpdateZoom(int viewport, double positionX, double positionY, float viewportWidth, float viewportHeight, float scale);
+	void SetInertiaTarget(int viewport, double restingPositionX, double restingPositionY);
+	void ResetDrawAhead(int viewport);
+	TileRange GetVisibleRange(int viewport) const;
+	DrawAheadMargins GetDrawAheadMargins(int viewport) const;
+	void SetSurfaceOrigin(int64_t originX, int64_t originY);
+	SurfaceFrame const& GetSurfaceFrame() const;
+	bool RebaseSurface(double positionX, double positionY, int64_t& shiftX, int64_t& shiftY);
+	void ResetDrawAhead();
+	void SetFrameBudget(double budgetMs);
+	void SetAdaptiveDrawAhead(int minTileCount, int maxTileCount);
+	DrawAheadStats GetDrawAheadStats() const;
+	bool ProcessPendingTiles();
+	bool HasPendingTiles() const;
+	TileWorkQueueStats GetQueueStats() const;
+	void SetCacheBudget(size_t budgetBytes, int trimMarginTiles);
+	void SetTrimDeferral(int batchCount);
+	void FlushTrim();
+	TileCacheStats GetCacheStats() const;
+	void SetSessionCost(int sessionCostTiles);
+	void SetTileOrder(TileOrder order);
+	void SetRenderer(ITileRenderer* renderer);
+	ITileRenderer* GetRenderer();
+	void SetTileSize(int tileSize);
+	void Invalidate();
+	int GetTileSize() const;
+	TileRange GetVisibleRange() const;
+	DrawAheadMargins GetDrawAheadMargins() const;
+
+	static int GetLevelForScale(float scale, int levelCount);
+
+	//Largest block of tiles rendered in a single DrawTileRange call.
+	const static int MAXTILESPERDRAW = 16;
+	//Highest number of coarse levels of detail supported.
+	const static int MAXLEVELOFDETAILCOUNT = 4;
+	//Highest number of viewports over the same surface.
+	const static int MAXVIEWPORTCOUNT = 4;
+	//Viewport used by the methods that do not take one.
+	const static int DEFAULTVIEWPORT = 0;
+	//Update batches a trim may wait for a better moment once the cache is over its budget.
+	const static int DEFAULTTRIMDEFERRAL = 8;
+
+private:
+	//What the scheduler keeps for each view of the surface.
+	struct Viewport
+	{
+		explicit Viewport(DrawAheadPredictor const& viewPredictor) :
+			predictor(viewPredictor),
+			margins(viewPredictor.GetMargins())
+		{
+		}
+
+		DrawAheadPredictor  predictor;
+		DrawAheadMargins    margins;//Margins used by the last update
+		TileRange           requiredRange;//Visible tiles plus draw ahead at the last update
+		double              positionX = 0.0;//Current position, relative to the origin of m_frame
+		double              positionY = 0.0;
+		float               width = 0.0f;
+		float               height = 0.0f;
+		uint32_t            updateBatch = 0;//Update batch it was last updated in
+		bool                used = false;
+	};
+
+	bool IsViewport(int viewport) const;
+	TileRange GetCoveredRange(double positionX, double positionY, double width, double height, int tileSize) const;
+	int GetVisibleRanges(TileRange visibleRanges[MAXVIEWPORTCOUNT]) const;
+	int GetRequiredRanges(TileRange requiredRanges[MAXVIEWPORTCOUNT]) const;
+	int UpdateRequiredTiles(int viewport);
+	void GovernDrawAhead(double elapsedMs, bool workLeft);
+	void SetDrawAheadTileCount(int tileCount);
+	void Trim(int viewport);
+	bool IsUpdateBatchComplete() const;
+	void DropTiles();
+	bool RunTrim();
+	void EndZoom();
+	void CancelTiles(TileRange const& range, std::vector<TileRange> const& keepRanges);
+	void CountCancelledTiles(int tileCount);
+	static int Subtract(TileRange const& range, TileRange const& hole, TileRange pieces[4]);
+
+	//member variables
+	int                     m_tileSize;
+	int                     m_drawAheadTileCount;//Number of tiles to draw ahead when the content is not moving
+	int                     m_maxDrawAheadTileCount;
+	DrawAheadGovernor       m_governor;//Moves m_drawAheadTileCount once SetAdaptiveDrawAhead turns it on
+	std::vector<Viewport>   m_viewports;//MAXVIEWPORTCOUNT slots, the unused ones are kept for AddViewport
+	TileWorkQueue           m_queue{ MAXTILESPERDRAW };
+	double                  m_frameBudgetMs = 0.0;//Time ProcessPendingTiles may spend drawing, 0 draws everything
+	TileWorkQueueStats      m_queueStats;
+	TileResidencyCache      m_cache;
+	int                     m_trimDeferral = DEFAULTTRIMDEFERRAL;
+	bool                    m_trimDue = false;//The cache went over its budget and nothing was evicted yet
+	uint32_t                m_trimDueBatch = 0;//Update batch it went over in
+	uint32_t                m_updateBatch = 0;//Most updates any viewport has had, so views updated together count once
+	TileRegionCoalescer     m_coalescer;
+	uint32_t                m_tick = 0;//Incremented on every update, used as the last use time of the tiles and as the epoch of queued work
+	std::vector<TileRange>  m_missRanges;//Scratch space for UpdateRequiredTiles
+	std::vector<TileRange>  m_keepRanges;//Always empty, for the Trim that discards everything
+	std::vector<TileRange>  m_keepPieces;//Scratch space for ProcessPendingTiles
+
+	int                     m_levelOfDetailCount = 0;//Number of coarse levels the renderer supports, 0 disables them
+	int                     m_zoomLevel = 0;//Level used by the zoom in progress, 0 when not zooming
+	int                     m_zoomViewport = DEFAULTVIEWPORT;//Viewport the coarse levels are drawn for
+	TileRange               m_zoomVisibleRange;//Visible tiles during the zoom, in level 0 tiles
+	TileRange               m_levelDrawnRanges[MAXLEVELOFDETAILCOUNT + 1];//Tiles drawn at each coarse level, in tiles of that level
+
+	SurfaceFrame            m_frame;//Origin the positions of every viewport are relative to
+
+	ITileRenderer*          m_currentRenderer = nullptr;
+};
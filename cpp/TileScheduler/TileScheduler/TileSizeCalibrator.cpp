@@ -0,0 +1,134 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileSizeCalibrator.h"
+
+#include <algorithm>
+#include <cmath>
+
+//
+//  FUNCTION: Calibrate
+//
+//  PURPOSE: Times the probe at every power of two size from MINTILESIZE to MAXTILESIZE and solves for the best size at
+//	the given viewport. The probe is expected to draw the way the renderer does, on the thread that will draw the tiles.
+//
+TileSizeCalibration TileSizeCalibrator::Calibrate(ITileCostProbe& probe, int viewportWidth, int viewportHeight, int drawAheadTileCount, bool powerOfTwoOnly)
+{
+	Clear();
+	for (int tileSize = MINTILESIZE; tileSize <= MAXTILESIZE; tileSize *= 2)
+	{
+		double fastestUs = -1.0;
+		for (int i = 0; i < PROBEREPEATCOUNT; i++)
+		{
+			double elapsedUs = probe.MeasureTilesUs(tileSize, PROBETILECOUNT);
+			if (elapsedUs >= 0.0 && (fastestUs < 0.0 || elapsedUs < fastestUs))
+			{
+				fastestUs = elapsedUs;
+			}
+		}
+		if (fastestUs >= 0.0)
+		{
+			AddSample(tileSize, PROBETILECOUNT, fastestUs);
+		}
+	}
+	return Solve(viewportWidth, viewportHeight, drawAheadTileCount, powerOfTwoOnly);
+}
+
+void TileSizeCalibrator::AddSample(int tileSize, int tileCount, double elapsedUs)
+{
+	if (tileSize > 0 && tileCount > 0)
+	{
+		m_samples.push_back(Sample{ tileSize, elapsedUs / tileCount });
+	}
+}
+
+void TileSizeCalibrator::Clear()
+{
+	m_samples.clear();
+}
+
+//
+//  FUNCTION: PredictFillCostUs
+//
+//  PURPOSE: Cost of drawing every tile needed to cover the viewport and its draw ahead. The viewport is not aligned on
+//	tiles, so it touches one more column and row than it would if it were, on average.
+//
+double TileSizeCalibrator::PredictFillCostUs(int tileSize, double tileCostUs, double pixelCostNs, int viewportWidth, int viewportHeight, int drawAheadTileCount)
+{
+	double columns = std::ceil((double)viewportWidth / tileSize) + 1 + 2 * drawAheadTileCount;
+	double rows = std::ceil((double)viewportHeight / tileSize) + 1 + 2 * drawAheadTileCount;
+	double pixels = (double)tileSize * tileSize;
+	return columns * rows * (tileCostUs + pixels * pixelCostNs / 1000.0);
+}
+
+//
+//  FUNCTION: Solve
+//
+//  PURPOSE: Fits cost per tile = tileCost + pixelCost * pixels by least squares through the samples, then picks the
+//	candidate size with the lowest predicted fill cost. Both costs are kept positive, measurements noisy enough to give a
+//	negative one are fitted with that cost at 0 instead. Without samples the default size is returned.
+//
+TileSizeCalibration TileSizeCalibrator::Solve(int viewportWidth, int viewportHeight, int drawAheadTileCount, bool powerOfTwoOnly) const
+{
+	TileSizeCalibration calibration;
+	calibration.tileSize = DEFAULTTILESIZE;
+	calibration.sampleCount = (int)m_samples.size();
+	if (m_samples.empty())
+	{
+		return calibration;
+	}
+
+	//Pixels are counted in thousands to keep the sums well within the precision of a double.
+	double n = (double)m_samples.size();
+	double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+	for (Sample const& sample : m_samples)
+	{
+		double x = (double)sample.tileSize * sample.tileSize / 1000.0;
+		sumX += x;
+		sumY += sample.tileUs;
+		sumXX += x * x;
+		sumXY += x * sample.tileUs;
+	}
+	double denominator = n * sumXX - sumX * sumX;
+	double slope = denominator > 0.0 ? (n * sumXY - sumX * sumY) / denominator : 0.0;
+	double intercept = (sumY - slope * sumX) / n;
+	if (slope < 0.0)
+	{
+		slope = 0.0;
+		intercept = sumY / n;
+	}
+	else if (intercept < 0.0)
+	{
+		intercept = 0.0;
+		slope = sumXX > 0.0 ? sumXY / sumXX : 0.0;
+	}
+	calibration.tileCostUs = intercept;
+	calibration.pixelCostNs = slope;//Microseconds per thousand pixels
+
+	double bestCost = -1.0;
+	for (int tileSize = MINTILESIZE; tileSize <= MAXTILESIZE; tileSize += TILESIZESTEP)
+	{
+		if (powerOfTwoOnly && (tileSize & (tileSize - 1)) != 0)
+		{
+			continue;
+		}
+		double cost = PredictFillCostUs(tileSize, calibration.tileCostUs, calibration.pixelCostNs, viewportWidth, viewportHeight, drawAheadTileCount);
+		if (bestCost < 0.0 || cost < bestCost)
+		{
+			bestCost = cost;
+			calibration.tileSize = tileSize;
+		}
+	}
+	calibration.fillCostUs = bestCost;
+	return calibration;
+}
@@ -0,0 +1,88 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <vector>
+
+//
+//  CLASS: ITileCostProbe
+//
+//  PURPOSE: Draws tiles of a given size the way the renderer really does, for the TileSizeCalibrator to time. The
+//	samples implement it on their DirectXTileRenderer, the benchmark on the CPU rasterizer.
+//
+class ITileCostProbe
+{
+public:
+	virtual ~ITileCostProbe() = default;
+
+	//Draws tileCount tiles of tileSize pixels in a single range and returns how long that took on the calling thread, in
+	//microseconds, or a negative value when nothing could be drawn.
+	virtual double MeasureTilesUs(int tileSize, int tileCount) = 0;
+};
+
+//
+//  STRUCT: TileSizeCalibration
+//
+//  PURPOSE: Result of a calibration: the cost model fitted to the measurements and the tile size it picked. Keeping the
+//	model along with the size lets a size measured once be pinned for a whole class of machines.
+//
+struct TileSizeCalibration
+{
+	int    tileSize = 0;//Tile size picked, in pixels
+	double tileCostUs = 0.0;//Fixed cost of drawing a tile, whatever its size
+	double pixelCostNs = 0.0;//Cost of every pixel of a tile
+	double fillCostUs = 0.0;//Predicted cost of filling the viewport and its draw ahead with tiles of that size
+	int    sampleCount = 0;//Measurements the model was fitted to
+};
+
+//
+//  CLASS: TileSizeCalibrator
+//
+//  PURPOSE: Picks the tile size from what tiles cost on this machine. Every tile has a fixed cost (a FillRectangle and a
+//	DrawText in the Virtual Surfaces sample, whatever the size) and a cost per pixel. Small tiles pay the fixed cost more
+//	often, large tiles draw more pixels that are not on screen, since the tiles on the edges of the viewport stick out
+//	and the draw ahead band is counted in tiles. Tiles of a few sizes are timed, a line is fitted through the cost per
+//	tile against its number of pixels, and the size that fills the viewport and its draw ahead for the least is picked.
+//	Candidate sizes are multiples of TILESIZESTEP, so a tile is always a whole number of 64 pixel blocks, or powers of two.
+//
+class TileSizeCalibrator
+{
+public:
+	TileSizeCalibration Calibrate(ITileCostProbe& probe, int viewportWidth, int viewportHeight, int drawAheadTileCount, bool powerOfTwoOnly);
+	void AddSample(int tileSize, int tileCount, double elapsedUs);
+	void Clear();
+	TileSizeCalibration Solve(int viewportWidth, int viewportHeight, int drawAheadTileCount, bool powerOfTwoOnly) const;
+
+	static double PredictFillCostUs(int tileSize, double tileCostUs, double pixelCostNs, int viewportWidth, int viewportHeight, int drawAheadTileCount);
+
+	//Tile size used until a calibration says otherwise.
+	const static int DEFAULTTILESIZE = 256;
+	//Range and granularity of the sizes considered.
+	const static int MINTILESIZE = 64;
+	const static int MAXTILESIZE = 1024;
+	const static int TILESIZESTEP = 64;
+	//Tiles drawn by every measurement, and number of times each size is measured. The fastest run of a size is kept.
+	const static int PROBETILECOUNT = 8;
+	const static int PROBEREPEATCOUNT = 3;
+
+private:
+	struct Sample
+	{
+		int     tileSize;
+		double  tileUs;//Cost of a single tile
+	};
+
+	//member variables
+	std::vector<Sample>     m_samples;
+};
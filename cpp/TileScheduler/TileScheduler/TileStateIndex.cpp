@@ -0,0 +1,273 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileStateIndex.h"
+
+#include <algorithm>
+
+TileStateIndex::TileStateIndex()
+{
+	m_slots.resize(INITIALBLOCKCOUNT * 2);
+	m_mask = m_slots.size() - 1;
+	m_blocks.reserve(INITIALBLOCKCOUNT);
+	m_freeBlocks.reserve(INITIALBLOCKCOUNT);
+}
+
+uint64_t TileStateIndex::BlockKey(int blockColumn, int blockRow)
+{
+	return ((uint64_t)(uint32_t)blockColumn << 32) | (uint32_t)blockRow;
+}
+
+//Bits firstColumn to lastColumn included, both within a block.
+uint64_t TileStateIndex::ColumnMask(int firstColumn, int lastColumn)
+{
+	uint64_t upTo = lastColumn == BLOCKSIZE - 1 ? ~0ull : (1ull << (lastColumn + 1)) - 1;
+	return upTo & ~((1ull << firstColumn) - 1);
+}
+
+bool TileStateIndex::IsClear(Block const& block)
+{
+	uint64_t bits = 0;
+	for (int row = 0; row < BLOCKSIZE; row++)
+	{
+		bits |= block.lowBits[row] | block.highBits[row];
+	}
+	return bits == 0;
+}
+
+size_t TileStateIndex::HomeSlot(uint64_t key) const
+{
+	return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & m_mask;
+}
+
+int TileStateIndex::FindBlock(int blockColumn, int blockRow) const
+{
+	uint64_t key = BlockKey(blockColumn, blockRow);
+	size_t slot = HomeSlot(key);
+	while (m_slots[slot].index >= 0)
+	{
+		if (m_slots[slot].key == key)
+		{
+			return m_slots[slot].index;
+		}
+		slot = (slot + 1) & m_mask;
+	}
+	return -1;
+}
+
+int TileStateIndex::GetOrCreateBlock(int blockColumn, int blockRow)
+{
+	int index = FindBlock(blockColumn, blockRow);
+	if (index >= 0)
+	{
+		return index;
+	}
+
+	//Keeps the table at most half full, so probe sequences stay short.
+	if ((GetBlockCount() + 1) * 2 > m_slots.size())
+	{
+		GrowSlots();
+	}
+
+	uint64_t key = BlockKey(blockColumn, blockRow);
+	size_t slot = HomeSlot(key);
+	while (m_slots[slot].index >= 0)
+	{
+		slot = (slot + 1) & m_mask;
+	}
+	m_slots[slot].key = key;
+	if (!m_freeBlocks.empty())
+	{
+		m_slots[slot].index = m_freeBlocks.back();
+		m_freeBlocks.pop_back();
+	}
+	else
+	{
+		m_slots[slot].index = (int)m_blocks.size();
+		m_blocks.push_back(Block{});
+		//Room for every block to be freed, so freeing one never allocates.
+		m_freeBlocks.reserve(m_blocks.capacity());
+	}
+	return m_slots[slot].index;
+}
+
+//
+//  FUNCTION: FreeBlock
+//
+//  PURPOSE: Takes a block whose tiles are all Empty out of the table and puts it on the free list. The entries after it
+//	in its probe sequence are shifted back into the gap when their home slot allows it, so every block can still be
+//	found without tombstones.
+//
+void TileStateIndex::FreeBlock(int blockColumn, int blockRow)
+{
+	uint64_t key = BlockKey(blockColumn, blockRow);
+	size_t hole = HomeSlot(key);
+	while (m_slots[hole].index >= 0 && m_slots[hole].key != key)
+	{
+		hole = (hole + 1) & m_mask;
+	}
+	if (m_slots[hole].index < 0)
+	{
+		return;
+	}
+	m_freeBlocks.push_back(m_slots[hole].index);
+
+	for (size_t slot = (hole + 1) & m_mask; m_slots[slot].index >= 0; slot = (slot + 1) & m_mask)
+	{
+		//An entry may move back to the hole unless its home slot lies after the hole, up to the entry itself.
+		size_t home = HomeSlot(m_slots[slot].key);
+		if (((slot - home) & m_mask) >= ((slot - hole) & m_mask))
+		{
+			m_slots[hole] = m_slots[slot];
+			hole = slot;
+		}
+	}
+	m_slots[hole] = BlockSlot{};
+}
+
+void TileStateIndex::GrowSlots()
+{
+	std::vector<BlockSlot> oldSlots;
+	oldSlots.swap(m_slots);
+	m_slots.resize(oldSlots.size() * 2);
+	m_mask = m_slots.size() - 1;
+	for (BlockSlot const& oldSlot : oldSlots)
+	{
+		if (oldSlot.index >= 0)
+		{
+			size_t slot = HomeSlot(oldSlot.key);
+			while (m_slots[slot].index >= 0)
+			{
+				slot = (slot + 1) & m_mask;
+			}
+			m_slots[slot] = oldSlot;
+		}
+	}
+}
+
+TileState TileStateIndex::Get(int column, int row) const
+{
+	int index = FindBlock(column >> BLOCKSHIFT, row >> BLOCKSHIFT);
+	if (index < 0)
+	{
+		return TileState::Empty;
+	}
+	Block const& block = m_blocks[index];
+	int bit = column & (BLOCKSIZE - 1);
+	int blockRow = row & (BLOCKSIZE - 1);
+	int low = (int)((block.lowBits[blockRow] >> bit) & 1);
+	int high = (int)((block.highBits[blockRow] >> bit) & 1);
+	return (TileState)(high << 1 | low);
+}
+
+//
+//  FUNCTION: Set
+//
+//  PURPOSE: Gives every tile of the range the same state, one masked write per row of tiles in each block it covers.
+//	Setting tiles of a block that does not exist yet to Empty does not create it, and a block left with every tile Empty
+//	is freed.
+//
+void TileStateIndex::Set(TileRange const& range, TileState state)
+{
+	if (range.IsEmpty())
+	{
+		return;
+	}
+
+	uint64_t low = ((int)state & 1) ? ~0ull : 0;
+	uint64_t high = ((int)state & 2) ? ~0ull : 0;
+	int lastColumn = range.startColumn + range.numColumns - 1;
+	int lastRow = range.startRow + range.numRows - 1;
+
+	for (int blockColumn = range.startColumn >> BLOCKSHIFT; blockColumn <= lastColumn >> BLOCKSHIFT; blockColumn++)
+	{
+		int firstBit = std::max(range.startColumn - blockColumn * BLOCKSIZE, 0);
+		int lastBit = std::min(lastColumn - blockColumn * BLOCKSIZE, BLOCKSIZE - 1);
+		uint64_t mask = ColumnMask(firstBit, lastBit);
+
+		for (int blockRow = range.startRow >> BLOCKSHIFT; blockRow <= lastRow >> BLOCKSHIFT; blockRow++)
+		{
+			int index = state == TileState::Empty ? FindBlock(blockColumn, blockRow) : GetOrCreateBlock(blockColumn, blockRow);
+			if (index < 0)
+			{
+				continue;
+			}
+			Block& block = m_blocks[index];
+			int firstRow = std::max(range.startRow - blockRow * BLOCKSIZE, 0);
+			int endRow = std::min(lastRow - blockRow * BLOCKSIZE, BLOCKSIZE - 1);
+			for (int row = firstRow; row <= endRow; row++)
+			{
+				block.lowBits[row] = (block.lowBits[row] & ~mask) | (low & mask);
+				block.highBits[row] = (block.highBits[row] & ~mask) | (high & mask);
+			}
+			if (state == TileState::Empty && IsClear(block))
+			{
+				FreeBlock(blockColumn, blockRow);
+			}
+		}
+	}
+}
+
+//
+//  FUNCTION: All
+//
+//  PURPOSE: Returns true when every tile of the range is in the given state. Tiles of blocks that do not exist are Empty.
+//
+bool TileStateIndex::All(TileRange const& range, TileState state) const
+{
+	if (range.IsEmpty())
+	{
+		return true;
+	}
+
+	uint64_t low = ((int)state & 1) ? ~0ull : 0;
+	uint64_t high = ((int)state & 2) ? ~0ull : 0;
+	int lastColumn = range.startColumn + range.numColumns - 1;
+	int lastRow = range.startRow + range.numRows - 1;
+
+	for (int blockColumn = range.startColumn >> BLOCKSHIFT; blockColumn <= lastColumn >> BLOCKSHIFT; blockColumn++)
+	{
+		int firstBit = std::max(range.startColumn - blockColumn * BLOCKSIZE, 0);
+		int lastBit = std::min(lastColumn - blockColumn * BLOCKSIZE, BLOCKSIZE - 1);
+		uint64_t mask = ColumnMask(firstBit, lastBit);
+
+		for (int blockRow = range.startRow >> BLOCKSHIFT; blockRow <= lastRow >> BLOCKSHIFT; blockRow++)
+		{
+			int index = FindBlock(blockColumn, blockRow);
+			if (index < 0)
+			{
+				if (state != TileState::Empty)
+				{
+					return false;
+				}
+				continue;
+			}
+			Block const& block = m_blocks[index];
+			int firstRow = std::max(range.startRow - blockRow * BLOCKSIZE, 0);
+			int endRow = std::min(lastRow - blockRow * BLOCKSIZE, BLOCKSIZE - 1);
+			for (int row = firstRow; row <= endRow; row++)
+			{
+				if (((block.lowBits[row] ^ low) & mask) != 0 || ((block.highBits[row] ^ high) & mask) != 0)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+size_t TileStateIndex::GetBlockCount() const
+{
+	return m_blocks.size() - m_freeBlocks.size();
+}
@@ -0,0 +1,90 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileRange.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+//  ENUM: TileState
+//
+//  PURPOSE: What the surface holds for a tile. Pending tiles are queued but not drawn yet, valid tiles are drawn, evicted
+//	tiles were drawn once and trimmed since.
+//
+enum class TileState : uint8_t
+{
+	Empty,
+	Pending,
+	Valid,
+	Evicted
+};
+
+//
+//  CLASS: TileStateIndex
+//
+//  PURPOSE: Sparse two level bitmap holding the TileState of every tile of the surface. The first level is a hash table
+//	of blocks of 64 by 64 tiles, created the first time a tile of the block is set. In a block every row of tiles is a
+//	pair of 64 bit words, one bit of the state in each, so a whole row of a range is read or written with a mask.
+//	Getting a tile is a hash lookup whatever the size of the surface, and a range costs one lookup per block and one word
+//	operation per row of tiles, so a 2^24 pixel surface of 250 pixel tiles (4.5 billion tiles) costs nothing more than a
+//	small one as long as only part of it is ever visited. A block whose last tile goes back to Empty is taken out of the
+//	table and kept on a free list, zeroed, for the next block to be created, so setting states does not allocate once
+//	the index has held as many blocks as it does now.
+//
+class TileStateIndex
+{
+public:
+	TileStateIndex();
+	TileState Get(int column, int row) const;
+	void Set(TileRange const& range, TileState state);
+	bool All(TileRange const& range, TileState state) const;
+	size_t GetBlockCount() const;
+
+	//log2 of the number of tiles on each side of a block.
+	const static int BLOCKSHIFT = 6;
+	const static int BLOCKSIZE = 1 << BLOCKSHIFT;
+	//Number of blocks the index can hold before it has to grow.
+	const static int INITIALBLOCKCOUNT = 64;
+
+private:
+	struct Block
+	{
+		uint64_t lowBits[BLOCKSIZE];//Bit 0 of the state of each tile, one word per row
+		uint64_t highBits[BLOCKSIZE];//Bit 1
+	};
+
+	struct BlockSlot
+	{
+		uint64_t key = 0;
+		int      index = -1;//Into m_blocks, -1 when the slot is empty
+	};
+
+	static uint64_t BlockKey(int blockColumn, int blockRow);
+	static uint64_t ColumnMask(int firstColumn, int lastColumn);
+	static bool IsClear(Block const& block);
+	size_t HomeSlot(uint64_t key) const;
+	int FindBlock(int blockColumn, int blockRow) const;
+	int GetOrCreateBlock(int blockColumn, int blockRow);
+	void FreeBlock(int blockColumn, int blockRow);
+	void GrowSlots();
+
+	//member variables
+	std::vector<BlockSlot>  m_slots;
+	size_t                  m_mask = 0;
+	std::vector<Block>      m_blocks;
+	std::vector<int>        m_freeBlocks;//Indices into m_blocks of blocks with every tile Empty, out of the table
+};
@@ -0,0 +1,439 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileTelemetry.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+//Histogram written by a single thread. Same buckets as LatencyHistogram. The totals come first, so recording the small
+//values most tile counts are touches a single cache line.
+struct alignas(64) TelemetryHistogram
+{
+	std::atomic<uint64_t>   sum;
+	std::atomic<uint64_t>   max;
+	std::atomic<uint64_t>   buckets[LatencyHistogram::BUCKETCOUNT];
+};
+
+struct TelemetryEvent
+{
+	std::atomic<uint64_t>   startNs;
+	std::atomic<uint64_t>   durationNs;
+	std::atomic<uint64_t>   spanAndArgument;//Span in the high half, argument in the low half
+};
+
+struct alignas(64) TelemetryBlock
+{
+	std::atomic<uint64_t>   counters[(int)TileCounter::Count];
+	std::atomic<uint64_t>   spanCalls[(int)TileSpan::Count];//Calls of the sampled spans, timed or not
+	TelemetryHistogram      spans[(int)TileSpan::Count];
+	TelemetryHistogram      values[(int)TileValue::Count];
+	TelemetryEvent          events[TileTelemetry::RINGSIZE];
+	std::atomic<uint64_t>   eventCount;//Spans ever recorded, the last RINGSIZE of them are in events
+};
+
+//Zero initialized, being static, so none of this is allocated or touched until a thread records something.
+static TelemetryBlock   s_blocks[TileTelemetry::MAXTHREADCOUNT];
+static std::atomic<bool> s_blockTaken[TileTelemetry::MAXTHREADCOUNT];
+static std::atomic<bool> s_enabled{ true };
+static std::atomic<bool> s_tracing{ false };
+
+//Block of the current thread. A plain pointer needs no guard to read, the slot with its destructor is only touched the
+//first time and hands the block back when the thread exits.
+static thread_local TelemetryBlock* t_block = nullptr;
+
+struct TelemetrySlot
+{
+	int index = -1;//-1 until the first record, -2 when every block was taken
+
+	~TelemetrySlot()
+	{
+		t_block = nullptr;
+		if (index >= 0)
+		{
+			s_blockTaken[index].store(false, std::memory_order_release);
+			index = -2;
+		}
+	}
+};
+static thread_local TelemetrySlot t_slot;
+
+static TelemetryBlock* GetThreadBlock()
+{
+	if (t_block != nullptr)
+	{
+		return t_block;
+	}
+	TelemetrySlot& slot = t_slot;
+	if (slot.index == -1)
+	{
+		slot.index = -2;
+		for (int i = 0; i < TileTelemetry::MAXTHREADCOUNT; i++)
+		{
+			if (!s_blockTaken[i].exchange(true, std::memory_order_acquire))
+			{
+				slot.index = i;
+				t_block = &s_blocks[i];
+				break;
+			}
+		}
+	}
+	return t_block;
+}
+
+//Single writer increment, no locked instruction needed.
+static void Increment(std::atomic<uint64_t>& value, uint64_t amount)
+{
+	value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+static void Record(TelemetryHistogram& histogram, uint64_t value)
+{
+	Increment(histogram.buckets[LatencyHistogram::GetBucket(value)], 1);
+	Increment(histogram.sum, value);
+	if (value > histogram.max.load(std::memory_order_relaxed))
+	{
+		histogram.max.store(value, std::memory_order_relaxed);
+	}
+}
+
+static void AddTo(LatencyHistogram& total, TelemetryHistogram const& histogram)
+{
+	for (int bucket = 0; bucket < LatencyHistogram::BUCKETCOUNT; bucket++)
+	{
+		uint64_t count = histogram.buckets[bucket].load(std::memory_order_relaxed);
+		if (count != 0)
+		{
+			total.AddBucket(bucket, count);
+		}
+	}
+	total.AddTotals(histogram.sum.load(std::memory_order_relaxed), histogram.max.load(std::memory_order_relaxed));
+}
+
+static void Clear(TelemetryHistogram& histogram)
+{
+	for (auto& bucket : histogram.buckets)
+	{
+		bucket.store(0, std::memory_order_relaxed);
+	}
+	histogram.sum.store(0, std::memory_order_relaxed);
+	histogram.max.store(0, std::memory_order_relaxed);
+}
+
+void TileTelemetry::SetEnabled(bool enabled)
+{
+	s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool TileTelemetry::IsEnabled()
+{
+	return s_enabled.load(std::memory_order_relaxed);
+}
+
+void TileTelemetry::SetTracing(bool tracing)
+{
+	s_tracing.store(tracing, std::memory_order_relaxed);
+}
+
+bool TileTelemetry::IsTracing()
+{
+	return s_tracing.load(std::memory_order_relaxed);
+}
+
+//
+//  FUNCTION: IsTimed
+//
+//  PURPOSE: Whether this call of the span is to be timed, never while telemetry is off. Always for most spans.
+//	UpdateVisibleRegion and UpdateZoom come with every tracker callback and cost less than the clock reads would, so only
+//	the first of every SAMPLEDSPANINTERVAL calls on the thread is. Their calls are counted all the same, which is where
+//	the Updates counter comes from.
+//
+bool TileTelemetry::IsTimed(TileSpan span)
+{
+	if (!IsEnabled())
+	{
+		return false;
+	}
+	if (span != TileSpan::UpdateVisibleRegion && span != TileSpan::UpdateZoom)
+	{
+		return true;
+	}
+	TelemetryBlock* block = GetThreadBlock();
+	if (block == nullptr)
+	{
+		return false;
+	}
+	uint64_t calls = block->spanCalls[(int)span].load(std::memory_order_relaxed);
+	block->spanCalls[(int)span].store(calls + 1, std::memory_order_relaxed);
+	return calls % SAMPLEDSPANINTERVAL == 0;
+}
+
+uint64_t TileTelemetry::Now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TileTelemetry::Add(TileCounter counter, uint64_t amount)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+	TelemetryBlock* block = GetThreadBlock();
+	if (block != nullptr)
+	{
+		Increment(block->counters[(int)counter], amount);
+	}
+}
+
+void TileTelemetry::RecordValue(TileValue value, uint64_t amount)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+	TelemetryBlock* block = GetThreadBlock();
+	if (block != nullptr)
+	{
+		Record(block->values[(int)value], amount);
+	}
+}
+
+//
+//  FUNCTION: RecordSpanTo
+//
+//  PURPOSE: Counts the duration of a span in its histogram and, while tracing, adds it to the ring of the block. The
+//	event count is published last, so a trace written at the same time never reads an event that is only half written,
+//	unless the ring has wrapped all the way round in the meantime.
+//
+static void RecordSpanTo(TelemetryBlock& block, TileSpan span, uint64_t startNs, uint64_t durationNs, int32_t argument)
+{
+	Record(block.spans[(int)span], durationNs);
+	if (!TileTelemetry::IsTracing())
+	{
+		return;
+	}
+
+	uint64_t eventCount = block.eventCount.load(std::memory_order_relaxed);
+	if (eventCount >= (uint64_t)TileTelemetry::RINGSIZE)
+	{
+		Increment(block.counters[(int)TileCounter::DroppedSpans], 1);
+	}
+	TelemetryEvent& event = block.events[eventCount % TileTelemetry::RINGSIZE];
+	event.startNs.store(startNs, std::memory_order_relaxed);
+	event.durationNs.store(durationNs, std::memory_order_relaxed);
+	event.spanAndArgument.store((uint64_t)span << 32 | (uint32_t)argument, std::memory_order_relaxed);
+	block.eventCount.store(eventCount + 1, std::memory_order_release);
+}
+
+void TileTelemetry::RecordSpan(TileSpan span, uint64_t startNs, uint64_t endNs, int32_t argument)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+	TelemetryBlock* block = GetThreadBlock();
+	if (block != nullptr)
+	{
+		RecordSpanTo(*block, span, startNs, endNs > startNs ? endNs - startNs : 0, argument);
+	}
+}
+
+//
+//  FUNCTION: RecordDraw
+//
+//  PURPOSE: Records a draw of tileCount tiles: its span, the TilesPerDraw value and the TileCostNs value, with one look
+//	up of the thread block for the three of them.
+//
+void TileTelemetry::RecordDraw(TileSpan span, uint64_t startNs, uint64_t endNs, int32_t tileCount)
+{
+	if (!IsEnabled() || tileCount <= 0)
+	{
+		return;
+	}
+	TelemetryBlock* block = GetThreadBlock();
+	if (block == nullptr)
+	{
+		return;
+	}
+	uint64_t durationNs = endNs > startNs ? endNs - startNs : 0;
+	RecordSpanTo(*block, span, startNs, durationNs, tileCount);
+	Record(block->values[(int)TileValue::TilesPerDraw], (uint64_t)tileCount);
+	Record(block->values[(int)TileValue::TileCostNs], durationNs / (uint64_t)tileCount);
+}
+
+void TileTelemetry::GetSnapshot(TileTelemetrySnapshot& snapshot)
+{
+	snapshot = TileTelemetrySnapshot{};
+	for (TelemetryBlock const& block : s_blocks)
+	{
+		for (int counter = 0; counter < (int)TileCounter::Count; counter++)
+		{
+			snapshot.counters[counter] += block.counters[counter].load(std::memory_order_relaxed);
+		}
+		for (int span = 0; span < (int)TileSpan::Count; span++)
+		{
+			AddTo(snapshot.spans[span], block.spans[span]);
+		}
+		for (int value = 0; value < (int)TileValue::Count; value++)
+		{
+			AddTo(snapshot.values[value], block.values[value]);
+		}
+		snapshot.counters[(int)TileCounter::Updates] += block.spanCalls[(int)TileSpan::UpdateVisibleRegion].load(std::memory_order_relaxed);
+	}
+	snapshot.counters[(int)TileCounter::TilesScheduled] += snapshot.values[(int)TileValue::TilesPerUpdate].GetSum();
+	snapshot.counters[(int)TileCounter::RangesDrawn] += snapshot.values[(int)TileValue::TilesPerDraw].GetCount();
+	snapshot.counters[(int)TileCounter::TilesDrawn] += snapshot.values[(int)TileValue::TilesPerDraw].GetSum();
+}
+
+//
+//  FUNCTION: Reset
+//
+//  PURPOSE: Clears every counter, histogram and ring. Values recorded by other threads while this runs may survive it,
+//	call it when nothing is drawing.
+//
+void TileTelemetry::Reset()
+{
+	for (TelemetryBlock& block : s_blocks)
+	{
+		for (auto& counter : block.counters)
+		{
+			counter.store(0, std::memory_order_relaxed);
+		}
+		for (auto& calls : block.spanCalls)
+		{
+			calls.store(0, std::memory_order_relaxed);
+		}
+		for (auto& histogram : block.spans)
+		{
+			Clear(histogram);
+		}
+		for (auto& histogram : block.values)
+		{
+			Clear(histogram);
+		}
+		block.eventCount.store(0, std::memory_order_relaxed);
+	}
+}
+
+//
+//  FUNCTION: WriteChromeTrace
+//
+//  PURPOSE: Writes the spans still in the rings as complete events of the Chrome trace event format, one track per
+//	thread block, times in microseconds from the first span. Returns false when the file cannot be written.
+//
+bool TileTelemetry::WriteChromeTrace(char const* path)
+{
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	uint64_t firstNs = UINT64_MAX;
+	for (TelemetryBlock const& block : s_blocks)
+	{
+		uint64_t eventCount = block.eventCount.load(std::memory_order_acquire);
+		uint64_t first = eventCount > (uint64_t)RINGSIZE ? eventCount - RINGSIZE : 0;
+		for (uint64_t i = first; i < eventCount; i++)
+		{
+			uint64_t startNs = block.events[i % RINGSIZE].startNs.load(std::memory_order_relaxed);
+			firstNs = startNs < firstNs ? startNs : firstNs;
+		}
+	}
+
+	file << "{\"traceEvents\":[";
+	bool firstEvent = true;
+	char line[256];
+	for (int thread = 0; thread < MAXTHREADCOUNT; thread++)
+	{
+		TelemetryBlock const& block = s_blocks[thread];
+		uint64_t eventCount = block.eventCount.load(std::memory_order_acquire);
+		uint64_t first = eventCount > (uint64_t)RINGSIZE ? eventCount - RINGSIZE : 0;
+		for (uint64_t i = first; i < eventCount; i++)
+		{
+			TelemetryEvent const& event = block.events[i % RINGSIZE];
+			uint64_t spanAndArgument = event.spanAndArgument.load(std::memory_order_relaxed);
+			int32_t argument = (int32_t)(uint32_t)spanAndArgument;
+			int length = snprintf(line, sizeof(line), "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+				firstEvent ? "" : ",",
+				GetSpanName((TileSpan)(spanAndArgument >> 32)),
+				thread,
+				(double)(event.startNs.load(std::memory_order_relaxed) - firstNs) / 1000.0,
+				(double)event.durationNs.load(std::memory_order_relaxed) / 1000.0);
+			//Spans without an argument have none in the trace either.
+			if (argument != 0)
+			{
+				snprintf(line + length, sizeof(line) - length, ",\"args\":{\"tiles\":%d}}", argument);
+			}
+			else
+			{
+				snprintf(line + length, sizeof(line) - length, "}");
+			}
+			file << line;
+			firstEvent = false;
+		}
+	}
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return (bool)file;
+}
+
+char const* TileTelemetry::GetSpanName(TileSpan span)
+{
+	switch (span)
+	{
+	case TileSpan::UpdateVisibleRegion: return "UpdateVisibleRegion";
+	case TileSpan::UpdateZoom: return "UpdateZoom";
+	case TileSpan::ProcessPendingTiles: return "ProcessPendingTiles";
+	case TileSpan::DrawTileRange: return "DrawTileRange";
+	case TileSpan::DrawLevelOfDetailRange: return "DrawLevelOfDetailRange";
+	case TileSpan::Trim: return "Trim";
+	case TileSpan::BeginDraw: return "BeginDraw";
+	case TileSpan::RasterizeBand: return "RasterizeBand";
+	case TileSpan::Upload: return "Upload";
+	case TileSpan::RestoreTile: return "RestoreTile";
+	case TileSpan::CompressTile: return "CompressTile";
+	default: return "Unknown";
+	}
+}
+
+char const* TileTelemetry::GetCounterName(TileCounter counter)
+{
+	switch (counter)
+	{
+	case TileCounter::Updates: return "Updates";
+	case TileCounter::TilesScheduled: return "TilesScheduled";
+	case TileCounter::RangesDrawn: return "RangesDrawn";
+	case TileCounter::TilesDrawn: return "TilesDrawn";
+	case TileCounter::TrimCalls: return "TrimCalls";
+	case TileCounter::TrimsDeferred: return "TrimsDeferred";
+	case TileCounter::TilesCancelled: return "TilesCancelled";
+	case TileCounter::DeviceResourcesCreated: return "DeviceResourcesCreated";
+	case TileCounter::DroppedSpans: return "DroppedSpans";
+	default: return "Unknown";
+	}
+}
+
+char const* TileTelemetry::GetValueName(TileValue value)
+{
+	switch (value)
+	{
+	case TileValue::TilesPerUpdate: return "TilesPerUpdate";
+	case TileValue::TilesPerDraw: return "TilesPerDraw";
+	case TileValue::TileCostNs: return "TileCostNs";
+	case TileValue::DrawAheadTiles: return "DrawAheadTiles";
+	default: return "Unknown";
+	}
+}
@@ -0,0 +1,169 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "LatencyHistogram.h"
+
+#include <cstdint>
+
+//
+//  ENUM: TileSpan
+//
+//  PURPOSE: Timed sections of the tile pipeline. Each one has a latency histogram and shows up as a span in the trace.
+//
+enum class TileSpan : uint8_t
+{
+	UpdateVisibleRegion,
+	UpdateZoom,
+	ProcessPendingTiles,
+	DrawTileRange,
+	DrawLevelOfDetailRange,
+	Trim,
+	BeginDraw,
+	RasterizeBand,
+	Upload,
+	RestoreTile,
+	CompressTile,
+	Count
+};
+
+//
+//  ENUM: TileCounter
+//
+//  PURPOSE: Plain event counts. The first four are not recorded on their own, GetSnapshot takes them from the calls of
+//	the UpdateVisibleRegion span and from the value histograms, which already count them.
+//
+enum class TileCounter : uint8_t
+{
+	Updates,//Calls of UpdateVisibleRegion
+	TilesScheduled,//Sum of TilesPerUpdate
+	RangesDrawn,//Count of TilesPerDraw
+	TilesDrawn,//Sum of TilesPerDraw
+	TrimCalls,
+	TrimsDeferred,//Trim calls left by the update that went over the cache budget to a later moment
+	TilesCancelled,
+	DeviceResourcesCreated,//Brushes and other device resources the renderers had to create
+	DroppedSpans,
+	Count
+};
+
+//
+//  ENUM: TileValue
+//
+//  PURPOSE: Quantities recorded in a histogram of their own, rather than summed.
+//
+enum class TileValue : uint8_t
+{
+	TilesPerUpdate,//Of the updates that schedule any
+	TilesPerDraw,
+	TileCostNs,//Time a range took to draw, divided by its tiles
+	DrawAheadTiles,//Draw ahead at rest, at the end of every frame that drew tiles
+	Count
+};
+
+//
+//  STRUCT: TileTelemetrySnapshot
+//
+//  PURPOSE: Every thread's counters and histograms added up. Span histograms are in nanoseconds.
+//
+struct TileTelemetrySnapshot
+{
+	uint64_t            counters[(int)TileCounter::Count] = {};
+	LatencyHistogram    spans[(int)TileSpan::Count];
+	LatencyHistogram    values[(int)TileValue::Count];
+};
+
+//
+//  CLASS: TileTelemetry
+//
+//  PURPOSE: Always on instrumentation of the tile pipeline. Every thread that records anything gets a block of its own
+//	the first time it does, holding its counters, its histograms and a ring buffer of its last RINGSIZE spans. A block is
+//	only ever written by its thread, with relaxed atomic loads and stores and no read-modify-write, so recording takes no
+//	lock and shares no cache line with other threads. GetSnapshot adds the blocks up while they are being written, which
+//	at worst misses the values recorded at that very moment.
+//	Blocks are static, so recording never allocates. A thread that exits hands its block over to the next thread that
+//	starts, its counts stay in. Spans only go to the ring buffers while tracing is on, and those can be written out as a
+//	Chrome trace (chrome://tracing or Perfetto).
+//	An update costs less than a clock read or two, so UpdateVisibleRegion and UpdateZoom are only timed once every
+//	SAMPLEDSPANINTERVAL calls on each thread. Their histograms hold that share of the calls, the Updates counter all of them.
+//	Recording a value or a counter costs a nanosecond or two, which is still a fair share of an update that schedules
+//	nothing, so what one record already tells is not recorded again.
+//
+class TileTelemetry
+{
+public:
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+	static void SetTracing(bool tracing);
+	static bool IsTracing();
+	static bool IsTimed(TileSpan span);
+	static uint64_t Now();
+	static void Add(TileCounter counter, uint64_t amount = 1);
+	static void RecordValue(TileValue value, uint64_t amount);
+	static void RecordSpan(TileSpan span, uint64_t startNs, uint64_t endNs, int32_t argument);
+	static void RecordDraw(TileSpan span, uint64_t startNs, uint64_t endNs, int32_t tileCount);
+	static void GetSnapshot(TileTelemetrySnapshot& snapshot);
+	static void Reset();
+	static bool WriteChromeTrace(char const* path);
+
+	static char const* GetSpanName(TileSpan span);
+	static char const* GetCounterName(TileCounter counter);
+	static char const* GetValueName(TileValue value);
+
+	//Most threads recording at the same time, a worker pool of the largest size plus a few. More are not recorded.
+	const static int MAXTHREADCOUNT = 72;
+	//Spans kept by every thread, older ones are overwritten.
+	const static int RINGSIZE = 4096;
+	//Calls of UpdateVisibleRegion and UpdateZoom per thread for every one that is timed.
+	const static int SAMPLEDSPANINTERVAL = 256;
+};
+
+//
+//  CLASS: TileSpanScope
+//
+//  PURPOSE: Times the scope it lives in as a span. The argument is shown with the span in the trace, the number of tiles
+//	involved for most of them. Costs two clock reads when telemetry is enabled and the span is timed, and one flag check
+//	when it is not. Sections that read the clock anyway pass their own times to TileTelemetry::RecordSpan instead.
+//
+class TileSpanScope
+{
+public:
+	explicit TileSpanScope(TileSpan span, int32_t argument = 0) :
+		m_span(span),
+		m_argument(argument),
+		m_startNs(TileTelemetry::IsTimed(span) ? TileTelemetry::Now() : 0)
+	{
+	}
+
+	~TileSpanScope()
+	{
+		if (m_startNs != 0)
+		{
+			TileTelemetry::RecordSpan(m_span, m_startNs, TileTelemetry::Now(), m_argument);
+		}
+	}
+
+	TileSpanScope(TileSpanScope const&) = delete;
+	TileSpanScope& operator=(TileSpanScope const&) = delete;
+
+	void SetArgument(int32_t argument)
+	{
+		m_argument = argument;
+	}
+
+private:
+	TileSpan    m_span;
+	int32_t     m_argument;
+	uint64_t    m_startNs;
+};
@@ -0,0 +1,451 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileWorkQueue.h"
+
+#include <algorithm>
+#include <cmath>
+
+//Distance in tiles between two ranges, 0 when they overlap.
+static int Distance(TileRange const& a, TileRange const& b)
+{
+	int dx = std::max(std::max(b.startColumn - (a.startColumn + a.numColumns - 1), a.startColumn - (b.startColumn + b.numColumns - 1)), 0);
+	int dy = std::max(std::max(b.startRow - (a.startRow + a.numRows - 1), a.startRow - (b.startRow + b.numRows - 1)), 0);
+	return std::max(dx, dy);
+}
+
+static TilePriority GetPriorityForDistance(int distance, int nearTileCount)
+{
+	if (distance == 0)
+	{
+		return TilePriority::Visible;
+	}
+	return distance <= nearTileCount ? TilePriority::Near : TilePriority::Prefetch;
+}
+
+TileWorkQueue::TileWorkQueue(int maxTilesPerDraw) :
+	m_maxTilesPerDraw(std::max(maxTilesPerDraw, 1))
+{
+	m_work.reserve(INITIALCAPACITY);
+	m_pieces.reserve(INITIALCAPACITY);
+	m_splitWork.reserve(INITIALCAPACITY);
+}
+
+TilePriority TileWorkQueue::GetPriority(TileRange const& range, TileRange const& visibleRange, int nearTileCount)
+{
+	return GetPriorityForDistance(Distance(range, visibleRange), nearTileCount);
+}
+
+//
+//  FUNCTION: Push
+//
+//  PURPOSE: Queues a range of tiles, stamped with the epoch of the update that needs them. The part of the range that is
+//	visible is queued separately from the rest, so it is not held up behind tiles that are only there as draw ahead.
+//	The blocks of the range are then put in the tile order, around the visible range or around the range itself when
+//	none of it is visible.
+//
+void TileWorkQueue::Push(TileRange const& range, int level, TileRange const& visibleRange, uint32_t epoch)
+{
+	if (range.IsEmpty())
+	{
+		return;
+	}
+
+	//Anything already queued inside the new range would only be drawn twice.
+	for (size_t i = 0; i < m_work.size();)
+	{
+		if (m_work[i].level == level && range.Contains(m_work[i].range))
+		{
+			m_pendingTileCount -= m_work[i].range.TileCount();
+			m_work.erase(m_work.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	size_t firstChunk = m_work.size();
+	TileRange visible = range.Intersect(visibleRange.ToLevel(level));
+	TileRange parts[5];
+	int partCount = SplitAroundVisible(range, visible, parts);
+	for (int part = 0; part < partCount; part++)
+	{
+		PushChunks(parts[part], level, epoch);
+	}
+	SortChunks(firstChunk, range, visibleRange.IsEmpty() ? range : visibleRange.ToLevel(level));
+}
+
+//
+//  FUNCTION: CountChunks
+//
+//  PURPOSE: Returns the number of blocks Push would cut the range into, each of them a BeginDraw/EndDraw session of its
+//	own. The TileRegionCoalescer prices its merges with it.
+//
+int TileWorkQueue::CountChunks(TileRange const& range, int level, TileRange const& visibleRange) const
+{
+	TileRange parts[5];
+	int partCount = SplitAroundVisible(range, range.Intersect(visibleRange.ToLevel(level)), parts);
+	int chunkCount = 0;
+	for (int part = 0; part < partCount; part++)
+	{
+		if (!parts[part].IsEmpty())
+		{
+			int columnsPerChunk;
+			int rowsPerChunk;
+			GetChunkSize(parts[part], columnsPerChunk, rowsPerChunk);
+			chunkCount += ((parts[part].numColumns + columnsPerChunk - 1) / columnsPerChunk) * ((parts[part].numRows + rowsPerChunk - 1) / rowsPerChunk);
+		}
+	}
+	return chunkCount;
+}
+
+//
+//  FUNCTION: SplitAroundVisible
+//
+//  PURPOSE: Splits a range into the part that is visible first, then the bands above, below, left and right of it, some
+//	of which may be empty. A range with nothing visible stays whole. Returns the number of parts.
+//
+int TileWorkQueue::SplitAroundVisible(TileRange const& range, TileRange const& visible, TileRange parts[5])
+{
+	if (visible.IsEmpty())
+	{
+		parts[0] = range;
+		return 1;
+	}
+
+	int rangeRight = range.startColumn + range.numColumns;
+	int rangeBottom = range.startRow + range.numRows;
+	int visibleRight = visible.startColumn + visible.numColumns;
+	int visibleBottom = visible.startRow + visible.numRows;
+
+	parts[0] = visible;
+	parts[1] = TileRange{ range.startColumn, range.startRow, range.numColumns, visible.startRow - range.startRow };
+	parts[2] = TileRange{ range.startColumn, visibleBottom, range.numColumns, rangeBottom - visibleBottom };
+	parts[3] = TileRange{ range.startColumn, visible.startRow, visible.startColumn - range.startColumn, visible.numRows };
+	parts[4] = TileRange{ visibleRight, visible.startRow, rangeRight - visibleRight, visible.numRows };
+	return 5;
+}
+
+//
+//  FUNCTION: GetChunkSize
+//
+//  PURPOSE: Size of the blocks a range is cut into, at most maxTilesPerDraw tiles. Scan takes whole columns. The other
+//	orders take square blocks, which they can move around the viewport in, stretched along narrow ranges so the blocks
+//	stay as large as a draw.
+//
+void TileWorkQueue::GetChunkSize(TileRange const& range, int& columnsPerChunk, int& rowsPerChunk) const
+{
+	rowsPerChunk = std::min(range.numRows, m_maxTilesPerDraw);
+	if (m_order != TileOrder::Scan)
+	{
+		int side = std::max((int)std::sqrt((double)m_maxTilesPerDraw), 1);
+		rowsPerChunk = std::min(range.numRows, m_maxTilesPerDraw / std::min(range.numColumns, side));
+	}
+	columnsPerChunk = std::max(m_maxTilesPerDraw / rowsPerChunk, 1);
+}
+
+//
+//  FUNCTION: PushChunks
+//
+//  PURPOSE: Splits a range into blocks of at most maxTilesPerDraw tiles, sized by GetChunkSize. Each block becomes a
+//	single BeginDraw/EndDraw session, so this bounds how long one draw can hold up the frame.
+//
+void TileWorkQueue::PushChunks(TileRange const& range, int level, uint32_t epoch)
+{
+	if (range.IsEmpty())
+	{
+		return;
+	}
+
+	int columnsPerChunk;
+	int rowsPerChunk;
+	GetChunkSize(range, columnsPerChunk, rowsPerChunk);
+
+	for (int column = range.startColumn; column < range.startColumn + range.numColumns; column += columnsPerChunk)
+	{
+		int numColumns = std::min(columnsPerChunk, range.startColumn + range.numColumns - column);
+		for (int row = range.startRow; row < range.startRow + range.numRows; row += rowsPerChunk)
+		{
+			int numRows = std::min(rowsPerChunk, range.startRow + range.numRows - row);
+			m_work.push_back(TileWork{ TileRange{ column, row, numColumns, numRows }, level, epoch });
+			m_pendingTileCount += numColumns * numRows;
+		}
+	}
+}
+
+//
+//  FUNCTION: SortChunks
+//
+//  PURPOSE: Puts the blocks pushed from firstChunk on in the tile order. Pop takes blocks of the same priority and
+//	distance in the order they are in, so this is the order they are drawn in. Scan keeps them as they were pushed.
+//
+void TileWorkQueue::SortChunks(size_t firstChunk, TileRange const& range, TileRange const& centerRange)
+{
+	if (m_order == TileOrder::Scan)
+	{
+		return;
+	}
+	//No two blocks have the same key, so the order does not depend on the sort.
+	std::sort(m_work.begin() + firstChunk, m_work.end(), [&](TileWork const& a, TileWork const& b)
+	{
+		return GetOrderKey(a.range, range, centerRange) < GetOrderKey(b.range, range, centerRange);
+	});
+}
+
+//
+//  FUNCTION: GetOrderKey
+//
+//  PURPOSE: Position of a block in the tile order, smaller first. CenterOut goes ring by ring around the middle of
+//	centerRange, clockwise from the top left corner of each ring. Centers are compared at twice the tile coordinates,
+//	so they stay whole numbers. ZOrder and Hilbert take the top left tile of the block, relative to the range.
+//
+uint64_t TileWorkQueue::GetOrderKey(TileRange const& chunk, TileRange const& range, TileRange const& centerRange) const
+{
+	if (m_order == TileOrder::CenterOut)
+	{
+		int64_t dx = (2 * (int64_t)chunk.startColumn + chunk.numColumns) - (2 * (int64_t)centerRange.startColumn + centerRange.numColumns);
+		int64_t dy = (2 * (int64_t)chunk.startRow + chunk.numRows) - (2 * (int64_t)centerRange.startRow + centerRange.numRows);
+		int64_t ring = std::max(std::abs(dx), std::abs(dy));
+		int64_t position;
+		if (-dy >= std::abs(dx))
+		{
+			position = dx + ring;//Top side, left to right
+		}
+		else if (dx >= std::abs(dy))
+		{
+			position = 2 * ring + dy + ring;//Right side, top to bottom
+		}
+		else if (dy >= std::abs(dx))
+		{
+			position = 4 * ring + ring - dx;//Bottom side, right to left
+		}
+		else
+		{
+			position = 6 * ring + ring - dy;//Left side, bottom to top
+		}
+		return (uint64_t)ring << 32 | (uint64_t)position;
+	}
+
+	uint32_t x = (uint32_t)(chunk.startColumn - range.startColumn);
+	uint32_t y = (uint32_t)(chunk.startRow - range.startRow);
+	if (m_order == TileOrder::Hilbert)
+	{
+		uint32_t size = 1;
+		while (size < (uint32_t)std::max(range.numColumns, range.numRows))
+		{
+			size <<= 1;
+		}
+		uint64_t distance = 0;
+		for (uint32_t half = size / 2; half > 0; half /= 2)
+		{
+			uint32_t rx = (x & half) != 0 ? 1 : 0;
+			uint32_t ry = (y & half) != 0 ? 1 : 0;
+			distance += (uint64_t)half * half * ((3 * rx) ^ ry);
+			//Rotates the quadrant so the curve inside it starts where the previous one ended.
+			if (ry == 0)
+			{
+				if (rx == 1)
+				{
+					x = size - 1 - x;
+					y = size - 1 - y;
+				}
+				std::swap(x, y);
+			}
+		}
+		return distance;
+	}
+
+	uint64_t key = 0;
+	for (int bit = 0; bit < 32; bit++)
+	{
+		key |= (uint64_t)((x >> bit) & 1) << (2 * bit) | (uint64_t)((y >> bit) & 1) << (2 * bit + 1);
+	}
+	return key;
+}
+
+//
+//  FUNCTION: Pop
+//
+//  PURPOSE: Takes the most urgent range out of the queue. Ranges with the same priority come out closest first, and in
+//	the order they were pushed when they are as close. Coarse ranges are compared by the level 0 area they cover, and
+//	every range by the closest of the visible ranges.
+//
+bool TileWorkQueue::Pop(TileRange const* visibleRanges, int visibleRangeCount, int nearTileCount, TileWork& work)
+{
+	if (m_work.empty())
+	{
+		return false;
+	}
+
+	size_t best = 0;
+	TilePriority bestPriority = TilePriority::Prefetch;
+	int bestDistance = -1;
+	for (size_t i = 0; i < m_work.size() && bestDistance != 0; i++)
+	{
+		TileRange range = m_work[i].range.FromLevel(m_work[i].level);
+		int distance = Distance(range, visibleRanges[0]);
+		for (int view = 1; view < visibleRangeCount; view++)
+		{
+			distance = std::min(distance, Distance(range, visibleRanges[view]));
+		}
+		TilePriority priority = GetPriorityForDistance(distance, nearTileCount);
+		if (bestDistance < 0 || priority < bestPriority || (priority == bestPriority && distance < bestDistance))
+		{
+			best = i;
+			bestPriority = priority;
+			bestDistance = distance;
+		}
+	}
+
+	work = m_work[best];
+	m_work.erase(m_work.begin() + best);
+	m_pendingTileCount -= work.range.TileCount();
+	return true;
+}
+
+//
+//  FUNCTION: Clip
+//
+//  PURPOSE: Called when a level of the surface is trimmed to keepRange. Queued tiles of that level outside of it would be
+//	discarded as soon as they are drawn, so they are dropped from the queue. Returns the number of tiles dropped.
+//
+int TileWorkQueue::Clip(TileRange const& keepRange, int level)
+{
+	return Clip(&keepRange, 1, level);
+}
+
+//
+//  FUNCTION: Clip
+//
+//  PURPOSE: Same as above when the surface keeps several ranges, one per viewport. A queued range that straddles two of
+//	them is split into the runs of tiles inside either, which are queued at the back.
+//
+int TileWorkQueue::Clip(TileRange const* keepRanges, int keepRangeCount, int level)
+{
+	int pendingTileCount = m_pendingTileCount;
+	size_t kept = 0;
+	m_splitWork.clear();
+	for (size_t i = 0; i < m_work.size(); i++)
+	{
+		TileWork work = m_work[i];
+		if (work.level == level)
+		{
+			m_pieces.clear();
+			SplitInside(work.range, keepRanges, keepRangeCount, m_pieces);
+			m_pendingTileCount -= work.range.TileCount();
+			work.range = m_pieces.empty() ? TileRange{} : m_pieces[0];
+			for (size_t piece = 0; piece < m_pieces.size(); piece++)
+			{
+				m_pendingTileCount += m_pieces[piece].TileCount();
+				if (piece > 0)
+				{
+					m_splitWork.push_back(TileWork{ m_pieces[piece], work.level, work.epoch });
+				}
+			}
+		}
+		if (!work.range.IsEmpty())
+		{
+			m_work[kept++] = work;
+		}
+	}
+	m_work.resize(kept);
+	m_work.insert(m_work.end(), m_splitWork.begin(), m_splitWork.end());
+	return pendingTileCount - m_pendingTileCount;
+}
+
+//
+//  FUNCTION: SplitInside
+//
+//  PURPOSE: Appends to pieces the tiles of range that lie inside any of keepRanges, as a single range when they fit in one
+//	and as runs of tiles row by row when they straddle several keep ranges. Queued ranges hold at most a draw worth of
+//	tiles, so going over the rows costs next to nothing.
+//
+void TileWorkQueue::SplitInside(TileRange const& range, TileRange const* keepRanges, int keepRangeCount, std::vector<TileRange>& pieces)
+{
+	TileRange inside;
+	int insideCount = 0;
+	for (int keep = 0; keep < keepRangeCount; keep++)
+	{
+		TileRange overlap = range.Intersect(keepRanges[keep]);
+		if (overlap.IsEmpty())
+		{
+			continue;
+		}
+		if (overlap.TileCount() == range.TileCount())
+		{
+			pieces.push_back(range);
+			return;
+		}
+		inside = overlap;
+		insideCount++;
+	}
+	if (insideCount <= 1)
+	{
+		if (insideCount == 1)
+		{
+			pieces.push_back(inside);
+		}
+		return;
+	}
+
+	for (int row = range.startRow; row < range.startRow + range.numRows; row++)
+	{
+		int runStart = -1;
+		int rangeRight = range.startColumn + range.numColumns;
+		for (int column = range.startColumn; column <= rangeRight; column++)
+		{
+			bool isInside = false;
+			for (int keep = 0; keep < keepRangeCount && !isInside && column < rangeRight; keep++)
+			{
+				isInside = keepRanges[keep].Contains(TileRange{ column, row, 1, 1 });
+			}
+			if (isInside && runStart < 0)
+			{
+				runStart = column;
+			}
+			else if (!isInside && runStart >= 0)
+			{
+				pieces.push_back(TileRange{ runStart, row, column - runStart, 1 });
+				runStart = -1;
+			}
+		}
+	}
+}
+
+void TileWorkQueue::Clear()
+{
+	m_work.clear();
+	m_pendingTileCount = 0;
+}
+
+bool TileWorkQueue::IsEmpty() const
+{
+	return m_work.empty();
+}
+
+int TileWorkQueue::GetPendingTileCount() const
+{
+	return m_pendingTileCount;
+}
+
+//Only applies to the ranges pushed from now on.
+void TileWorkQueue::SetOrder(TileOrder order)
+{
+	m_order = order;
+}
+
+TileOrder TileWorkQueue::GetOrder() const
+{
+	return m_order;
+}
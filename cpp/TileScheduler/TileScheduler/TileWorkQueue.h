@@ -0,0 +1,125 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileRange.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+//  ENUM: TilePriority
+//
+//  PURPOSE: Order in which queued tiles are rendered. Visible tiles are on screen right now, near tiles are within the
+//	base draw ahead band around the viewport and prefetch tiles are anything further out.
+//
+enum class TilePriority
+{
+	Visible,
+	Near,
+	Prefetch
+};
+
+//
+//  ENUM: TileOrder
+//
+//  PURPOSE: Order in which the blocks of a pushed range are drawn, among blocks of the same priority. Scan goes column by
+//	column from the top left corner. CenterOut spirals out from the middle of the viewport, so the part the user looks at
+//	fills in first. ZOrder and Hilbert follow those curves from the top left corner of the range, so blocks drawn one
+//	after the other are next to each other, which helps content drawn from a shared source image. All but Scan cut
+//	ranges into square blocks.
+//
+enum class TileOrder
+{
+	Scan,
+	CenterOut,
+	ZOrder,
+	Hilbert
+};
+
+//
+//  STRUCT: TileWork
+//
+//  PURPOSE: A queued block of tiles and the level of detail it is drawn at. Level 0 is full resolution. The epoch is the
+//	update that queued it, work from an earlier update is checked against the current required range before it is drawn.
+//
+struct TileWork
+{
+	TileRange range;
+	int       level = 0;
+	uint32_t  epoch = 0;
+};
+
+//
+//  STRUCT: TileWorkQueueStats
+//
+//  PURPOSE: Counters describing how much work is waiting in the queue and how well it fits the frame budget.
+//
+struct TileWorkQueueStats
+{
+	int      pendingTiles = 0;//Tiles currently waiting to be rendered
+	int      peakPendingTiles = 0;//Highest value pendingTiles has reached
+	uint64_t frames = 0;//Calls that drained some work
+	uint64_t budgetOverruns = 0;//Frames that went over the time budget
+	uint64_t carriedOverFrames = 0;//Frames that left work for the next one
+	uint64_t cancelledRanges = 0;//Queued ranges found partly or wholly outside the required range when their turn came
+	uint64_t cancelledTiles = 0;//Queued tiles dropped without being drawn, because the viewport moved away or they were trimmed
+};
+
+//
+//  CLASS: TileWorkQueue
+//
+//  PURPOSE: Tile ranges waiting to be rendered. Ranges are split when they are pushed, so the part that is visible can be
+//	drawn first and no single draw is larger than maxTilesPerDraw. The priority of a queued range is worked out against
+//	the visible range when it is popped, so work queued for a position the user already scrolled away from goes to the
+//	back of the line. With several viewports a range is as urgent as it is for the viewport it is closest to.
+//	Visible ranges are always given in level 0 tiles, queued ranges in tiles of their own level.
+//
+class TileWorkQueue
+{
+public:
+	explicit TileWorkQueue(int maxTilesPerDraw);
+	void Push(TileRange const& range, int level, TileRange const& visibleRange, uint32_t epoch);
+	int CountChunks(TileRange const& range, int level, TileRange const& visibleRange) const;
+	bool Pop(TileRange const* visibleRanges, int visibleRangeCount, int nearTileCount, TileWork& work);
+	int Clip(TileRange const& keepRange, int level);
+	int Clip(TileRange const* keepRanges, int keepRangeCount, int level);
+	void Clear();
+	bool IsEmpty() const;
+	int GetPendingTileCount() const;
+	void SetOrder(TileOrder order);
+	TileOrder GetOrder() const;
+
+	static TilePriority GetPriority(TileRange const& range, TileRange const& visibleRange, int nearTileCount);
+	static void SplitInside(TileRange const& range, TileRange const* keepRanges, int keepRangeCount, std::vector<TileRange>& pieces);
+
+	//Number of ranges the queue can hold before it has to grow.
+	const static int INITIALCAPACITY = 256;
+
+private:
+	static int SplitAroundVisible(TileRange const& range, TileRange const& visible, TileRange parts[5]);
+	void GetChunkSize(TileRange const& range, int& columnsPerChunk, int& rowsPerChunk) const;
+	void PushChunks(TileRange const& range, int level, uint32_t epoch);
+	void SortChunks(size_t firstChunk, TileRange const& range, TileRange const& centerRange);
+	uint64_t GetOrderKey(TileRange const& chunk, TileRange const& range, TileRange const& centerRange) const;
+
+	//member variables
+	std::vector<TileWork>   m_work;
+	std::vector<TileRange>  m_pieces;//Scratch space for Clip
+	std::vector<TileWork>   m_splitWork;//Scratch space for Clip
+	int                     m_maxTilesPerDraw;
+	int                     m_pendingTileCount = 0;
+	TileOrder               m_order = TileOrder::CenterOut;
+};
@@ -0,0 +1,206 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "TileWorkerPool.h"
+
+#include <algorithm>
+
+TileWorkerPool::TileWorkerPool(int threadCount)
+{
+	threadCount = std::min(std::max(threadCount, 0), (int)MAXTHREADCOUNT);
+	m_shares.reset(new WorkerShare[std::max(threadCount, 1)]);
+	m_threads.reserve(threadCount);
+	for (int worker = 0; worker < threadCount; worker++)
+	{
+		m_threads.emplace_back(&TileWorkerPool::WorkerMain, this, worker);
+	}
+}
+
+TileWorkerPool::~TileWorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stopping = true;
+	}
+	m_workReady.notify_all();
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+int TileWorkerPool::GetThreadCount() const
+{
+	return (int)m_threads.size();
+}
+
+TileWorkerPoolStats TileWorkerPool::GetStats() const
+{
+	TileWorkerPoolStats stats;
+	stats.batches = m_batchCount;
+	stats.tasks = m_taskCount;
+	stats.steals = m_stealCount.load(std::memory_order_relaxed);
+	return stats;
+}
+
+//
+//  FUNCTION: Run
+//
+//  PURPOSE: Runs task(context, index) for every index from 0 to taskCount - 1 and returns once all of them are done. The
+//	tasks of a batch may run in any order and on any thread, they must not depend on each other.
+//
+void TileWorkerPool::Run(int taskCount, TaskFunction task, void* context)
+{
+	if (taskCount <= 0)
+	{
+		return;
+	}
+	m_batchCount++;
+	m_taskCount += taskCount;
+
+	if (m_threads.empty())
+	{
+		for (int index = 0; index < taskCount; index++)
+		{
+			task(context, index);
+		}
+		return;
+	}
+
+	int threadCount = (int)m_threads.size();
+	{
+		//Every worker is waiting for the next batch at this point, nobody else touches the shares.
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_task = task;
+		m_context = context;
+		for (int worker = 0; worker < threadCount; worker++)
+		{
+			m_shares[worker].begin = (int)((int64_t)taskCount * worker / threadCount);
+			m_shares[worker].end = (int)((int64_t)taskCount * (worker + 1) / threadCount);
+		}
+		m_busyWorkers = threadCount;
+		m_batch++;
+	}
+	m_workReady.notify_all();
+
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_workDone.wait(lock, [this] { return m_busyWorkers == 0; });
+}
+
+//
+//  FUNCTION: WorkerMain
+//
+//  PURPOSE: Body of every worker thread. Waits for a batch, runs tasks until there are none left to take or steal, then
+//	reports back and waits for the next one.
+//
+void TileWorkerPool::WorkerMain(int worker)
+{
+	uint64_t seenBatch = 0;
+	for (;;)
+	{
+		TaskFunction task;
+		void* context;
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_workReady.wait(lock, [&] { return m_stopping || m_batch != seenBatch; });
+			if (m_stopping)
+			{
+				return;
+			}
+			seenBatch = m_batch;
+			task = m_task;
+			context = m_context;
+		}
+
+		int index;
+		while (TakeTask(worker, index) || StealTasks(worker, index))
+		{
+			task(context, index);
+		}
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (--m_busyWorkers == 0)
+		{
+			m_workDone.notify_one();
+		}
+	}
+}
+
+bool TileWorkerPool::TakeTask(int worker, int& index)
+{
+	WorkerShare& share = m_shares[worker];
+	std::lock_guard<std::mutex> lock(share.lock);
+	if (share.begin >= share.end)
+	{
+		return false;
+	}
+	index = share.begin++;
+	return true;
+}
+
+//
+//  FUNCTION: StealTasks
+//
+//  PURPOSE: Takes the back half of the largest share of another thread. The first stolen task is returned in index, the
+//	others become the share of this thread. Returns false when every share is empty.
+//
+bool TileWorkerPool::StealTasks(int worker, int& index)
+{
+	int threadCount = (int)m_threads.size();
+	for (;;)
+	{
+		//The victim is picked one lock at a time, so by the time its lock is taken again it may have been emptied by its
+		//owner or another thief, and a thief's share may have grown past it. Its size is read again under its lock
+		//below, so at worst a smaller share than the largest is split, and an empty one sends the search round again.
+		int victim = -1;
+		int victimSize = 0;
+		for (int i = 1; i < threadCount; i++)
+		{
+			int candidate = (worker + i) % threadCount;
+			std::lock_guard<std::mutex> lock(m_shares[candidate].lock);
+			int size = m_shares[candidate].end - m_shares[candidate].begin;
+			if (size > victimSize)
+			{
+				victim = candidate;
+				victimSize = size;
+			}
+		}
+		if (victim < 0)
+		{
+			return false;
+		}
+
+		int first;
+		int end;
+		{
+			WorkerShare& share = m_shares[victim];
+			std::lock_guard<std::mutex> lock(share.lock);
+			int size = share.end - share.begin;
+			if (size <= 0)
+			{
+				continue;
+			}
+			end = share.end;
+			first = end - (size + 1) / 2;
+			share.end = first;
+		}
+		m_stealCount.fetch_add(1, std::memory_order_relaxed);
+
+		WorkerShare& own = m_shares[worker];
+		std::lock_guard<std::mutex> lock(own.lock);
+		own.begin = first + 1;
+		own.end = end;
+		index = first;
+		return true;
+	}
+}
@@ -0,0 +1,91 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+//  STRUCT: TileWorkerPoolStats
+//
+//  PURPOSE: Counters describing how the work of the pool was shared between its threads.
+//
+struct TileWorkerPoolStats
+{
+	uint64_t batches = 0;//Calls to Run
+	uint64_t tasks = 0;//Tasks run by all of them
+	uint64_t steals = 0;//Times a thread that ran out of work took half of another thread's tasks
+};
+
+//
+//  CLASS: TileWorkerPool
+//
+//  PURPOSE: Fixed set of threads running batches of independent tasks, numbered 0 to taskCount - 1. Run hands every
+//	thread a contiguous share of the batch up front, threads take tasks from the front of their own share and, once it is
+//	empty, steal the back half of the largest share they can find, so an uneven batch still keeps every thread busy.
+//	Shares are index ranges, so handing out and stealing work never allocates.
+//	Run blocks the calling thread until the whole batch is done. With no threads the tasks run in order on the calling
+//	thread, which is also the reference output any thread count has to match.
+//
+class TileWorkerPool
+{
+public:
+	typedef void (*TaskFunction)(void* context, int index);
+
+	explicit TileWorkerPool(int threadCount);
+	~TileWorkerPool();
+	TileWorkerPool(TileWorkerPool const&) = delete;
+	TileWorkerPool& operator=(TileWorkerPool const&) = delete;
+
+	int GetThreadCount() const;
+	void Run(int taskCount, TaskFunction task, void* context);
+	TileWorkerPoolStats GetStats() const;
+
+	//Highest number of threads a pool can have.
+	const static int MAXTHREADCOUNT = 64;
+
+private:
+	//Tasks begin to end - 1 belong to one thread. Kept on a cache line of its own, every thread locks its own share for
+	//every task it takes.
+	struct alignas(64) WorkerShare
+	{
+		std::mutex  lock;
+		int         begin = 0;
+		int         end = 0;
+	};
+
+	void WorkerMain(int worker);
+	bool TakeTask(int worker, int& index);
+	bool StealTasks(int worker, int& index);
+
+	//member variables
+	std::vector<std::thread>        m_threads;
+	std::unique_ptr<WorkerShare[]>  m_shares;
+	std::mutex                      m_lock;//Guards everything below, except the counters
+	std::condition_variable         m_workReady;
+	std::condition_variable         m_workDone;
+	uint64_t                        m_batch = 0;//Incremented by every Run, workers wait for it to change
+	int                             m_busyWorkers = 0;//Workers still running tasks of the current batch
+	bool                            m_stopping = false;
+	TaskFunction                    m_task = nullptr;
+	void*                           m_context = nullptr;
+	uint64_t                        m_batchCount = 0;
+	uint64_t                        m_taskCount = 0;
+	std::atomic<uint64_t>           m_stealCount{ 0 };
+};
@@ -0,0 +1,1689 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+// main.cpp : Headless benchmark for the TileScheduler. Replays recorded or synthetic InteractionTracker traces against a
+// recording renderer and reports how much tile work every update produced. Recorded traces are the binary ones written by
+// the Virtual Surfaces sample, or text ones. With --raster the tiles are rasterized on the
+// CPU instead, by a ParallelTileRenderer, to measure how that scales with the number of threads, --store-mb keeps
+// the rasterized tiles in a CompressedTileStore and --disk-cache in a TileDiskCache. With --telemetry the histograms of the pipeline telemetry are printed
+// under every row. --golden checks the checksum of the rasterized tiles of every trace against a file of known good ones,
+// so a change to the software rasterization that changes a single bit fails the run. --kernels times the pixel kernels of
+// the software canvas instead, for every instruction set the CPU supports. --coalescer checks the merges of the
+// TileRegionCoalescer against a plain reimplementation, and that a higher session cost never draws in more sessions.
+// --state-index checks the TileStateIndex against a plain array of tile states.
+
+#include "InteractionTrace.h"
+#include "ParallelTileRenderer.h"
+#include "PatternTileRasterizer.h"
+#include "SoftwareTileCanvas.h"
+#include "SurfaceChunker.h"
+#include "TileScheduler.h"
+#include "TileSizeCalibrator.h"
+#include "TileStateIndex.h"
+#include "TileTelemetry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+//Counts heap allocations made while the scheduler is running, to check that an update does not allocate. Every form of
+//operator new and delete is replaced, scalar and array, with and without alignment, so none of them gets past the count
+//and all of them go through the same malloc and free.
+static atomic<bool>     g_countAllocations{ false };
+static atomic<uint64_t> g_allocationCount{ 0 };
+
+//Alignments above what malloc gives are made by allocating more and keeping the pointer malloc returned just before the
+//aligned block.
+static void* CountedAllocate(size_t size, size_t alignment)
+{
+	if (g_countAllocations.load(memory_order_relaxed))
+	{
+		g_allocationCount.fetch_add(1, memory_order_relaxed);
+	}
+	size = size ? size : 1;
+	if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+	{
+		void* memory = malloc(size);
+		if (!memory)
+		{
+			throw bad_alloc();
+		}
+		return memory;
+	}
+	void* memory = malloc(size + alignment + sizeof(void*));
+	if (!memory)
+	{
+		throw bad_alloc();
+	}
+	uintptr_t aligned = ((uintptr_t)memory + sizeof(void*) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	((void**)aligned)[-1] = memory;
+	return (void*)aligned;
+}
+
+static void CountedFree(void* memory, size_t alignment) noexcept
+{
+	if (memory != nullptr && alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+	{
+		memory = ((void**)memory)[-1];
+	}
+	free(memory);
+}
+
+void* operator new(size_t size)
+{
+	return CountedAllocate(size, 0);
+}
+
+void* operator new[](size_t size)
+{
+	return CountedAllocate(size, 0);
+}
+
+void* operator new(size_t size, align_val_t alignment)
+{
+	return CountedAllocate(size, (size_t)alignment);
+}
+
+void* operator new[](size_t size, align_val_t alignment)
+{
+	return CountedAllocate(size, (size_t)alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+	CountedFree(memory, 0);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	CountedFree(memory, 0);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	CountedFree(memory, 0);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	CountedFree(memory, 0);
+}
+
+void operator delete(void* memory, align_val_t alignment) noexcept
+{
+	CountedFree(memory, (size_t)alignment);
+}
+
+void operator delete[](void* memory, align_val_t alignment) noexcept
+{
+	CountedFree(memory, (size_t)alignment);
+}
+
+void operator delete(void* memory, size_t, align_val_t alignment) noexcept
+{
+	CountedFree(memory, (size_t)alignment);
+}
+
+void operator delete[](void* memory, size_t, align_val_t alignment) noexcept
+{
+	CountedFree(memory, (size_t)alignment);
+}
+
+//
+//  CLASS: RecordingRenderer
+//
+//  PURPOSE: ITileRenderer that only logs the work it is asked to do. The log is replayed outside of the timed section
+//	so the bookkeeping needed for the redraw statistics is not charged to the scheduler. A per tile cost can be given
+//	to stand in for the time Direct2D spends rasterizing, which is what the frame budget is there to bound.
+//	Ranges are split into BeginDraw/EndDraw sessions by the same SurfaceChunker as the samples, to count the tiles each
+//	session goes through. Unbucketed, every session goes through the whole range, the way the renderer used to.
+//
+class RecordingRenderer : public ITileRenderer
+{
+public:
+	explicit RecordingRenderer(double tileCostUs = 0.0, int tileSize = 1, bool bucketTiles = true) :
+		m_tileCostUs(tileCostUs),
+		m_tileSize(tileSize),
+		m_bucketTiles(bucketTiles)
+	{
+		m_log.reserve(64);
+		m_trimRanges.reserve(64);
+		m_chunks.reserve(16);
+	}
+
+	bool DrawTileRange(TileRange const& range) override
+	{
+		m_log.push_back({ false, range, 0, 0 });
+		SplitIntoSessions(range, 0);
+		SpendTileCost(range.TileCount());
+		return true;
+	}
+
+	void Trim(vector<TileRange> const& keepRanges) override
+	{
+		m_log.push_back({ true, TileRange{}, m_trimRanges.size(), keepRanges.size() });
+		m_trimRanges.insert(m_trimRanges.end(), keepRanges.begin(), keepRanges.end());
+	}
+
+	//Coarse tiles have as many pixels as full resolution ones, so they cost the same to draw.
+	bool DrawLevelOfDetailRange(TileRange const& range, int level) override
+	{
+		coarseTilesDrawn += range.TileCount();
+		SplitIntoSessions(range, level);
+		SpendTileCost(range.TileCount());
+		return true;
+	}
+
+	//Replays the logged work. visibleRanges are the viewports after the update, used to spot tiles that were not drawn ahead.
+	void Commit(TileRange const* visibleRanges, int visibleRangeCount)
+	{
+		TileRange const& visible = visibleRanges[0];
+		int centerColumn = visible.startColumn + visible.numColumns / 2;
+		int centerRow = visible.startRow + visible.numRows / 2;
+		uint64_t tilesBefore = 0;
+		for (auto const& entry : m_log)
+		{
+			if (entry.isTrim)
+			{
+				ApplyTrim(entry.firstKeepRange, entry.keepRangeCount);
+				continue;
+			}
+			if (tilesBefore != UINT64_MAX && Contains(entry.range, centerColumn, centerRow))
+			{
+				centerDraws++;
+				tilesBeforeCenter += tilesBefore;
+				tilesBefore = UINT64_MAX;
+			}
+			else if (tilesBefore != UINT64_MAX)
+			{
+				tilesBefore += entry.range.TileCount();
+			}
+			ApplyDraw(entry.range, visibleRanges, visibleRangeCount);
+		}
+		m_log.clear();
+		m_trimRanges.clear();
+	}
+
+	uint64_t drawCalls = 0;
+	uint64_t trimCalls = 0;
+	uint64_t tilesDrawn = 0;
+	uint64_t tilesTrimmed = 0;
+	uint64_t redundantRedraws = 0;//Tiles that had already been drawn once before, resident or not.
+	uint64_t lateTiles = 0;//Tiles that were only drawn once they were already on screen.
+	uint64_t coarseTilesDrawn = 0;//Tiles drawn at a coarser level of detail while zooming.
+	uint64_t drawSessions = 0;//BeginDraw/EndDraw sessions, more than one per range when it exceeds the max texture size.
+	uint64_t tileFills = 0;//Tiles gone through by those sessions, each one a FillRectangle and a DrawText in the samples.
+	uint64_t centerDraws = 0;//Updates that drew the tile in the middle of the first viewport.
+	uint64_t tilesBeforeCenter = 0;//Tiles drawn in those updates before the range holding that tile.
+	size_t   peakResidentTiles = 0;
+
+	//Surface size in pixels, as in the Virtual Surfaces sample.
+	const static int MAXSURFACESIZE = 1 << 24;
+
+private:
+	struct LogEntry
+	{
+		bool        isTrim;
+		TileRange   range;
+		size_t      firstKeepRange;//Keep ranges of a trim, in m_trimRanges
+		size_t      keepRangeCount;
+	};
+
+	static uint64_t Key(int column, int row)
+	{
+		return ((uint64_t)(uint32_t)column << 32) | (uint32_t)row;
+	}
+
+	void SplitIntoSessions(TileRange const& range, int level)
+	{
+		SurfaceChunker::Split(range, m_tileSize, MAXSURFACESIZE >> level, m_chunks);
+		drawSessions += m_chunks.size();
+		for (SurfaceChunk const& chunk : m_chunks)
+		{
+			tileFills += m_bucketTiles ? chunk.tiles.TileCount() : range.TileCount();
+		}
+	}
+
+	void SpendTileCost(int tileCount)
+	{
+		if (m_tileCostUs > 0.0)
+		{
+			auto until = chrono::steady_clock::now() + chrono::duration<double, micro>(m_tileCostUs * tileCount);
+			while (chrono::steady_clock::now() < until)
+			{
+			}
+		}
+	}
+
+	static bool Contains(TileRange const& range, int column, int row)
+	{
+		return column >= range.startColumn && column < range.startColumn + range.numColumns &&
+			row >= range.startRow && row < range.startRow + range.numRows;
+	}
+
+	void ApplyDraw(TileRange const& range, TileRange const* visibleRanges, int visibleRangeCount)
+	{
+		drawCalls++;
+		for (int column = range.startColumn; column < range.startColumn + range.numColumns; column++)
+		{
+			for (int row = range.startRow; row < range.startRow + range.numRows; row++)
+			{
+				uint64_t key = Key(column, row);
+				tilesDrawn++;
+				//Drawing a tile that is still resident again is wasted work, but the user never saw it empty.
+				bool wasResident = !m_resident.insert(key).second;
+				bool visible = false;
+				for (int view = 0; view < visibleRangeCount && !visible; view++)
+				{
+					visible = Contains(visibleRanges[view], column, row);
+				}
+				if (!wasResident && visible)
+				{
+					lateTiles++;
+				}
+				if (!m_everDrawn.insert(key).second)
+				{
+					redundantRedraws++;
+				}
+			}
+		}
+		peakResidentTiles = max(peakResidentTiles, m_resident.size());
+	}
+
+	void ApplyTrim(size_t firstKeepRange, size_t keepRangeCount)
+	{
+		trimCalls++;
+		for (auto it = m_resident.begin(); it != m_resident.end();)
+		{
+			int column = (int)(uint32_t)(*it >> 32);
+			int row = (int)(uint32_t)(*it & 0xFFFFFFFF);
+			bool keep = false;
+			for (size_t i = firstKeepRange; i < firstKeepRange + keepRangeCount && !keep; i++)
+			{
+				keep = Contains(m_trimRanges[i], column, row);
+			}
+			if (keep)
+			{
+				++it;
+			}
+			else
+			{
+				it = m_resident.erase(it);
+				tilesTrimmed++;
+			}
+		}
+	}
+
+	double                      m_tileCostUs;
+	int                         m_tileSize;
+	bool                        m_bucketTiles;
+	vector<SurfaceChunk>        m_chunks;
+	vector<LogEntry>            m_log;
+	vector<TileRange>           m_trimRanges;
+	unordered_set<uint64_t>     m_everDrawn;
+	unordered_set<uint64_t>     m_resident;
+};
+
+//
+//  CLASS: RasterizingRenderer
+//
+//  PURPOSE: ITileRenderer that rasterizes tiles on the CPU through a ParallelTileRenderer. The upload is a checksum of
+//	the staging image, line by line, which is also how the output of different thread counts is compared.
+//
+class RasterizingRenderer : public ITileRenderer, public ITileUploader
+{
+public:
+	RasterizingRenderer(int tileSize, int threadCount, bool labels, size_t storeBudgetBytes, string const& diskCachePath) :
+		m_tileSize(tileSize),
+		m_renderer(m_rasterizer, tileSize, threadCount)
+	{
+		m_rasterizer.EnableLabels(labels ? tileSize : 0);
+		m_renderer.SetUploader(this);
+		if (storeBudgetBytes > 0)
+		{
+			m_store.SetBudget(storeBudgetBytes);
+			m_renderer.SetTileStore(&m_store);
+		}
+		if (!diskCachePath.empty() && m_diskCache.Open(diskCachePath))
+		{
+			m_renderer.SetDiskCache(&m_diskCache, PATTERNCONTENTHASH, labels ? 1 : 0);
+		}
+	}
+
+	bool DrawTileRange(TileRange const& range) override
+	{
+		return m_renderer.DrawTileRange(range, 0);
+	}
+
+	void Trim(vector<TileRange> const&) override
+	{
+	}
+
+	bool DrawLevelOfDetailRange(TileRange const& range, int level) override
+	{
+		return m_renderer.DrawTileRange(range, level);
+	}
+
+	bool UploadTileRange(TileRange const& range, int level, uint32_t const* pixels, ptrdiff_t stride) override
+	{
+		uint64_t sum = 0;
+		uint64_t sumOfSums = 0;
+		for (int line = 0; line < range.numRows * m_tileSize; line++, pixels += stride)
+		{
+			for (int x = 0; x < range.numColumns * m_tileSize; x++)
+			{
+				sum += pixels[x];
+				sumOfSums += sum;
+			}
+		}
+		m_checksum = (m_checksum ^ sumOfSums ^ (sum << 32) ^ Key(range.startColumn, range.startRow) ^ (uint64_t)level) * 0x100000001B3ull;
+		return true;
+	}
+
+	ParallelTileRenderer const& GetRenderer() const
+	{
+		return m_renderer;
+	}
+
+	uint64_t GetChecksum() const
+	{
+		return m_checksum;
+	}
+
+	TileStoreStats GetStoreStats() const
+	{
+		return m_store.GetStats();
+	}
+
+	TileDiskCacheStats GetDiskCacheStats() const
+	{
+		return m_diskCache.GetStats();
+	}
+
+	//Identifies the tiles of the PatternTileRasterizer in the disk cache. Change it whenever their pixels change.
+	const static uint64_t PATTERNCONTENTHASH = 0x5041545445524E31ull;
+
+private:
+	static uint64_t Key(int column, int row)
+	{
+		return ((uint64_t)(uint32_t)column << 32) | (uint32_t)row;
+	}
+
+	int                     m_tileSize;
+	PatternTileRasterizer   m_rasterizer;
+	CompressedTileStore     m_store;
+	TileDiskCache           m_diskCache;
+	ParallelTileRenderer    m_renderer;
+	uint64_t                m_checksum = 0xCBF29CE484222325ull;
+};
+
+//
+//  CLASS: RasterCostProbe
+//
+//  PURPOSE: ITileCostProbe for --tile-size auto. Rasterizes the tiles with the PatternTileRasterizer on the calling
+//	thread, plus the per tile cost given with --tile-cost, which stands in for the fixed cost of the Direct2D calls.
+//
+class RasterCostProbe : public ITileCostProbe
+{
+public:
+	RasterCostProbe(double tileCostUs, bool labels) : m_tileCostUs(tileCostUs), m_labels(labels) {}
+
+	double MeasureTilesUs(int tileSize, int tileCount) override
+	{
+		m_rasterizer.EnableLabels(m_labels ? tileSize : 0);
+		m_pixels.resize((size_t)tileSize * tileSize);
+		auto start = chrono::steady_clock::now();
+		for (int i = 0; i < tileCount; i++)
+		{
+			m_rasterizer.RasterizeTile(TileCoordinate{ i, 0 }, 0, tileSize, 0, tileSize, m_pixels.data(), tileSize);
+			auto until = chrono::steady_clock::now() + chrono::duration<double, micro>(m_tileCostUs);
+			while (chrono::steady_clock::now() < until)
+			{
+			}
+		}
+		return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	double                  m_tileCostUs;
+	bool                    m_labels;
+	PatternTileRasterizer   m_rasterizer;
+	vector<uint32_t>        m_pixels;
+};
+
+//
+//  FUNCTION: MakeScenario
+//
+//  PURPOSE: Builds the synthetic traces used when no recorded trace is given. All of them run at 60Hz in a 1280x720 window.
+//
+static bool MakeScenario(string const& name, vector<InteractionEvent>& events)
+{
+	const double frameMs = 1000.0 / 60.0;
+	double t = 0.0;
+	auto push = [&](InteractionEvent::Kind kind, float x, float y, float scale)
+	{
+		InteractionEvent e;
+		e.timeMs = t;
+		e.kind = kind;
+		e.x = x;
+		e.y = y;
+		e.scale = scale;
+		events.push_back(e);
+	};
+
+	push(InteractionEvent::Kind::Size, 1280.0f, 720.0f, 1.0f);
+
+	if (name == "pan")
+	{
+		//Steady vertical pan at 2000 px/s for five seconds.
+		for (int frame = 0; frame < 300; frame++, t += frameMs)
+		{
+			push(InteractionEvent::Kind::Values, 0.0f, (float)(frame * 2000.0 / 60.0), 1.0f);
+		}
+		push(InteractionEvent::Kind::Idle, 0.0f, 0.0f, 1.0f);
+	}
+	else if (name == "fling")
+	{
+		//Diagonal fling starting at 20000 px/s, decaying like InteractionTracker inertia. The inertia event carries the
+		//resting position, so the fling is simulated first.
+
+		float x = 0.0f;
+		float y = 0.0f;
+		float velocity = 20000.0f;
+		for (int frame = 0; frame < 240 && velocity > 10.0f; frame++, t += frameMs)
+		{
+			x += velocity * 0.6f / 60.0f;
+			y += velocity * 0.8f / 60.0f;
+			velocity *= 0.95f;
+			push(InteractionEvent::Kind::Values, x, y, 1.0f);
+		}
+		events.insert(events.begin() + 1, InteractionEvent{ 0.0, InteractionEvent::Kind::Inertia, x, y, 1.0f });
+		push(InteractionEvent::Kind::Idle, x, y, 1.0f);
+	}
+	else if (name == "diagonal")
+	{
+		//Diagonal pan at 1500 px/s, which exposes a row and a column of tiles at different times, so the new tiles often
+		//form an L.
+		for (int frame = 0; frame < 300; frame++, t += frameMs)
+		{
+			float distance = (float)(frame * 1500.0 / 60.0);
+			push(InteractionEvent::Kind::Values, distance * 0.8f, distance * 0.6f, 1.0f);
+		}
+		push(InteractionEvent::Kind::Idle, 0.0f, 0.0f, 1.0f);
+	}
+	else if (name == "jitter")
+	{
+		//Panning back and forth by about one tile around a fixed point.
+		for (int frame = 0; frame < 300; frame++, t += frameMs)
+		{
+			float x = 5000.0f + 300.0f * (float)sin(frame * 0.2);
+			push(InteractionEvent::Kind::Values, x, 5000.0f, 1.0f);
+		}
+		push(InteractionEvent::Kind::Idle, 0.0f, 0.0f, 1.0f);
+	}
+	else if (name == "zoom")
+	{
+		//Pinch out to 0.3x and back in, with a pan in between each zoom.
+		for (int cycle = 0; cycle < 4; cycle++)
+		{
+			for (int frame = 0; frame < 30; frame++, t += frameMs)
+			{
+				float scale = 1.0f - 0.7f * (float)frame / 29.0f;
+				push(InteractionEvent::Kind::Values, 2000.0f * scale, 2000.0f * scale, scale);
+			}
+			push(InteractionEvent::Kind::Idle, 600.0f, 600.0f, 0.3f);
+			for (int frame = 0; frame < 30; frame++, t += frameMs)
+			{
+				push(InteractionEvent::Kind::Values, 600.0f + frame * 10.0f, 600.0f, 0.3f);
+			}
+			for (int frame = 0; frame < 30; frame++, t += frameMs)
+			{
+				float scale = 0.3f + 0.7f * (float)frame / 29.0f;
+				push(InteractionEvent::Kind::Values, 900.0f / 0.3f * scale, 600.0f / 0.3f * scale, scale);
+			}
+			push(InteractionEvent::Kind::Idle, 0.0f, 0.0f, 1.0f);
+		}
+	}
+	else if (name == "resize")
+	{
+		//Window being dragged between 800x600 and 3840x2160.
+		for (int frame = 0; frame < 120; frame++, t += frameMs)
+		{
+			float amount = 0.5f - 0.5f * (float)cos(frame * 0.1);
+			push(InteractionEvent::Kind::Size, 800.0f + 3040.0f * amount, 600.0f + 1560.0f * amount, 1.0f);
+		}
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+struct BenchmarkOptions
+{
+	int     tileSize = 250;
+	int     drawAheadTileCount = 1;
+	int     maxDrawAheadTileCount = 4;
+	int     levelOfDetailCount = 2;
+	double  frameBudgetMs = 0.0;
+	double  tileCostUs = 0.0;
+	int     cacheMegabytes = 64;
+	int     trimMarginTileCount = 2;
+	int     trimDeferral = TileScheduler::DEFAULTTRIMDEFERRAL;//Updates a trim may wait for a frame with time to spare
+	bool    bucketTiles = true;
+	int     sessionCostTiles = TileRegionCoalescer::DEFAULTSESSIONCOST;
+	int     repeat = 20;
+	bool    raster = false;
+	bool    labels = true;//Draw the tile labels when rasterizing on the CPU
+	int     storeMegabytes = 0;//Budget of the compressed tile store when rasterizing on the CPU, 0 for none
+	string  diskCachePath;//File of the disk tile cache when rasterizing on the CPU, empty for none
+	int     maxThreadCount = TileWorkerPool::MAXTHREADCOUNT;
+	bool    calibrateTileSize = false;
+	bool    powerOfTwoTiles = false;
+	double  pace = 0.0;
+	int64_t origin = 0;//Surface pixel the trace positions are relative to, on both axes
+	int     viewCount = 1;//Viewports the trace is replayed in, side by side
+	int     viewOffset = 0;//Horizontal distance between those viewports, in surface pixels
+	bool    telemetry = true;
+	bool    printTelemetry = false;
+	string  chromeTracePath;
+	string  saveTracePath;
+	string  goldenPath;//File of the known good checksums of the rasterized tiles, empty for none
+	bool    kernels = false;//Time the pixel kernels instead of replaying traces
+	bool    checkCoalescer = false;//Check the coalescer instead of replaying traces
+	bool    checkStateIndex = false;//Check the tile state index instead of replaying traces
+	TileOrder tileOrder = TileOrder::CenterOut;//Order the blocks of a range are drawn in
+	int     adaptiveDrawAheadTileCount = 0;//Most the governor may grow the draw ahead at rest to, 0 keeps it fixed
+};
+
+//
+//  STRUCT: GoldenChecksums
+//
+//  PURPOSE: The checksums of the rasterized tiles of every trace a run is expected to produce, one "name checksum" line
+//	per trace in a text file. Traces that are not in the file yet are added to it, which is how it is written the first
+//	time.
+//
+struct GoldenChecksums
+{
+	bool Load(string const& path)
+	{
+		m_path = path;
+		FILE* file = fopen(path.c_str(), "r");
+		if (!file)
+		{
+			return true;
+		}
+		char name[1024];
+		unsigned long long checksum;
+		while (fscanf(file, "%1023s %llx", name, &checksum) == 2)
+		{
+			m_checksums[name] = checksum;
+		}
+		bool read = !ferror(file);
+		fclose(file);
+		return read;
+	}
+
+	//Returns false when the trace is known and its checksum is not the one expected.
+	bool Check(string const& name, uint64_t checksum)
+	{
+		auto found = m_checksums.find(name);
+		if (found == m_checksums.end())
+		{
+			m_checksums[name] = checksum;
+			m_changed = true;
+			return true;
+		}
+		if (found->second != checksum)
+		{
+			fprintf(stderr, "golden checksum of '%s' is %016llx, the tiles came out as %016llx\n", name.c_str(), (unsigned long long)found->second, (unsigned long long)checksum);
+			return false;
+		}
+		return true;
+	}
+
+	bool Save() const
+	{
+		if (!m_changed)
+		{
+			return true;
+		}
+		FILE* file = fopen(m_path.c_str(), "w");
+		if (!file)
+		{
+			return false;
+		}
+		for (auto const& entry : m_checksums)
+		{
+			fprintf(file, "%s %016llx\n", entry.first.c_str(), (unsigned long long)entry.second);
+		}
+		return fclose(file) == 0;
+	}
+
+	//member variables
+	string                      m_path;
+	map<string, uint64_t>       m_checksums;
+	bool                        m_changed = false;
+};
+
+static double Percentile(vector<double>& samples, double percentile)
+{
+	if (samples.empty())
+	{
+		return 0.0;
+	}
+	size_t index = (size_t)(percentile * (samples.size() - 1));
+	nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+//
+//  FUNCTION: RunTrace
+//
+//  PURPOSE: Replays a trace against a fresh scheduler and prints one result row. The trace is replayed several times on
+//	fresh schedulers to get stable timings; the tile counts are taken from the first replay. Every event is treated as a
+//	frame: after the event is applied, queued tiles are processed the way the samples' frame timer does, and the time of
+//	both together is what is reported.
+//
+static void RunTrace(string const& name, vector<InteractionEvent> const& events, BenchmarkOptions const& options)
+{
+	using clock = chrono::steady_clock;
+
+	RecordingRenderer firstRenderer;
+	TileWorkQueueStats firstQueueStats;
+	TileCacheStats firstCacheStats;
+	DrawAheadStats firstDrawAheadStats;
+	vector<double> updateMicroseconds;
+	updateMicroseconds.reserve(events.size() * options.repeat);
+	uint64_t updates = 0;
+	uint64_t allocations = 0;
+
+	for (int iteration = 0; iteration < options.repeat; iteration++)
+	{
+		RecordingRenderer renderer(options.tileCostUs, options.tileSize, options.bucketTiles);
+		TileScheduler scheduler(options.tileSize, options.drawAheadTileCount, options.maxDrawAheadTileCount);
+		scheduler.SetRenderer(&renderer);
+		scheduler.SetFrameBudget(options.frameBudgetMs);
+		scheduler.SetLevelOfDetailCount(options.levelOfDetailCount);
+		scheduler.SetCacheBudget((size_t)options.cacheMegabytes * 1024 * 1024, options.trimMarginTileCount);
+		scheduler.SetTrimDeferral(options.trimDeferral);
+		scheduler.SetSessionCost(options.sessionCostTiles);
+		scheduler.SetTileOrder(options.tileOrder);
+		scheduler.SetAdaptiveDrawAhead(0, options.adaptiveDrawAheadTileCount);
+		scheduler.SetSurfaceOrigin(options.origin, options.origin);
+		vector<InteractionTraceReplayer> replayers(options.viewCount, InteractionTraceReplayer(scheduler));
+		replayers[0].SetPace(options.pace);
+		for (int view = 1; view < options.viewCount; view++)
+		{
+			replayers[view].SetViewport(scheduler.AddViewport(), (double)view * options.viewOffset, 0.0);
+		}
+		TileRange visibleRanges[TileScheduler::MAXVIEWPORTCOUNT];
+
+		for (auto const& e : events)
+		{
+			replayers[0].WaitUntilDue(e);
+			uint64_t allocationsBefore = g_allocationCount.load();
+			g_countAllocations = true;
+			auto start = clock::now();
+			bool updated = false;
+			for (auto& replayer : replayers)
+			{
+				updated = replayer.Apply(e) || updated;
+			}
+			bool pending = scheduler.HasPendingTiles();
+			if (pending)
+			{
+				scheduler.ProcessPendingTiles();
+			}
+			auto end = clock::now();
+			g_countAllocations = false;
+			allocations += g_allocationCount.load() - allocationsBefore;
+
+			if (updated || pending)
+			{
+				updateMicroseconds.push_back(chrono::duration<double, micro>(end - start).count());
+			}
+			if (updated && iteration == 0)
+			{
+				updates++;
+			}
+
+			for (int view = 0; view < options.viewCount; view++)
+			{
+				visibleRanges[view] = scheduler.GetVisibleRange(view);
+			}
+			renderer.Commit(visibleRanges, options.viewCount);
+		}
+
+		if (iteration == 0)
+		{
+			firstRenderer = renderer;
+			firstQueueStats = scheduler.GetQueueStats();
+			firstCacheStats = scheduler.GetCacheStats();
+			firstDrawAheadStats = scheduler.GetDrawAheadStats();
+		}
+	}
+
+	double total = 0.0;
+	for (double sample : updateMicroseconds)
+	{
+		total += sample;
+	}
+	double mean = updateMicroseconds.empty() ? 0.0 : total / updateMicroseconds.size();
+	double maximum = updateMicroseconds.empty() ? 0.0 : *max_element(updateMicroseconds.begin(), updateMicroseconds.end());
+	double p50 = Percentile(updateMicroseconds, 0.50);
+	double p99 = Percentile(updateMicroseconds, 0.99);
+
+	printf("%-16s %8llu %8llu %8llu %10llu %10llu %10llu %10llu %8llu %8llu %8.1f %10zu %6.1f %9llu %8llu %8d %9llu %9llu %6d %8.2f %8llu %9.3f %9.3f %9.3f %9.3f\n",
+		name.c_str(),
+		(unsigned long long)updates,
+		(unsigned long long)firstRenderer.drawCalls,
+		(unsigned long long)firstRenderer.drawSessions,
+		(unsigned long long)firstRenderer.tileFills,
+		(unsigned long long)firstRenderer.tilesDrawn,
+		(unsigned long long)firstRenderer.tilesTrimmed,
+		(unsigned long long)firstRenderer.redundantRedraws,
+		(unsigned long long)firstRenderer.lateTiles,
+		(unsigned long long)firstRenderer.coarseTilesDrawn,
+		firstRenderer.centerDraws > 0 ? (double)firstRenderer.tilesBeforeCenter / firstRenderer.centerDraws : 0.0,
+		firstRenderer.peakResidentTiles,
+		firstCacheStats.HitRate() * 100.0,
+		(unsigned long long)firstCacheStats.evictions,
+		(unsigned long long)firstCacheStats.refills,
+		firstQueueStats.peakPendingTiles,
+		(unsigned long long)firstQueueStats.budgetOverruns,
+		(unsigned long long)firstQueueStats.cancelledTiles,
+		firstDrawAheadStats.tileCount,
+		firstDrawAheadStats.tileCostMs * 1000.0,
+		(unsigned long long)allocations,
+		mean, p50, p99, maximum);
+}
+
+//
+//  FUNCTION: RunRasterScaling
+//
+//  PURPOSE: Replays a trace with the tiles rasterized on the CPU, once for every power of two number of threads up to
+//	maxThreadCount, and prints one row for each. The frame budget is ignored, every tile is drawn. Speedup is the raster
+//	throughput against the single thread row, and every row has to produce the same checksum as that one, which is
+//	written to checksum. Returns false when a row does not.
+//
+static bool RunRasterScaling(string const& name, vector<InteractionEvent> const& events, BenchmarkOptions const& options, uint64_t& singleThreadChecksum)
+{
+	vector<int> threadCounts;
+	for (int threadCount = 1; threadCount < options.maxThreadCount; threadCount *= 2)
+	{
+		threadCounts.push_back(threadCount);
+	}
+	threadCounts.push_back(options.maxThreadCount);
+
+	double singleThreadRate = 0.0;
+	singleThreadChecksum = 0;
+	bool identical = true;
+	for (int threadCount : threadCounts)
+	{
+		ParallelRenderStats stats;
+		TileWorkerPoolStats poolStats;
+		TileStoreStats storeStats;
+		double diskIndexMs = 0.0;
+		uint64_t checksum = 0;
+		for (int iteration = 0; iteration < options.repeat; iteration++)
+		{
+			RasterizingRenderer renderer(options.tileSize, threadCount, options.labels, (size_t)options.storeMegabytes * 1024 * 1024, options.diskCachePath);
+			TileScheduler scheduler(options.tileSize, options.drawAheadTileCount, options.maxDrawAheadTileCount);
+			scheduler.SetRenderer(&renderer);
+			scheduler.SetLevelOfDetailCount(options.levelOfDetailCount);
+			scheduler.SetCacheBudget((size_t)options.cacheMegabytes * 1024 * 1024, options.trimMarginTileCount);
+			scheduler.SetTrimDeferral(options.trimDeferral);
+			scheduler.SetSessionCost(options.sessionCostTiles);
+			scheduler.SetTileOrder(options.tileOrder);
+			scheduler.SetSurfaceOrigin(options.origin, options.origin);
+			InteractionTraceReplayer replayer(scheduler);
+			for (auto const& e : events)
+			{
+				replayer.Apply(e);
+			}
+
+			ParallelRenderStats replayStats = renderer.GetRenderer().GetStats();
+			TileWorkerPoolStats replayPoolStats = renderer.GetRenderer().GetPoolStats();
+			TileStoreStats replayStoreStats = renderer.GetStoreStats();
+			stats.tiles += replayStats.tiles;
+			stats.restoredTiles += replayStats.restoredTiles;
+			stats.diskTiles += replayStats.diskTiles;
+			stats.tasks += replayStats.tasks;
+			stats.rasterMs += replayStats.rasterMs;
+			stats.uploadMs += replayStats.uploadMs;
+			stats.compressMs += replayStats.compressMs;
+			poolStats.steals += replayPoolStats.steals;
+			storeStats.rawBytes += replayStoreStats.rawBytes;
+			storeStats.compressedBytes += replayStoreStats.compressedBytes;
+			diskIndexMs += renderer.GetDiskCacheStats().indexMs;
+			checksum = renderer.GetChecksum();
+		}
+
+		double megapixels = (double)stats.tiles * options.tileSize * options.tileSize / 1e6;
+		double rate = stats.rasterMs > 0.0 ? megapixels / (stats.rasterMs / 1000.0) : 0.0;
+		if (threadCount == threadCounts.front())
+		{
+			singleThreadRate = rate;
+			singleThreadChecksum = checksum;
+		}
+
+		printf("%-16s %8d %10llu %10llu %10llu %10llu %9llu %10.2f %10.2f %10.2f %10.2f %10.1f %8.2f %8.1f %016llx %s\n",
+			name.c_str(),
+			threadCount,
+			(unsigned long long)(stats.tiles / options.repeat),
+			(unsigned long long)(stats.restoredTiles / options.repeat),
+			(unsigned long long)(stats.diskTiles / options.repeat),
+			(unsigned long long)(stats.tasks / options.repeat),
+			(unsigned long long)(poolStats.steals / options.repeat),
+			stats.rasterMs / options.repeat,
+			stats.uploadMs / options.repeat,
+			stats.compressMs / options.repeat,
+			diskIndexMs / options.repeat,
+			rate,
+			singleThreadRate > 0.0 ? rate / singleThreadRate : 0.0,
+			storeStats.CompressionRatio(),
+			(unsigned long long)checksum,
+			checksum == singleThreadChecksum ? "" : "MISMATCH");
+		identical = identical && checksum == singleThreadChecksum;
+	}
+	return identical;
+}
+
+//Premultiplied pixels with every alpha and channels up to it, different for every seed.
+static void FillPremultipliedPattern(vector<uint32_t>& pixels, uint32_t seed)
+{
+	for (size_t i = 0; i < pixels.size(); i++)
+	{
+		uint32_t value = (uint32_t)i + seed;
+		uint32_t alpha = (value * 73 + 41) & 255;
+		uint32_t pixel = alpha << 24;
+		for (uint32_t channel = 0; channel < 3; channel++)
+		{
+			pixel |= ((value * (channel * 29 + 7)) >> 3) % (alpha + 1) << (channel * 8);
+		}
+		pixels[i] = pixel;
+	}
+}
+
+//
+//  FUNCTION: RunKernelBenchmark
+//
+//  PURPOSE: Times the operations of the SoftwareTileCanvas on one tile of each size with every PixelKernels set the CPU
+//	runs, and prints the throughput in GB/s of pixels drawn. The tile stays in cache, so this is the speed of the kernels
+//	rather than of memory. Every set has to draw the same bits as the scalar one, rows that do not are marked MISMATCH.
+//
+static bool RunKernelBenchmark()
+{
+	static const int tileSizes[] = { 64, 128, 256, 512 };
+	static const char* const operations[] = { "clear", "fill", "blend", "bitmap", "outline" };
+	const int operationCount = 5;
+
+	printf("premultiplied B8G8R8A8 kernels, GB/s of pixels drawn, best kernels for this CPU: %s\n\n", PixelKernels::Get().name);
+	printf("%-8s %8s %10s %10s %10s %10s %10s %16s\n", "kernels", "tile", operations[0], operations[1], operations[2], operations[3], operations[4], "checksum");
+	bool identical = true;
+	for (int tileSize : tileSizes)
+	{
+		float size = (float)tileSize;
+		vector<uint32_t> pixels((size_t)tileSize * tileSize);
+		vector<uint32_t> bitmap(pixels.size());
+		FillPremultipliedPattern(bitmap, 0);
+		//The outline is 4 pixels wide, centered on a rectangle 8 pixels inside the tile.
+		double outlinePixels = (double)(tileSize - 12) * (tileSize - 12) - (double)(tileSize - 20) * (tileSize - 20);
+		auto draw = [&](SoftwareTileCanvas& canvas, int operation)
+		{
+			switch (operation)
+			{
+			case 0: canvas.Clear(0); break;
+			case 1: canvas.FillRectangle(CanvasRect{ 0.0f, 0.0f, size, size }, 0xFF208040); break;
+			case 2: canvas.FillRectangle(CanvasRect{ 0.0f, 0.0f, size, size }, 0x80408000); break;
+			case 3: canvas.DrawBitmap(bitmap.data(), tileSize, tileSize, tileSize, 0, 0); break;
+			default: canvas.DrawRectangle(CanvasRect{ 8.0f, 8.0f, size - 8.0f, size - 8.0f }, 0x80343434, 4.0f); break;
+			}
+		};
+
+		uint64_t scalarChecksum = 0;
+		for (int index = 0; PixelKernels const* kernels = PixelKernels::GetSupported(index); index++)
+		{
+			double rates[operationCount];
+			uint64_t checksum = 0xCBF29CE484222325ull;
+			for (int operation = 0; operation < operationCount; operation++)
+			{
+				SoftwareTileCanvas canvas(pixels.data(), tileSize, 0, 0, tileSize, tileSize);
+				canvas.SetKernels(*kernels);
+
+				FillPremultipliedPattern(pixels, 12345);
+				draw(canvas, operation);
+				for (uint32_t pixel : pixels)
+				{
+					checksum = (checksum ^ pixel) * 0x100000001B3ull;
+				}
+
+				//Batches of draws, twice as many every time, until they take long enough to time.
+				double bytes = (operation == 4 ? outlinePixels : (double)pixels.size()) * sizeof(uint32_t);
+				int64_t drawCount = 0;
+				double seconds = 0.0;
+				for (int64_t batch = 1; seconds < 0.02; batch *= 2)
+				{
+					auto start = chrono::steady_clock::now();
+					for (int64_t i = 0; i < batch; i++)
+					{
+						draw(canvas, operation);
+					}
+					seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+					drawCount += batch;
+				}
+				rates[operation] = bytes * drawCount / seconds / 1e9;
+			}
+
+			if (index == 0)
+			{
+				scalarChecksum = checksum;
+			}
+			identical = identical && checksum == scalarChecksum;
+			printf("%-8s %8d %10.2f %10.2f %10.2f %10.2f %10.2f %016llx %s\n",
+				kernels->name, tileSize, rates[0], rates[1], rates[2], rates[3], rates[4],
+				(unsigned long long)checksum, checksum == scalarChecksum ? "" : "MISMATCH");
+		}
+	}
+	return identical;
+}
+
+//The session costs --coalescer replays the traces at, lowest first.
+static const int CHECKEDSESSIONCOSTS[] = { 0, 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 64 };
+//Random sets of ranges --coalescer compares the coalescer on.
+static const int COALESCERCASECOUNT = 10000;
+
+static TileRange BoundingRange(TileRange const& a, TileRange const& b)
+{
+	int left = min(a.startColumn, b.startColumn);
+	int top = min(a.startRow, b.startRow);
+	int right = max(a.startColumn + a.numColumns, b.startColumn + b.numColumns);
+	int bottom = max(a.startRow + a.numRows, b.startRow + b.numRows);
+	return TileRange{ left, top, right - left, bottom - top };
+}
+
+//
+//  FUNCTION: CoalesceReference
+//
+//  PURPOSE: The cost based merges of TileRegionCoalescer::Coalesce done the plain way, with every pair priced again
+//	after every merge, for --coalescer to check the incremental pricing against. The ranges have had their exact merges
+//	made already.
+//
+static void CoalesceReference(vector<TileRange>& ranges, int sessionCost, TileWorkQueue const* queue, TileRange const& visibleRange)
+{
+	if (ranges.size() > TileRegionCoalescer::MAXCOSTMERGERANGES)
+	{
+		return;
+	}
+
+	vector<int> rangeSessions;
+	for (;;)
+	{
+		rangeSessions.clear();
+		for (TileRange const& range : ranges)
+		{
+			rangeSessions.push_back(TileRegionCoalescer::CountSessions(range, queue, visibleRange));
+		}
+
+		bool found = false;
+		size_t bestFirst = 0;
+		TileRange bestBounds;
+		int64_t bestExtraTiles = 0;
+		int64_t bestSavedSessions = 0;
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			for (size_t j = i + 1; j < ranges.size(); j++)
+			{
+				TileRange bounds = BoundingRange(ranges[i], ranges[j]);
+				bool grown = true;
+				while (grown)
+				{
+					grown = false;
+					for (TileRange const& other : ranges)
+					{
+						if (!bounds.Intersect(other).IsEmpty() && !bounds.Contains(other))
+						{
+							bounds = BoundingRange(bounds, other);
+							grown = true;
+						}
+					}
+				}
+
+				int64_t extraTiles = bounds.TileCount();
+				int64_t savedSessions = -TileRegionCoalescer::CountSessions(bounds, queue, visibleRange);
+				for (size_t k = 0; k < ranges.size(); k++)
+				{
+					if (bounds.Contains(ranges[k]))
+					{
+						extraTiles -= ranges[k].TileCount();
+						savedSessions += rangeSessions[k];
+					}
+				}
+				if (savedSessions > 0 && (!found || extraTiles * bestSavedSessions < bestExtraTiles * savedSessions))
+				{
+					found = true;
+					bestFirst = i;
+					bestBounds = bounds;
+					bestExtraTiles = extraTiles;
+					bestSavedSessions = savedSessions;
+				}
+			}
+		}
+		if (!found || bestExtraTiles >= (int64_t)sessionCost * bestSavedSessions)
+		{
+			return;
+		}
+
+		size_t kept = 0;
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			if (i == bestFirst)
+			{
+				ranges[kept++] = bestBounds;
+			}
+			else if (!bestBounds.Contains(ranges[i]))
+			{
+				ranges[kept++] = ranges[i];
+			}
+		}
+		ranges.resize(kept);
+	}
+}
+
+static bool SameRanges(vector<TileRange> const& a, vector<TileRange> const& b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].startColumn != b[i].startColumn || a[i].startRow != b[i].startRow || a[i].numColumns != b[i].numColumns || a[i].numRows != b[i].numRows)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//
+//  FUNCTION: ReplaySessions
+//
+//  PURPOSE: Replays a trace once with the given session cost and the tile work of every event processed, the way
+//	RunTrace does, into the renderer given.
+//
+static void ReplaySessions(vector<InteractionEvent> const& events, BenchmarkOptions const& options, int sessionCost, RecordingRenderer& renderer)
+{
+	TileScheduler scheduler(options.tileSize, options.drawAheadTileCount, options.maxDrawAheadTileCount);
+	scheduler.SetRenderer(&renderer);
+	scheduler.SetFrameBudget(options.frameBudgetMs);
+	scheduler.SetLevelOfDetailCount(options.levelOfDetailCount);
+	scheduler.SetCacheBudget((size_t)options.cacheMegabytes * 1024 * 1024, options.trimMarginTileCount);
+	scheduler.SetTrimDeferral(options.trimDeferral);
+	scheduler.SetSessionCost(sessionCost);
+	scheduler.SetTileOrder(options.tileOrder);
+	scheduler.SetSurfaceOrigin(options.origin, options.origin);
+	InteractionTraceReplayer replayer(scheduler);
+	for (auto const& e : events)
+	{
+		replayer.Apply(e);
+		if (scheduler.HasPendingTiles())
+		{
+			scheduler.ProcessPendingTiles();
+		}
+		TileRange visibleRange = scheduler.GetVisibleRange(TileScheduler::DEFAULTVIEWPORT);
+		renderer.Commit(&visibleRange, 1);
+	}
+}
+
+//
+//  FUNCTION: RunCoalescerCheck
+//
+//  PURPOSE: Checks the TileRegionCoalescer. It is run on random sets of column runs, with and without a work queue to
+//	count sessions in, and has to merge them exactly as CoalesceReference does. Then every trace is replayed at rising
+//	session costs, and a higher cost must never end with more BeginDraw/EndDraw sessions than a lower one. Rows where it
+//	does are marked MORE.
+//
+static bool RunCoalescerCheck(vector<pair<string, vector<InteractionEvent>>> const& traces, BenchmarkOptions const& options)
+{
+	mt19937 random(1);
+	TileRegionCoalescer exactMerges(0);
+	TileRegionCoalescer coalescer;
+	int mergedCaseCount = 0;
+	for (int index = 0; index < COALESCERCASECOUNT; index++)
+	{
+		//Dense sets mostly end up in one range, sparse ones take several merges.
+		int columnCount = 1 + (int)(random() % 16);
+		int rowCount = 1 + (int)(random() % 16);
+		int density = index % 2 ? 3 + (int)(random() % 10) : (int)(random() % 100);
+		vector<TileRange> ranges;
+		for (int column = 0; column < columnCount; column++)
+		{
+			int runStart = -1;
+			for (int row = 0; row <= rowCount; row++)
+			{
+				bool missing = row < rowCount && (int)(random() % 100) < density;
+				if (missing && runStart < 0)
+				{
+					runStart = row;
+				}
+				else if (!missing && runStart >= 0)
+				{
+					ranges.push_back(TileRange{ column, runStart, 1, row - runStart });
+					runStart = -1;
+				}
+			}
+		}
+
+		TileWorkQueue queue(1 + (int)(random() % 32));
+		queue.SetOrder((TileOrder)(random() % 4));
+		TileWorkQueue const* countingQueue = index % 3 ? &queue : nullptr;
+		int left = (int)(random() % 28) - 4;
+		int top = (int)(random() % 28) - 4;
+		TileRange visibleRange{ left, top, 1 + (int)(random() % 14), 1 + (int)(random() % 14) };
+		int sessionCost = (int)(random() % 24);
+
+		vector<TileRange> expected = ranges;
+		exactMerges.Coalesce(expected);
+		size_t exactRangeCount = expected.size();
+		CoalesceReference(expected, sessionCost, countingQueue, visibleRange);
+
+		coalescer.SetSessionCost(sessionCost);
+		coalescer.Coalesce(ranges, countingQueue, visibleRange);
+		if (!SameRanges(ranges, expected))
+		{
+			printf("coalescer: set %d of %zu ranges at session cost %d comes out as %zu ranges, the plain merges give %zu\n",
+				index, exactRangeCount, sessionCost, ranges.size(), expected.size());
+			return false;
+		}
+		mergedCaseCount += expected.size() < exactRangeCount ? 1 : 0;
+	}
+	printf("coalescer: %d random sets of ranges, %d of them merged, all as the plain merges make them\n\n", COALESCERCASECOUNT, mergedCaseCount);
+
+	printf("%-16s", "sessions / cost");
+	for (int sessionCost : CHECKEDSESSIONCOSTS)
+	{
+		printf(" %6d", sessionCost);
+	}
+	printf("\n");
+	bool monotonic = true;
+	for (auto const& trace : traces)
+	{
+		printf("%-16s", trace.first.c_str());
+		bool traceMonotonic = true;
+		uint64_t previousSessions = UINT64_MAX;
+		for (int sessionCost : CHECKEDSESSIONCOSTS)
+		{
+			RecordingRenderer renderer(0.0, options.tileSize, options.bucketTiles);
+			ReplaySessions(trace.second, options, sessionCost, renderer);
+			traceMonotonic = traceMonotonic && renderer.drawSessions <= previousSessions;
+			previousSessions = renderer.drawSessions;
+			printf(" %6llu", (unsigned long long)renderer.drawSessions);
+		}
+		printf("%s\n", traceMonotonic ? "" : " MORE");
+		monotonic = monotonic && traceMonotonic;
+	}
+	return monotonic;
+}
+
+//Tiles on each side of the square --state-index checks the TileStateIndex on, centred on tile 0, 0.
+static const int STATEINDEXSIDE = 1280;
+//Random ranges --state-index sets, and how often it compares every tile of the square.
+static const int STATEINDEXSETCOUNT = 20000;
+static const int STATEINDEXFULLCHECKINTERVAL = 100;
+
+//
+//  FUNCTION: CountReferenceBlocks
+//
+//  PURPOSE: Counts the blocks of the TileStateIndex that hold a tile that is not Empty, from the plain array of states
+//	--state-index keeps next to it.
+//
+static size_t CountReferenceBlocks(vector<TileState> const& states)
+{
+	int blocksPerSide = STATEINDEXSIDE / TileStateIndex::BLOCKSIZE;
+	size_t blockCount = 0;
+	for (int blockRow = 0; blockRow < blocksPerSide; blockRow++)
+	{
+		for (int blockColumn = 0; blockColumn < blocksPerSide; blockColumn++)
+		{
+			bool used = false;
+			for (int row = 0; row < TileStateIndex::BLOCKSIZE && !used; row++)
+			{
+				for (int column = 0; column < TileStateIndex::BLOCKSIZE && !used; column++)
+				{
+					used = states[(size_t)(blockRow * TileStateIndex::BLOCKSIZE + row) * STATEINDEXSIDE +
+						blockColumn * TileStateIndex::BLOCKSIZE + column] != TileState::Empty;
+				}
+			}
+			blockCount += used ? 1 : 0;
+		}
+	}
+	return blockCount;
+}
+
+//
+//  FUNCTION: CompareStates
+//
+//  PURPOSE: Compares every tile of the square with the plain array of states, and the number of blocks the index holds.
+//	Prints the first tile that differs.
+//
+static bool CompareStates(TileStateIndex const& index, vector<TileState> const& states, int setIndex)
+{
+	int origin = STATEINDEXSIDE / 2;
+	for (int row = 0; row < STATEINDEXSIDE; row++)
+	{
+		for (int column = 0; column < STATEINDEXSIDE; column++)
+		{
+			TileState expected = states[(size_t)row * STATEINDEXSIDE + column];
+			if (index.Get(column - origin, row - origin) != expected)
+			{
+				printf("state index: after set %d tile %d, %d is %d instead of %d\n", setIndex, column - origin, row - origin,
+					(int)index.Get(column - origin, row - origin), (int)expected);
+				return false;
+			}
+		}
+	}
+	size_t expectedBlocks = CountReferenceBlocks(states);
+	if (index.GetBlockCount() != expectedBlocks)
+	{
+		printf("state index: after set %d the index holds %zu blocks instead of %zu\n", setIndex, index.GetBlockCount(), expectedBlocks);
+		return false;
+	}
+	return true;
+}
+
+//
+//  FUNCTION: RunStateIndexCheck
+//
+//  PURPOSE: Checks the TileStateIndex against a plain array of the states of a square of tiles across the origin, so
+//	blocks on both sides of 0 are used. Random ranges, from single tiles to ranges across several blocks, are set to
+//	random states in both. After every set All has to agree on the range, and every so often every tile and the block
+//	count are compared. Then the whole square is set back to Empty, which has to leave no blocks, and filled again from
+//	the blocks that freed.
+//
+static bool RunStateIndexCheck()
+{
+	mt19937 random(1);
+	int origin = STATEINDEXSIDE / 2;
+	TileStateIndex index;
+	vector<TileState> states((size_t)STATEINDEXSIDE * STATEINDEXSIDE, TileState::Empty);
+	for (int setIndex = 0; setIndex < STATEINDEXSETCOUNT; setIndex++)
+	{
+		//Mostly small ranges, which keep the blocks mixed, and some large ones that cover whole blocks.
+		int maxSide = setIndex % 8 ? 8 : 3 * TileStateIndex::BLOCKSIZE;
+		int numColumns = 1 + (int)(random() % maxSide);
+		int numRows = 1 + (int)(random() % maxSide);
+		int startColumn = (int)(random() % (STATEINDEXSIDE - numColumns + 1));
+		int startRow = (int)(random() % (STATEINDEXSIDE - numRows + 1));
+		//Empty twice as often, so blocks go back to the free list.
+		int stateIndex = (int)(random() % 5);
+		TileState state = stateIndex < 2 ? TileState::Empty : (TileState)(stateIndex - 1);
+
+		TileRange range{ startColumn - origin, startRow - origin, numColumns, numRows };
+		index.Set(range, state);
+		for (int row = startRow; row < startRow + numRows; row++)
+		{
+			fill_n(states.begin() + (size_t)row * STATEINDEXSIDE + startColumn, numColumns, state);
+		}
+
+		if (!index.All(range, state))
+		{
+			printf("state index: after set %d, range %d, %d %dx%d is not all %d\n", setIndex, range.startColumn, range.startRow,
+				numColumns, numRows, (int)state);
+			return false;
+		}
+		if ((setIndex + 1) % STATEINDEXFULLCHECKINTERVAL == 0 && !CompareStates(index, states, setIndex))
+		{
+			return false;
+		}
+	}
+	size_t mixedBlockCount = index.GetBlockCount();
+
+	TileRange square{ -origin, -origin, STATEINDEXSIDE, STATEINDEXSIDE };
+	index.Set(square, TileState::Empty);
+	fill(states.begin(), states.end(), TileState::Empty);
+	if (!CompareStates(index, states, STATEINDEXSETCOUNT))
+	{
+		return false;
+	}
+	index.Set(square, TileState::Valid);
+	fill(states.begin(), states.end(), TileState::Valid);
+	if (!CompareStates(index, states, STATEINDEXSETCOUNT + 1) || !index.All(square, TileState::Valid))
+	{
+		return false;
+	}
+
+	printf("state index: %d random ranges set on %dx%d tiles, %zu blocks held at the end, every tile as a plain array has it\n",
+		STATEINDEXSETCOUNT, STATEINDEXSIDE, STATEINDEXSIDE, mixedBlockCount);
+	return true;
+}
+
+//
+//  FUNCTION: PrintTelemetry
+//
+//  PURPOSE: Prints what the pipeline telemetry recorded since the last reset: one line per span that was hit, with its
+//	latency in microseconds, one per value histogram, then the counters.
+//
+static void PrintTelemetry()
+{
+	unique_ptr<TileTelemetrySnapshot> snapshot = make_unique<TileTelemetrySnapshot>();
+	TileTelemetry::GetSnapshot(*snapshot);
+
+	printf("    %-24s %10s %10s %10s %10s %10s\n", "span (us)", "count", "mean", "p50", "p99", "max");
+	for (int span = 0; span < (int)TileSpan::Count; span++)
+	{
+		LatencyHistogram const& histogram = snapshot->spans[span];
+		if (histogram.GetCount() != 0)
+		{
+			printf("    %-24s %10llu %10.2f %10.2f %10.2f %10.2f\n",
+				TileTelemetry::GetSpanName((TileSpan)span),
+				(unsigned long long)histogram.GetCount(),
+				histogram.GetMean() / 1000.0,
+				histogram.GetPercentile(0.50) / 1000.0,
+				histogram.GetPercentile(0.99) / 1000.0,
+				histogram.GetMax() / 1000.0);
+		}
+	}
+	for (int value = 0; value < (int)TileValue::Count; value++)
+	{
+		LatencyHistogram const& histogram = snapshot->values[value];
+		if (histogram.GetCount() != 0)
+		{
+			printf("    %-24s %10llu %10.2f %10llu %10llu %10llu\n",
+				TileTelemetry::GetValueName((TileValue)value),
+				(unsigned long long)histogram.GetCount(),
+				histogram.GetMean(),
+				(unsigned long long)histogram.GetPercentile(0.50),
+				(unsigned long long)histogram.GetPercentile(0.99),
+				(unsigned long long)histogram.GetMax());
+		}
+	}
+	printf("   ");
+	for (int counter = 0; counter < (int)TileCounter::Count; counter++)
+	{
+		printf(" %s %llu", TileTelemetry::GetCounterName((TileCounter)counter), (unsigned long long)snapshot->counters[counter]);
+	}
+	printf("\n\n");
+}
+
+//
+//  FUNCTION: ReplayTrace
+//
+//  PURPOSE: Runs one trace with the telemetry cleared beforehand, then prints it and writes the Chrome trace if asked to.
+//	The trace itself is written out first with --save-trace. Both files are rewritten for every trace, so they end up
+//	holding the last one. Rasterized traces are checked against the golden checksums when there are any.
+//
+static bool ReplayTrace(string const& name, vector<InteractionEvent> const& events, BenchmarkOptions const& options, GoldenChecksums& golden)
+{
+	if (!options.saveTracePath.empty() && !InteractionTrace::Save(options.saveTracePath.c_str(), events))
+	{
+		fprintf(stderr, "cannot write '%s'\n", options.saveTracePath.c_str());
+		return false;
+	}
+
+	TileTelemetry::Reset();
+	if (options.raster)
+	{
+		uint64_t checksum = 0;
+		if (!RunRasterScaling(name, events, options, checksum))
+		{
+			fprintf(stderr, "'%s' rasterized with several threads does not match the single thread tiles\n", name.c_str());
+			return false;
+		}
+		if (!options.goldenPath.empty() && !golden.Check(name, checksum))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		RunTrace(name, events, options);
+	}
+
+	if (options.printTelemetry)
+	{
+		PrintTelemetry();
+	}
+	if (!options.chromeTracePath.empty() && !TileTelemetry::WriteChromeTrace(options.chromeTracePath.c_str()))
+	{
+		fprintf(stderr, "cannot write '%s'\n", options.chromeTracePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+static bool ParseTileOrder(string const& name, TileOrder& order)
+{
+	static const pair<char const*, TileOrder> orders[] = {
+		{ "scan", TileOrder::Scan }, { "center", TileOrder::CenterOut }, { "z", TileOrder::ZOrder }, { "hilbert", TileOrder::Hilbert } };
+	for (auto const& entry : orders)
+	{
+		if (name == entry.first)
+		{
+			order = entry.second;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void PrintUsage()
+{
+	printf("usage: TileSchedulerBenchmark [--tile-size N|auto] [--pow2] [--draw-ahead N] [--max-draw-ahead N] [--levels N] [--budget MS] [--tile-cost US] [--cache-mb N] [--trim-margin N] [--trim-deferral N] [--unbucketed] [--session-cost N] [--order scan|center|z|hilbert] [--adaptive N] [--repeat N] [--pace X] [--origin N] [--views N] [--view-offset PX] [--raster] [--no-labels] [--store-mb N] [--disk-cache FILE] [--golden FILE] [--kernels] [--coalescer] [--state-index] [--max-threads N] [--telemetry] [--no-telemetry] [--chrome-trace FILE] [--save-trace FILE] [--scenario NAME]... [--trace FILE]...\n");
+	printf("scenarios: pan diagonal fling jitter zoom resize (all of them run when no scenario or trace is given)\n");
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	vector<string> scenarios;
+	vector<string> traces;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--tile-size" && hasValue)
+		{
+			string value = argv[++i];
+			options.calibrateTileSize = value == "auto";
+			options.tileSize = options.calibrateTileSize ? options.tileSize : atoi(value.c_str());
+		}
+		else if (arg == "--pow2") options.powerOfTwoTiles = true;
+		else if (arg == "--draw-ahead" && hasValue) options.drawAheadTileCount = atoi(argv[++i]);
+		else if (arg == "--max-draw-ahead" && hasValue) options.maxDrawAheadTileCount = atoi(argv[++i]);
+		else if (arg == "--levels" && hasValue) options.levelOfDetailCount = atoi(argv[++i]);
+		else if (arg == "--budget" && hasValue) options.frameBudgetMs = atof(argv[++i]);
+		else if (arg == "--tile-cost" && hasValue) options.tileCostUs = atof(argv[++i]);
+		else if (arg == "--cache-mb" && hasValue) options.cacheMegabytes = atoi(argv[++i]);
+		else if (arg == "--trim-margin" && hasValue) options.trimMarginTileCount = atoi(argv[++i]);
+		else if (arg == "--trim-deferral" && hasValue) options.trimDeferral = max(0, atoi(argv[++i]));
+		else if (arg == "--unbucketed") options.bucketTiles = false;
+		else if (arg == "--session-cost" && hasValue) options.sessionCostTiles = atoi(argv[++i]);
+		else if (arg == "--order" && hasValue && ParseTileOrder(argv[i + 1], options.tileOrder)) i++;
+		else if (arg == "--adaptive" && hasValue) options.adaptiveDrawAheadTileCount = max(0, atoi(argv[++i]));
+		else if (arg == "--repeat" && hasValue) options.repeat = max(1, atoi(argv[++i]));
+		else if (arg == "--pace" && hasValue) options.pace = max(0.0, atof(argv[++i]));
+		else if (arg == "--origin" && hasValue) options.origin = max(0ll, atoll(argv[++i]));
+		else if (arg == "--views" && hasValue) options.viewCount = min(max(1, atoi(argv[++i])), (int)TileScheduler::MAXVIEWPORTCOUNT);
+		else if (arg == "--view-offset" && hasValue) options.viewOffset = max(0, atoi(argv[++i]));
+		else if (arg == "--save-trace" && hasValue) options.saveTracePath = argv[++i];
+		else if (arg == "--raster") options.raster = true;
+		else if (arg == "--no-labels") options.labels = false;
+		else if (arg == "--store-mb" && hasValue) options.storeMegabytes = atoi(argv[++i]);
+		else if (arg == "--disk-cache" && hasValue) options.diskCachePath = argv[++i];
+		else if (arg == "--golden" && hasValue) options.goldenPath = argv[++i];
+		else if (arg == "--kernels") options.kernels = true;
+		else if (arg == "--coalescer") options.checkCoalescer = true;
+		else if (arg == "--state-index") options.checkStateIndex = true;
+		else if (arg == "--max-threads" && hasValue) options.maxThreadCount = min(max(1, atoi(argv[++i])), (int)TileWorkerPool::MAXTHREADCOUNT);
+		else if (arg == "--telemetry") options.printTelemetry = true;
+		else if (arg == "--no-telemetry") options.telemetry = false;
+		else if (arg == "--chrome-trace" && hasValue) options.chromeTracePath = argv[++i];
+		else if (arg == "--scenario" && hasValue) scenarios.push_back(argv[++i]);
+		else if (arg == "--trace" && hasValue) traces.push_back(argv[++i]);
+		else
+		{
+			PrintUsage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	if (options.tileSize <= 0 || options.drawAheadTileCount < 0 || options.maxDrawAheadTileCount < options.drawAheadTileCount ||
+		(!options.telemetry && (options.printTelemetry || !options.chromeTracePath.empty())) ||
+		(!options.goldenPath.empty() && !options.raster))
+	{
+		PrintUsage();
+		return 1;
+	}
+	GoldenChecksums golden;
+	if (!options.goldenPath.empty() && !golden.Load(options.goldenPath))
+	{
+		fprintf(stderr, "cannot read '%s'\n", options.goldenPath.c_str());
+		return 1;
+	}
+	TileTelemetry::SetEnabled(options.telemetry);
+	TileTelemetry::SetTracing(!options.chromeTracePath.empty());
+
+	if (options.kernels)
+	{
+		return RunKernelBenchmark() ? 0 : 1;
+	}
+
+	if (options.checkStateIndex)
+	{
+		return RunStateIndexCheck() ? 0 : 1;
+	}
+
+	if (options.calibrateTileSize)
+	{
+		//The synthetic traces run in a 1280x720 window.
+		RasterCostProbe probe(options.tileCostUs, options.labels);
+		TileSizeCalibrator calibrator;
+		TileSizeCalibration calibration = calibrator.Calibrate(probe, 1280, 720, options.drawAheadTileCount, options.powerOfTwoTiles);
+		options.tileSize = calibration.tileSize;
+		printf("calibrated tile size %d: %.2f us per tile + %.3f ns per pixel, %.1f us to fill a 1280x720 viewport and its draw ahead\n",
+			calibration.tileSize, calibration.tileCostUs, calibration.pixelCostNs, calibration.fillCostUs);
+	}
+
+	if (scenarios.empty() && traces.empty())
+	{
+		scenarios = { "pan", "diagonal", "fling", "jitter", "zoom", "resize" };
+	}
+
+	if (options.checkCoalescer)
+	{
+		vector<pair<string, vector<InteractionEvent>>> checkedTraces;
+		for (auto const& scenario : scenarios)
+		{
+			checkedTraces.emplace_back(scenario, vector<InteractionEvent>());
+			if (!MakeScenario(scenario, checkedTraces.back().second))
+			{
+				fprintf(stderr, "unknown scenario '%s'\n", scenario.c_str());
+				return 1;
+			}
+		}
+		for (auto const& trace : traces)
+		{
+			checkedTraces.emplace_back(trace, vector<InteractionEvent>());
+			if (!InteractionTrace::Load(trace.c_str(), checkedTraces.back().second))
+			{
+				fprintf(stderr, "cannot read trace '%s'\n", trace.c_str());
+				return 1;
+			}
+		}
+		return RunCoalescerCheck(checkedTraces, options) ? 0 : 1;
+	}
+
+	if (options.raster)
+	{
+		printf("tile size %d, draw ahead %d to %d, %d coarse levels, tiles rasterized on the CPU with 1 to %d threads, %d replays per trace, times in milliseconds per replay\n\n",
+			options.tileSize, options.drawAheadTileCount, options.maxDrawAheadTileCount, options.levelOfDetailCount, options.maxThreadCount, options.repeat);
+		if (options.storeMegabytes > 0)
+		{
+			printf("%d MB compressed tile store\n\n", options.storeMegabytes);
+		}
+		if (!options.diskCachePath.empty())
+		{
+			printf("disk tile cache in %s\n\n", options.diskCachePath.c_str());
+		}
+		printf("%-16s %8s %10s %10s %10s %10s %9s %10s %10s %10s %10s %10s %8s %8s %16s\n",
+			"trace", "threads", "tiles", "restored", "disk", "tasks", "steals", "raster", "upload", "compress", "index", "Mpixel/s", "speedup", "ratio", "checksum");
+	}
+	else
+	{
+		printf("tile size %d, draw ahead %d to %d, %d coarse levels, frame budget %.2f ms, tile cost %.1f us, %d MB tile cache with %d tiles trim margin, %d replays per trace, time in microseconds per frame\n\n",
+			options.tileSize, options.drawAheadTileCount, options.maxDrawAheadTileCount, options.levelOfDetailCount, options.frameBudgetMs, options.tileCostUs, options.cacheMegabytes, options.trimMarginTileCount, options.repeat);
+		if (options.viewCount > 1)
+		{
+			printf("%d viewports %d pixels apart\n\n", options.viewCount, options.viewOffset);
+		}
+		if (options.adaptiveDrawAheadTileCount > 0)
+		{
+			printf("draw ahead at rest governed between 0 and %d\n\n", options.adaptiveDrawAheadTileCount);
+		}
+		printf("%-16s %8s %8s %8s %10s %10s %10s %10s %8s %8s %8s %10s %6s %9s %8s %8s %9s %9s %6s %8s %8s %9s %9s %9s %9s\n",
+			"trace", "updates", "draws", "sessions", "fills", "drawn", "trimmed", "redrawn", "late", "coarse", "center", "resident", "hit%", "evictions", "refills", "queue", "overruns", "cancelled", "ahead", "tile us", "allocs", "mean", "p50", "p99", "max");
+	}
+
+	for (auto const& scenario : scenarios)
+	{
+		vector<InteractionEvent> events;
+		if (!MakeScenario(scenario, events))
+		{
+			fprintf(stderr, "unknown scenario '%s'\n", scenario.c_str());
+			return 1;
+		}
+		if (!ReplayTrace(scenario, events, options, golden))
+		{
+			return 1;
+		}
+	}
+
+	for (auto const& trace : traces)
+	{
+		vector<InteractionEvent> events;
+		if (!InteractionTrace::Load(trace.c_str(), events))
+		{
+			fprintf(stderr, "cannot read trace '%s'\n", trace.c_str());
+			return 1;
+		}
+		if (!ReplayTrace(trace, events, options, golden))
+		{
+			return 1;
+		}
+	}
+
+	if (!golden.Save())
+	{
+		fprintf(stderr, "cannot write '%s'\n", options.goldenPath.c_str());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,42 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include <vector>
+
+//
+//  CLASS: DeviceResourceCache
+//
+//  PURPOSE: Solid color brushes shared by every BeginDraw session. Resources created from one device context can be used
+//	by every other context of the same Direct2D device, so each color only needs a brush once per device, instead of
+//	once per session. The cache notices a new device in the context it is handed and starts over, Reset drops everything
+//	when the device is lost. Brushes are looked up by the color they were created with and must not be recolored.
+//
+class DeviceResourceCache
+{
+public:
+	ID2D1SolidColorBrush* GetSolidColorBrush(ID2D1DeviceContext* d2dDeviceContext, D2D1_COLOR_F const& color);
+	void Reset();
+
+private:
+	struct CachedBrush
+	{
+		D2D1_COLOR_F                            color;
+		winrt::com_ptr<ID2D1SolidColorBrush>    brush;
+	};
+
+	//member variables
+	winrt::com_ptr<ID2D1Device>             m_device;//Device the resources below belong to
+	std::vector<CachedBrush>                m_solidColorBrushes;
+};
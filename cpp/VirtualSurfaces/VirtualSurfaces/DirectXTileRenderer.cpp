@@ -13,13 +13,19 @@
 //*********************************************************
 #include "stdafx.h"
 #include "DirectXTileRenderer.h"
+#include "SurfaceFrame.h"
+#include "TileTelemetry.h"
+
+#include <algorithm>
+#include <chrono>
 
 //
 //  FUNCTION: Initialize
 //
 //  PURPOSE: Initializes all the necessary devices and structures needed for a DirectX Surface rendering operation.
+//	The device is created whatever the backend, the surfaces need it to upload the tiles of the software one.
 //
-void DirectXTileRenderer::Initialize(Compositor const& compositor, int tileSize, int surfaceSize) {
+void DirectXTileRenderer::Initialize(Compositor const& compositor, int tileSize, int surfaceSize, int levelOfDetailCount, TileBackend backend) {
 	namespace abi = ABI::Windows::UI::Composition;
 
 	auto factory = CreateFactory();
@@ -29,12 +35,14 @@ void DirectXTileRenderer::Initialize(Compositor const& compositor, int tileSize,
 	m_compositor = compositor;
 	m_tileSize = tileSize;
 	m_surfaceSize = surfaceSize;
+	m_backend = backend;
 	com_ptr<abi::ICompositorInterop> interopCompositor = m_compositor.as<abi::ICompositorInterop>();
 	com_ptr<ID2D1Device> d2device;
 	check_hresult(factory->CreateDevice(dxdevice.get(), d2device.put()));
 	check_hresult(interopCompositor->CreateGraphicsDevice(d2device.get(), reinterpret_cast<abi::ICompositionGraphicsDevice**>(put_abi(m_graphicsDevice))));
 	InitializeTextFormat();
 	m_surfaceBrush = CreateVirtualDrawingSurfaceBrush();
+	CreateLevelOfDetailSurfaces(levelOfDetailCount);
 }
 
 CompositionSurfaceBrush DirectXTileRenderer::getSurfaceBrush()
@@ -42,78 +50,240 @@ CompositionSurfaceBrush DirectXTileRenderer::getSurfaceBrush()
 	return m_surfaceBrush;
 }
 
+CompositionSurfaceBrush DirectXTileRenderer::getLevelOfDetailBrush(int level)
+{
+	return m_levelOfDetailSurfaces[level - 1].surfaceBrush;
+}
+
+int DirectXTileRenderer::getLevelOfDetailCount()
+{
+	return (int)m_levelOfDetailSurfaces.size();
+}
+
+abi::ICompositionDrawingSurfaceInterop* DirectXTileRenderer::GetSurfaceInterop(int level)
+{
+	return level == 0 ? m_surfaceInterop.get() : m_levelOfDetailSurfaces[level - 1].surfaceInterop.get();
+}
+
+CompositionVirtualDrawingSurface DirectXTileRenderer::GetVirtualSurface(int level)
+{
+	return level == 0 ? m_virtualSurface : m_levelOfDetailSurfaces[level - 1].virtualSurface;
+}
+
 //
 //  FUNCTION: DrawTileRange
 //
-//  PURPOSE: This function iterates through a list of Tiles and draws them wihtin a single BeginDraw/EndDraw session for performance reasons. 
-//	OPTIMIZATION: This can fail when the surface to be drawn is really large in one go, expecially when the surface is zoomed in by a larger factor. 
+//  PURPOSE: This function iterates through a range of Tiles and draws them wihtin a single BeginDraw/EndDraw session for performance reasons. 
+//	Ranges larger than the maximum texture size are split by the SurfaceChunker into several sessions, and each session
+//	only draws the tiles that intersect it.
+//	Coarse levels of detail are drawn the same way into their own surface. A tile there has the same size in pixels, it is
+//	the brush that scales it up to cover 2^level tiles of the full resolution surface.
 //
-bool DirectXTileRenderer::DrawTileRange(Rect rect, std::list<Tile> const& tiles)
+bool DirectXTileRenderer::DrawTileRange(TileRange const& tiles, int level)
 {
-	SIZE updateSize = { static_cast<LONG>(rect.Width - 5), static_cast<LONG>(rect.Height - 5) };
-	//making sure the update rect doesnt go past the maximum size of the surface.
-	RECT updateRect = { static_cast<LONG>(rect.X), static_cast<LONG>(rect.Y), static_cast<LONG>(min((rect.X + rect.Width),m_surfaceSize)), static_cast<LONG>(min((rect.Y + rect.Height),m_surfaceSize)) };
+	if (m_backend == TileBackend::Software)
+	{
+		return DrawSoftwareTileRange(tiles, level);
+	}
 
-	//Cannot update a surface larger than the max texture size of the hardware. 2048X2048 is the lowest max texture size for relevant hardware.
-	int MAXTEXTURESIZE = D3D_FL9_1_REQ_TEXTURE2D_U_OR_V_DIMENSION;
-	//3 is the buffer here.
-	SIZE constrainedUpdateSize = { min(updateSize.cx, MAXTEXTURESIZE-3), min(updateSize.cy, MAXTEXTURESIZE-3) };
+	auto surfaceInterop = GetSurfaceInterop(level);
+	SurfaceChunker::Split(tiles, m_tileSize, m_surfaceSize >> level, m_chunks);
 
 	float savedColorCounter = m_colorCounter;
-	//Breaking the BeginDraw/EndDraw calls to update rects that dont exceed the max texture size.
-	for (LONG y = updateRect.top; y < updateRect.bottom; y += constrainedUpdateSize.cy)
+	for (SurfaceChunk const& chunk : m_chunks)
 	{
-		for (LONG x = updateRect.left; x < updateRect.right; x += constrainedUpdateSize.cx)
+		LONG x = chunk.left;
+		LONG y = chunk.top;
+
+		POINT offset{};
+		RECT constrainedUpdateRect = RECT{ x,  y,  chunk.right, chunk.bottom };
+		com_ptr<ID2D1DeviceContext> d2dDeviceContext;
+
+		// Begin our update of the surface pixels. Passing nullptr to this call will update the entire surface. We only update the rect area that needs to be rendered.
+		HRESULT beginDrawResult;
 		{
-			m_colorCounter = savedColorCounter;
+			TileSpanScope span(TileSpan::BeginDraw);
+			beginDrawResult = surfaceInterop->BeginDraw(&constrainedUpdateRect, __uuidof(ID2D1DeviceContext), (void **)d2dDeviceContext.put(), &offset);
+		}
+		if (!CheckForDeviceRemoved(beginDrawResult))
+		{
+			return false;
+		}
 
-			POINT offset{};
-			RECT constrainedUpdateRect = RECT{ x,  y,  min(x + constrainedUpdateSize.cx, updateRect.right), min(y + constrainedUpdateSize.cy, updateRect.bottom) };
-			com_ptr<ID2D1DeviceContext> d2dDeviceContext;
-			com_ptr<ID2D1SolidColorBrush> textBrush;
-			com_ptr<ID2D1SolidColorBrush> tileBrush;
+		d2dDeviceContext->Clear(D2D1::ColorF(D2D1::ColorF::Red, 0.f));
+
+		//The brush for the text, created once for the device. Half alpha to make it more visually pleasing as it blends with the background color.
+		ID2D1SolidColorBrush* textBrush = m_deviceResources.GetSolidColorBrush(d2dDeviceContext.get(), D2D1::ColorF(D2D1::ColorF::DimGray, 0.5f));
+
+		//Get the offset difference that can be applied to every tile before drawing.
+		POINT differenceOffset{ (LONG)(offset.x - x), (LONG)(offset.y - y) };
+
+		//Iterate through the tiles of this chunk and do DrawRectangle and DrawText calls on those. The range computes each
+		//tile on the fly, so there is no per tile allocation.
+		for (TileCoordinate coordinate : chunk.tiles) {
+			//The color comes from the position of the tile in the whole range, so a tile split over two sessions looks the
+			//same on both sides.
+			int tileIndex = (coordinate.column - tiles.startColumn) * tiles.numRows + (coordinate.row - tiles.startRow);
+			m_colorCounter = GetColorCounter(savedColorCounter, tileIndex);
+			//Coarse tiles are labelled with the first full resolution tile they cover.
+			Tile tile(coordinate.row, coordinate.column, m_tileSize);
+			tile.row <<= level;
+			tile.column <<= level;
+			DrawTile(d2dDeviceContext.get(), textBrush, tile, differenceOffset);
+		}
+		surfaceInterop->EndDraw();
+	}
+	m_colorCounter = GetColorCounter(savedColorCounter, tiles.TileCount());
+	
+	return true;
+}
 
-			// Begin our update of the surface pixels. Passing nullptr to this call will update the entire surface. We only update the rect area that needs to be rendered.
-			if (!CheckForDeviceRemoved(m_surfaceInterop->BeginDraw(&constrainedUpdateRect, __uuidof(ID2D1DeviceContext), (void **)d2dDeviceContext.put(), &offset)))
-			{
-				return false;
-			}
+//
+//  FUNCTION: DrawSoftwareTileRange
+//
+//  PURPOSE: DrawTileRange of the software backend. The whole range is drawn into a staging image with a
+//	SoftwareTileCanvas, tile by tile in the same order and with the same colors as DrawTileRange, then uploaded by
+//	UploadTileRange. Labels come from the built in font of a TileGlyphAtlas instead of DirectWrite.
+//
+bool DirectXTileRenderer::DrawSoftwareTileRange(TileRange const& tiles, int level)
+{
+	if (m_labelAtlas.GetTileSize() != m_tileSize)
+	{
+		m_labelAtlas.Build(m_tileSize);
+	}
+	int width = tiles.numColumns * m_tileSize;
+	int height = tiles.numRows * m_tileSize;
+	m_softwarePixels.resize((size_t)width * height);
+	SoftwareTileCanvas canvas(m_softwarePixels.data(), width, 0, 0, width, height);
+	canvas.Clear(0);
+
+	for (TileCoordinate coordinate : tiles) {
+		//The staging image starts at the top left tile of the range, the labels are those of the surface.
+		Tile tile(coordinate.row - tiles.startRow, coordinate.column - tiles.startColumn, m_tileSize);
+		tile.row = coordinate.row << level;
+		tile.column = coordinate.column << level;
+		DrawSoftwareTile(canvas, tile);
+	}
 
-			d2dDeviceContext->Clear(D2D1::ColorF(D2D1::ColorF::Red, 0.f));
+	return UploadTileRange(tiles, level, m_softwarePixels.data(), width);
+}
 
-			// Create a solid color brush for the text. Half alpha to make it more visually pleasing as it blends with the background color.
-			check_hresult(d2dDeviceContext->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::DimGray, 0.5f), textBrush.put()));
+//
+//  FUNCTION: UploadTileRange
+//
+//  PURPOSE: Copies a range of tiles rasterized on the CPU to the surface of the given level. The range is split into the
+//	same sessions as DrawTileRange, each one copies its part of the staging image in a single bitmap, nothing is drawn
+//	here. Called by the ParallelTileRenderer once all the tiles of the range are done.
+//
+bool DirectXTileRenderer::UploadTileRange(TileRange const& tiles, int level, uint32_t const* pixels, ptrdiff_t stride)
+{
+	auto surfaceInterop = GetSurfaceInterop(level);
+	SurfaceChunker::Split(tiles, m_tileSize, m_surfaceSize >> level, m_chunks);
 
-			//Create a solid color brush for the tiles and which will be set to a different color before rendering.
-			check_hresult(d2dDeviceContext->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Green, 1.0f), tileBrush.put()));
+	D2D1_BITMAP_PROPERTIES1 bitmapProperties = D2D1::BitmapProperties1(
+		D2D1_BITMAP_OPTIONS_NONE,
+		D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
 
-			//Get the offset difference that can be applied to every tile before drawing.
-			POINT differenceOffset{ (LONG)(offset.x - x), (LONG)(offset.y - y) };
+	for (SurfaceChunk const& chunk : m_chunks)
+	{
+		POINT offset{};
+		RECT constrainedUpdateRect = RECT{ chunk.left, chunk.top, chunk.right, chunk.bottom };
+		com_ptr<ID2D1DeviceContext> d2dDeviceContext;
+		com_ptr<ID2D1Bitmap1> bitmap;
 
-			//Iterate through the tiles and do DrawRectangle and DrawText calls on those.
-			for (Tile tile : tiles) {
-				DrawTile(d2dDeviceContext.get(), textBrush.get(), tileBrush.get(), tile, differenceOffset);
-			}
-			m_surfaceInterop->EndDraw();
+		HRESULT beginDrawResult;
+		{
+			TileSpanScope span(TileSpan::BeginDraw);
+			beginDrawResult = surfaceInterop->BeginDraw(&constrainedUpdateRect, __uuidof(ID2D1DeviceContext), (void **)d2dDeviceContext.put(), &offset);
+		}
+		if (!CheckForDeviceRemoved(beginDrawResult))
+		{
+			return false;
 		}
+
+		//The part of the staging image under this chunk. The staging image starts at the top left tile of the range.
+		uint32_t const* chunkPixels = pixels + (ptrdiff_t)(chunk.top - tiles.startRow * m_tileSize) * stride + (chunk.left - tiles.startColumn * m_tileSize);
+		UINT32 width = chunk.right - chunk.left;
+		UINT32 height = chunk.bottom - chunk.top;
+		check_hresult(d2dDeviceContext->CreateBitmap(D2D1::SizeU(width, height), chunkPixels, (UINT32)(stride * sizeof(uint32_t)), bitmapProperties, bitmap.put()));
+
+		//The tiles are premultiplied already and cover the whole chunk, so they replace what was there instead of blending.
+		d2dDeviceContext->SetPrimitiveBlend(D2D1_PRIMITIVE_BLEND_COPY);
+		D2D1_RECT_F destination{ (float)offset.x, (float)offset.y, (float)(offset.x + width), (float)(offset.y + height) };
+		d2dDeviceContext->DrawBitmap(bitmap.get(), destination, 1.0f, D2D1_INTERPOLATION_MODE_NEAREST_NEIGHBOR);
+		surfaceInterop->EndDraw();
 	}
-	
+
 	return true;
 }
 
+//
+//  FUNCTION: SetTileSize
+//
+//  PURPOSE: Switches to tiles of another size. The labels are sized to fit the tiles.
+//
+void DirectXTileRenderer::SetTileSize(int tileSize)
+{
+	m_tileSize = tileSize;
+	InitializeTextFormat();
+}
+
+//
+//  FUNCTION: MeasureTilesUs
+//
+//  PURPOSE: ITileCostProbe implementation for the TileSizeCalibrator. Draws a row of tiles of the given size exactly like
+//	DrawTileRange, but into a scratch surface that is dropped afterwards, so the tiles already drawn in the surface stay
+//	and the colors of the next tiles do not move on. Only the time spent on this thread is measured, which is the time
+//	the UI thread would spend drawing them.
+//
+double DirectXTileRenderer::MeasureTilesUs(int tileSize, int tileCount)
+{
+	com_ptr<abi::ICompositionDrawingSurfaceInterop> savedSurfaceInterop = m_surfaceInterop;
+	CompositionVirtualDrawingSurface scratchSurface = CreateVirtualDrawingSurface(SizeInt32{ m_surfaceSize, m_surfaceSize });
+	m_surfaceInterop = scratchSurface.as<abi::ICompositionDrawingSurfaceInterop>();
+	int savedTileSize = m_tileSize;
+	float savedColorCounter = m_colorCounter;
+	m_tileSize = tileSize;
+
+	auto start = std::chrono::steady_clock::now();
+	bool drawn = DrawTileRange(TileRange{ 0, 0, tileCount, 1 }, 0);
+	auto end = std::chrono::steady_clock::now();
+
+	m_tileSize = savedTileSize;
+	m_colorCounter = savedColorCounter;
+	m_surfaceInterop = savedSurfaceInterop;
+	return drawn ? std::chrono::duration<double, std::micro>(end - start).count() : -1.0;
+}
+
+//
+//  FUNCTION: GetColorCounter
+//
+//  PURPOSE: The color counter DrawTile starts from for the tile at tileIndex in a range, as if all the tiles before it
+//	had been drawn in order. DrawTile steps the counter by 16 modulo 192 once it is in its [8, 200) range.
+//
+float DirectXTileRenderer::GetColorCounter(float startColorCounter, int tileIndex)
+{
+	if (tileIndex == 0)
+	{
+		return startColorCounter;
+	}
+	int first = (int)(startColorCounter + 8) % 192 + 8;
+	return (float)((first - 8 + 16 * (tileIndex - 1)) % 192 + 8);
+}
+
 //
 //  FUNCTION:DrawTile
 //
-//  PURPOSE: Core D2D/DWrite calls for drawing a rectangle and text on top of it.
-//  OPTIMIZATION: Pre-create the color brushes in the device instead of on every DrawTile call.
+//  PURPOSE: Core D2D/DWrite calls for drawing a rectangle and text on top of it. The tile brushes come from the device
+//	resource cache, which only creates one the first time a shade is drawn.
 //
-void DirectXTileRenderer::DrawTile(ID2D1DeviceContext* d2dDeviceContext, ID2D1SolidColorBrush* textBrush, ID2D1SolidColorBrush* tileBrush, Tile tile, POINT differenceOffset )
+void DirectXTileRenderer::DrawTile(ID2D1DeviceContext* d2dDeviceContext, ID2D1SolidColorBrush* textBrush, Tile const& tile, POINT differenceOffset )
 {
 	//Generating colors to distinguish each tile. Some hardcoded math to generate different shades of green in an incremental fashion. 
 	//This makes the sample look better visually, no other functional reason for these particular numbers and the math itself.
 	m_colorCounter = (int)(m_colorCounter + 8) % 192 + 8.0f;
 	D2D1::ColorF randomColor(m_colorCounter / 256, 1.0f, 0.0f, 0.5f);
-	tileBrush->SetColor(randomColor);
+	ID2D1SolidColorBrush* tileBrush = m_deviceResources.GetSolidColorBrush(d2dDeviceContext, randomColor);
 
 	float offsetUpdatedX = tile.rect.X + differenceOffset.x;
 	float offsetUpdatedY = tile.rect.Y + differenceOffset.y;
@@ -124,6 +294,26 @@ void DirectXTileRenderer::DrawTile(ID2D1DeviceContext* d2dDeviceContext, ID2D1So
 	DrawTextInTile(tile.row, tile.column, tileRectangle, d2dDeviceContext, textBrush);
 }
 
+//
+//  FUNCTION: DrawSoftwareTile
+//
+//  PURPOSE: DrawTile of the software backend, the same rectangle and label drawn with a SoftwareTileCanvas.
+//
+void DirectXTileRenderer::DrawSoftwareTile(SoftwareTileCanvas& canvas, Tile const& tile)
+{
+	m_colorCounter = (int)(m_colorCounter + 8) % 192 + 8.0f;
+	D2D1::ColorF randomColor(m_colorCounter / 256, 1.0f, 0.0f, 0.5f);
+	D2D1::ColorF textColor(D2D1::ColorF::DimGray, 0.5f);
+
+	int borderMargin = 5;
+	CanvasRect tileRectangle{ tile.rect.X, tile.rect.Y, tile.rect.X + tile.rect.Width - borderMargin, tile.rect.Y + tile.rect.Height - borderMargin };
+	canvas.FillRectangle(tileRectangle, SoftwareTileCanvas::GetPremultipliedColor(randomColor.r, randomColor.g, randomColor.b, randomColor.a));
+
+	uint8_t glyphs[TileLabel::MAXGLYPHCOUNT];
+	int glyphCount = TileLabel::GetGlyphs(tile.row, tile.column, glyphs);
+	canvas.DrawLabel(m_labelAtlas, glyphs, glyphCount, tileRectangle, SoftwareTileCanvas::GetPremultipliedColor(textColor.r, textColor.g, textColor.b, textColor.a));
+}
+
 //
 //  FUNCTION: CheckForDeviceRemoved
 //
@@ -140,7 +330,9 @@ bool DirectXTileRenderer::CheckForDeviceRemoved(HRESULT hr)
 	else if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
 	{
 		// We can't draw at this time, but this failure is recoverable. Just skip drawing for
-		// now. We will be asked to draw again once the Direct3D device is recreated
+		// now. We will be asked to draw again once the Direct3D device is recreated, and the
+		// brushes with it.
+		m_deviceResources.Reset();
 		return false;
 	}
 	// Any other error is unexpected and, therefore, fatal.
@@ -151,40 +343,42 @@ bool DirectXTileRenderer::CheckForDeviceRemoved(HRESULT hr)
 //
 //  FUNCTION:Trim
 //
-//  PURPOSE: Helper function that calls the trim on the virtualSurface
+//  PURPOSE: Helper function that calls the trim on the virtualSurface of the given level of detail. Everything outside of
+//	keepRects is discarded in a single call.
 //
-void DirectXTileRenderer::Trim(Rect trimRect)
+void DirectXTileRenderer::Trim(std::vector<RectInt32> const& keepRects, int level)
 {
-	RectInt32 trimRects[1];
-	trimRects[0] = RectInt32{ (int)trimRect.X, (int)trimRect.Y, (int)trimRect.Width, (int)trimRect.Height };
-	m_virtualSurface.Trim(trimRects);
+	GetVirtualSurface(level).Trim(keepRects);
 }
 
 
 //
 //  FUNCTION: DrawText
 //
-//  PURPOSE: DirectWrite calls to draw the text "x,y" in the tile
+//  PURPOSE: Draws the text "x,y" centered in the tile, as one glyph run put together from the cached label glyphs.
 //
 void DirectXTileRenderer::DrawTextInTile(int tileRow, int tileColumn, D2D1_RECT_F rect, ID2D1DeviceContext*  d2dDeviceContext,
 	ID2D1SolidColorBrush* textBrush)
 {
-	std::wstring text{ std::to_wstring(tileRow) + L"," + std::to_wstring(tileColumn)  };
-	//Drawing the text in the second third of the rectangle, so it is centered. The centerRect is the new rectangle that is 1/3rd of the height and placed at the center of the Tile.
-	d2dDeviceContext->DrawText(text.c_str(), (uint32_t)text.size(), m_textFormat.get(), rect, textBrush);
+	m_glyphRunCache.Draw(tileRow, tileColumn, rect, d2dDeviceContext, textBrush);
 }
 
 //
 //  FUNCTION:InitializeTextFormat
 //
-//  PURPOSE: Creates the text format
+//  PURPOSE: Creates the text format and looks up the label glyphs in it. The labels are 60 points on 250 pixel tiles,
+//	and scale down with smaller tiles.
 //
 void DirectXTileRenderer::InitializeTextFormat()
 {
-	check_hresult(::DWriteCreateFactory(
-		DWRITE_FACTORY_TYPE_SHARED,
-		__uuidof(m_dWriteFactory),
-		reinterpret_cast<::IUnknown**>(m_dWriteFactory.put())));
+	if (!m_dWriteFactory)
+	{
+		check_hresult(::DWriteCreateFactory(
+			DWRITE_FACTORY_TYPE_SHARED,
+			__uuidof(m_dWriteFactory),
+			reinterpret_cast<::IUnknown**>(m_dWriteFactory.put())));
+	}
+	m_textFormat = nullptr;
 
 	check_hresult(m_dWriteFactory->CreateTextFormat(
 		L"Segoe UI",
@@ -192,11 +386,12 @@ void DirectXTileRenderer::InitializeTextFormat()
 		DWRITE_FONT_WEIGHT_BOLD,
 		DWRITE_FONT_STYLE_NORMAL,
 		DWRITE_FONT_STRETCH_NORMAL,
-		60.f,
+		std::min(60.f, m_tileSize * 0.24f),
 		L"en-US",
 		m_textFormat.put()));
 	m_textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
 	m_textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
+	m_glyphRunCache.Initialize(m_textFormat.get());
 }
 
 //
@@ -257,16 +452,14 @@ com_ptr<ID3D11Device> DirectXTileRenderer::CreateDevice()
 //
 //  PURPOSE: Creates a VirtualDrawingSurface into which the D2D contents will be drawn.
 //
-CompositionDrawingSurface DirectXTileRenderer::CreateVirtualDrawingSurface(SizeInt32 size)
+CompositionVirtualDrawingSurface DirectXTileRenderer::CreateVirtualDrawingSurface(SizeInt32 size)
 {
 	auto graphicsDevice2 = m_graphicsDevice.as<ICompositionGraphicsDevice2>();
 
-	m_virtualSurface = graphicsDevice2.CreateVirtualDrawingSurface(
+	return graphicsDevice2.CreateVirtualDrawingSurface(
 		size,
 		DirectXPixelFormat::B8G8R8A8UIntNormalized,
 		DirectXAlphaMode::Premultiplied);
-
-	return m_virtualSurface;
 }
 
 //
@@ -281,7 +474,8 @@ CompositionSurfaceBrush DirectXTileRenderer::CreateVirtualDrawingSurfaceBrush()
 	size.Width = m_surfaceSize;
 	size.Height = m_surfaceSize;
 
-	m_surfaceInterop = CreateVirtualDrawingSurface(size).as<abi::ICompositionDrawingSurfaceInterop>();
+	m_virtualSurface = CreateVirtualDrawingSurface(size);
+	m_surfaceInterop = m_virtualSurface.as<abi::ICompositionDrawingSurfaceInterop>();
 
 	ICompositionSurface surface = m_surfaceInterop.as<ICompositionSurface>();
 
@@ -295,6 +489,33 @@ CompositionSurfaceBrush DirectXTileRenderer::CreateVirtualDrawingSurfaceBrush()
 	return surfaceBrush;
 }
 
+//
+//  FUNCTION: CreateLevelOfDetailSurfaces
+//
+//  PURPOSE: Creates the surfaces of the coarser levels of detail used while zooming. Level n is 2^n times smaller than the
+//	full resolution surface in each direction, its brush scales it back up to the same size.
+//
+void DirectXTileRenderer::CreateLevelOfDetailSurfaces(int levelOfDetailCount)
+{
+	m_levelOfDetailSurfaces.resize(levelOfDetailCount);
+	for (int level = 1; level <= levelOfDetailCount; level++)
+	{
+		LevelOfDetailSurface& levelSurface = m_levelOfDetailSurfaces[level - 1];
+		SizeInt32 size;
+		size.Width = m_surfaceSize >> level;
+		size.Height = m_surfaceSize >> level;
+
+		levelSurface.virtualSurface = CreateVirtualDrawingSurface(size);
+		levelSurface.surfaceInterop = levelSurface.virtualSurface.as<abi::ICompositionDrawingSurfaceInterop>();
+
+		levelSurface.surfaceBrush = m_compositor.CreateSurfaceBrush(levelSurface.virtualSurface);
+		levelSurface.surfaceBrush.Stretch(CompositionStretch::None);
+		levelSurface.surfaceBrush.HorizontalAlignmentRatio(0);
+		levelSurface.surfaceBrush.VerticalAlignmentRatio(0);
+		levelSurface.surfaceBrush.TransformMatrix(make_float3x2_scale((float)(1 << level)));
+	}
+}
+
 //
 //  FUNCTION: Constructor for Tile Struct
 //
@@ -302,9 +523,9 @@ CompositionSurfaceBrush DirectXTileRenderer::CreateVirtualDrawingSurfaceBrush()
 //
 Tile::Tile(int lrow, int lcolumn, int tileSize)
 {
-	int x = lcolumn * tileSize;
-	int y = lrow * tileSize;
+	int64_t x = SurfaceFrame::ToPixel(lcolumn, tileSize);
+	int64_t y = SurfaceFrame::ToPixel(lrow, tileSize);
 	row = lrow;
 	column = lcolumn;
-	rect = Rect((float)x, (float)y, tileSize, tileSize);
+	rect = Rect((float)x, (float)y, (float)tileSize, (float)tileSize);
 }
\ No newline at end of file
@@ -13,6 +13,14 @@
 //*********************************************************
 #pragma once
 
+#include "DeviceResourceCache.h"
+#include "GlyphRunCache.h"
+#include "ITileUploader.h"
+#include "SoftwareTileCanvas.h"
+#include "TileSizeCalibrator.h"
+#include "SurfaceChunker.h"
+#include "TileRange.h"
+
 using namespace winrt;
 using namespace Windows::System;
 using namespace Windows::UI;
@@ -34,37 +42,71 @@ struct Tile
 	int column;
 };
 
-class DirectXTileRenderer
+//A coarser level of detail of the content, in a virtual surface of its own that is 2^level times smaller.
+struct LevelOfDetailSurface
+{
+	CompositionVirtualDrawingSurface        virtualSurface = nullptr;
+	CompositionSurfaceBrush                 surfaceBrush = nullptr;
+	com_ptr<ABI::Windows::UI::Composition::ICompositionDrawingSurfaceInterop> surfaceInterop;
+};
+
+//How DrawTileRange draws the tiles. Software draws them on the CPU with a SoftwareTileCanvas, the same calls DrawTile
+//makes to Direct2D, and only uploads them to the surface, so they come out bit for bit the same on every machine.
+enum class TileBackend
+{
+	Direct2D,
+	Software
+};
+
+class DirectXTileRenderer : public ITileUploader, public ITileCostProbe
 {
 public:
-	void Initialize(Compositor const& compositor, int tileSize, int surfaceSize);
-	void Trim(Rect trimRect);
+	void Initialize(Compositor const& compositor, int tileSize, int surfaceSize, int levelOfDetailCount, TileBackend backend = TileBackend::Direct2D);
+	void Trim(std::vector<RectInt32> const& keepRects, int level);
+	void SetTileSize(int tileSize);
+	double MeasureTilesUs(int tileSize, int tileCount) override;
 	CompositionSurfaceBrush getSurfaceBrush();
-	bool DrawTileRange(Rect rect, std::list<Tile> const& tiles);
+	CompositionSurfaceBrush getLevelOfDetailBrush(int level);
+	int getLevelOfDetailCount();
+	bool DrawTileRange(TileRange const& tiles, int level);
+	bool UploadTileRange(TileRange const& tiles, int level, uint32_t const* pixels, ptrdiff_t stride) override;
 
 private:
-	void DrawTile(ID2D1DeviceContext* d2dDeviceContext, ID2D1SolidColorBrush* textBrush, ID2D1SolidColorBrush* tileBrush, Tile tile, POINT differenceOffset);
+	void DrawTile(ID2D1DeviceContext* d2dDeviceContext, ID2D1SolidColorBrush* textBrush, Tile const& tile, POINT differenceOffset);
 	void DrawTextInTile(int tileRow, int tileColumn, D2D1_RECT_F rect, ID2D1DeviceContext*  d2dDeviceContext, ID2D1SolidColorBrush* textBrush);
+	bool DrawSoftwareTileRange(TileRange const& tiles, int level);
+	void DrawSoftwareTile(SoftwareTileCanvas& canvas, Tile const& tile);
 	void InitializeTextFormat();
 	com_ptr<ID2D1Factory1> CreateFactory();
 	HRESULT CreateDevice(D3D_DRIVER_TYPE const type, com_ptr<ID3D11Device>& device);
 	com_ptr<ID3D11Device> CreateDevice();
 	CompositionSurfaceBrush CreateVirtualDrawingSurfaceBrush();
-	CompositionDrawingSurface CreateVirtualDrawingSurface(SizeInt32 size);
+	CompositionVirtualDrawingSurface CreateVirtualDrawingSurface(SizeInt32 size);
+	void CreateLevelOfDetailSurfaces(int levelOfDetailCount);
+	ABI::Windows::UI::Composition::ICompositionDrawingSurfaceInterop* GetSurfaceInterop(int level);
+	CompositionVirtualDrawingSurface GetVirtualSurface(int level);
 	bool CheckForDeviceRemoved(HRESULT hr);
+	static float GetColorCounter(float startColorCounter, int tileIndex);
 
 	//member variables
 	com_ptr<IDWriteFactory>                 m_dWriteFactory;
 	com_ptr<IDWriteTextFormat>              m_textFormat;
+	GlyphRunCache                           m_glyphRunCache;//Label glyphs of m_textFormat
+	DeviceResourceCache                     m_deviceResources;//Brushes kept across BeginDraw sessions
 	com_ptr<ICompositionGraphicsDevice>     m_graphicsDevice ;
 	com_ptr<ICompositionGraphicsDevice2>    m_graphicsDevice2 ;
 	CompositionVirtualDrawingSurface        m_virtualSurface = nullptr;
 	CompositionSurfaceBrush                 m_surfaceBrush = nullptr;
 	Compositor                              m_compositor = nullptr;
 	float                                   m_colorCounter = 0.0;
+	TileBackend                             m_backend = TileBackend::Direct2D;
+	TileGlyphAtlas                          m_labelAtlas;//Label glyphs of the software backend
+	std::vector<uint32_t>                   m_softwarePixels;//Staging image of the software backend
 	int                                     m_tileSize = 0;
 	int                                     m_surfaceSize = 0;
 	com_ptr<ABI::Windows::UI::Composition::ICompositionDrawingSurfaceInterop> m_surfaceInterop ;
+	std::vector<LevelOfDetailSurface>       m_levelOfDetailSurfaces;//Level n is at index n - 1, level 0 is the surface above
+	std::vector<SurfaceChunk>               m_chunks;//Scratch space for DrawTileRange
 
 };
 
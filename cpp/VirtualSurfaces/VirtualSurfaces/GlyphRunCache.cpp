@@ -0,0 +1,93 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "GlyphRunCache.h"
+
+using namespace winrt;
+
+//
+//  FUNCTION: Initialize
+//
+//  PURPOSE: Finds the font face the text format resolves to and looks up the label glyphs in it.
+//
+void GlyphRunCache::Initialize(IDWriteTextFormat* textFormat)
+{
+	com_ptr<IDWriteFontCollection> fontCollection;
+	check_hresult(textFormat->GetFontCollection(fontCollection.put()));
+
+	WCHAR familyName[LF_FACESIZE];
+	check_hresult(textFormat->GetFontFamilyName(familyName, LF_FACESIZE));
+	UINT32 familyIndex = 0;
+	BOOL exists = FALSE;
+	check_hresult(fontCollection->FindFamilyName(familyName, &familyIndex, &exists));
+	check_bool(exists);
+
+	com_ptr<IDWriteFontFamily> fontFamily;
+	check_hresult(fontCollection->GetFontFamily(familyIndex, fontFamily.put()));
+	com_ptr<IDWriteFont> font;
+	check_hresult(fontFamily->GetFirstMatchingFont(textFormat->GetFontWeight(), textFormat->GetFontStretch(), textFormat->GetFontStyle(), font.put()));
+	m_fontFace = nullptr;
+	check_hresult(font->CreateFontFace(m_fontFace.put()));
+	m_fontSize = textFormat->GetFontSize();
+
+	UINT32 codePoints[TileLabel::GLYPHCOUNT];
+	for (int glyph = 0; glyph < TileLabel::GLYPHCOUNT; glyph++)
+	{
+		codePoints[glyph] = TileLabel::GetCharacter(glyph);
+	}
+	check_hresult(m_fontFace->GetGlyphIndices(codePoints, TileLabel::GLYPHCOUNT, m_glyphIndices));
+
+	DWRITE_FONT_METRICS fontMetrics;
+	m_fontFace->GetMetrics(&fontMetrics);
+	DWRITE_GLYPH_METRICS glyphMetrics[TileLabel::GLYPHCOUNT];
+	check_hresult(m_fontFace->GetDesignGlyphMetrics(m_glyphIndices, TileLabel::GLYPHCOUNT, glyphMetrics, FALSE));
+	float designScale = m_fontSize / fontMetrics.designUnitsPerEm;
+	for (int glyph = 0; glyph < TileLabel::GLYPHCOUNT; glyph++)
+	{
+		m_glyphAdvances[glyph] = glyphMetrics[glyph].advanceWidth * designScale;
+	}
+	m_capHeight = fontMetrics.capHeight * designScale;
+}
+
+//
+//  FUNCTION: Draw
+//
+//  PURPOSE: Draws the "row,column" label of a tile centered in rect, like the centered text format would.
+//
+void GlyphRunCache::Draw(int row, int column, D2D1_RECT_F rect, ID2D1DeviceContext* d2dDeviceContext, ID2D1Brush* brush) const
+{
+	uint8_t glyphs[TileLabel::MAXGLYPHCOUNT];
+	int glyphCount = TileLabel::GetGlyphs(row, column, glyphs);
+
+	UINT16 glyphIndices[TileLabel::MAXGLYPHCOUNT];
+	float glyphAdvances[TileLabel::MAXGLYPHCOUNT];
+	float width = 0.0f;
+	for (int i = 0; i < glyphCount; i++)
+	{
+		glyphIndices[i] = m_glyphIndices[glyphs[i]];
+		glyphAdvances[i] = m_glyphAdvances[glyphs[i]];
+		width += glyphAdvances[i];
+	}
+
+	DWRITE_GLYPH_RUN glyphRun{};
+	glyphRun.fontFace = m_fontFace.get();
+	glyphRun.fontEmSize = m_fontSize;
+	glyphRun.glyphCount = glyphCount;
+	glyphRun.glyphIndices = glyphIndices;
+	glyphRun.glyphAdvances = glyphAdvances;
+
+	//The labels are all digits, so centering the cap height centers the label.
+	D2D1_POINT_2F baselineOrigin{ (rect.left + rect.right - width) / 2, (rect.top + rect.bottom + m_capHeight) / 2 };
+	d2dDeviceContext->DrawGlyphRun(baselineOrigin, &glyphRun, brush);
+}
@@ -0,0 +1,38 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THE SOFTWARE IS PROVIDED AS IS, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, 
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH 
+// THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//*********************************************************
+#pragma once
+
+#include "TileLabel.h"
+
+//
+//  CLASS: GlyphRunCache
+//
+//  PURPOSE: The glyph indices and advances of the TileLabel glyphs in the label font, looked up once per text format.
+//	Draw puts a tile's label together from them and hands it to Direct2D as a single glyph run, so drawing a label does
+//	not format a string or lay out text the way DrawText does on every call.
+//
+class GlyphRunCache
+{
+public:
+	void Initialize(IDWriteTextFormat* textFormat);
+	void Draw(int row, int column, D2D1_RECT_F rect, ID2D1DeviceContext* d2dDeviceContext, ID2D1Brush* brush) const;
+
+private:
+	//member variables
+	winrt::com_ptr<IDWriteFontFace>     m_fontFace;
+	float                               m_fontSize = 0.0f;
+	float                               m_capHeight = 0.0f;//In pixels, used to center the digits vertically
+	UINT16                              m_glyphIndices[TileLabel::GLYPHCOUNT] = {};
+	float                               m_glyphAdvances[TileLabel::GLYPHCOUNT] = {};
+};
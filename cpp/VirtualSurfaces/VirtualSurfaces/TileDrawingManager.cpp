@@ -14,10 +14,27 @@
 #include "stdafx.h"
 #include "TileDrawingManager.h"
 
+#include <chrono>
+
 
 TileDrawingManager::TileDrawingManager()
 {	
-
+	m_scheduler.SetRenderer(this);
+	m_scheduler.SetFrameBudget(FRAMEBUDGET);
+	m_scheduler.SetCacheBudget((size_t)CACHEBUDGETMB * 1024 * 1024, TRIMMARGINTILECOUNT);
+	m_scheduler.SetTrimDeferral(TRIMDEFERRAL);
+	m_scheduler.SetTileOrder(TILEORDER);
+	m_scheduler.SetAdaptiveDrawAhead(MINDRAWAHEADTILECOUNT, ADAPTIVEDRAWAHEADTILECOUNT);
+	m_scheduler.SetLevelOfDetailCount(LEVELOFDETAILCOUNT);
+	if (TILESTOREMB > 0)
+	{
+		m_tileStore.SetBudget((size_t)TILESTOREMB * 1024 * 1024);
+		m_parallelRenderer.SetTileStore(&m_tileStore);
+	}
+	if (DISKTILECACHE && m_diskCache.Open(std::filesystem::temp_directory_path() / L"VirtualSurfacesTiles.cache"))
+	{
+		m_parallelRenderer.SetDiskCache(&m_diskCache, TILECONTENTHASH, 0);
+	}
 }
 
 TileDrawingManager::~TileDrawingManager()
@@ -27,6 +44,7 @@ TileDrawingManager::~TileDrawingManager()
 
 void TileDrawingManager::SetRenderer(DirectXTileRenderer* renderer) {
 	m_currentRenderer = renderer;
+	m_parallelRenderer.SetUploader(renderer);
 };
 
 DirectXTileRenderer* TileDrawingManager::GetRenderer()
@@ -34,161 +52,174 @@ DirectXTileRenderer* TileDrawingManager::GetRenderer()
 	return m_currentRenderer;
 }
 
+int TileDrawingManager::GetTileSize() const
+{
+	return m_scheduler.GetTileSize();
+}
+
+TileSizeCalibration TileDrawingManager::GetTileSizeCalibration() const
+{
+	return m_tileSizeCalibration;
+}
+
 //
-//  FUNCTION: UpdateVisibleRegion
+//  FUNCTION: CalibrateTileSize
 //
-//  PURPOSE: More unloaded surface is now visible on screen because of some event like manipulations(zoom, pan, etc.). This method, figures
-//	out the new areas that need to be rendered and fires the draw calls. This is the core of the tile drawing logic
+//  PURPOSE: Picks the tile size, unless PINNEDTILESIZE does. The renderer draws a few tiles of each power of two size
+//	into the surface and the TileSizeCalibrator works out the fixed and per pixel cost of a tile from how long that took
+//	on this thread, then the size that fills the viewport for the least. Called once the renderer is set, before
+//	anything is drawn.
 //
-void TileDrawingManager::UpdateVisibleRegion(float3 currentPosition)
+void TileDrawingManager::CalibrateTileSize(Size viewportSize)
 {
-	m_currentPosition = currentPosition;
-	bool stateUpdate = false;
-
-	int requiredTopTileRow = max((int)m_currentPosition.y / TILESIZE - DRAWAHEADTILECOUNT, 0);
-	int requiredBottomTileRow = (int)(m_currentPosition.y + m_viewPortSize.Height) / TILESIZE + DRAWAHEADTILECOUNT;
-	int requiredLeftTileColumn = max((int)m_currentPosition.x / TILESIZE - DRAWAHEADTILECOUNT, 0);
-	int requiredRightTileColumn = (int)(m_currentPosition.x + m_viewPortSize.Width) / TILESIZE + DRAWAHEADTILECOUNT;
-
-	m_currentTopLeftTileRow = (int)m_currentPosition.y / TILESIZE;
-	m_currentTopLeftTileColumn = (int)m_currentPosition.x / TILESIZE;
-	
-	//Draws the tiles that are required above the drawn top row.
-	int numberOfRows = (m_drawnTopTileRow - requiredTopTileRow );
-	int numberOfColumns = (m_drawnRightTileColumn-m_drawnLeftTileColumn )+1;
-	if(numberOfRows>0 && numberOfColumns>0)
-	{
-		DrawTileRange(m_drawnLeftTileColumn, requiredTopTileRow, numberOfColumns, numberOfRows);
-		stateUpdate = true;
-	}
-
-	//Draws the tiles that are required below the drawn bottom row.
-	numberOfRows = (requiredBottomTileRow - m_drawnBottomTileRow);
-	numberOfColumns = (m_drawnRightTileColumn - m_drawnLeftTileColumn) + 1;
-	if (numberOfRows > 0 && numberOfColumns > 0)
+	if (PINNEDTILESIZE > 0)
 	{
-		DrawTileRange(m_drawnLeftTileColumn, m_drawnBottomTileRow+1, numberOfColumns, numberOfRows);
-		stateUpdate = true;
+		m_tileSizeCalibration = TileSizeCalibration{};
+		m_tileSizeCalibration.tileSize = PINNEDTILESIZE;
 	}
-
-	//Update the current drawn top tile row and current drawn bottom tile row.
-	m_drawnTopTileRow = min(requiredTopTileRow, m_drawnTopTileRow);
-	m_drawnBottomTileRow = max(requiredBottomTileRow, m_drawnBottomTileRow);
-
-	//Draws the tiles that are required to the left of the drawn columns.
-	numberOfRows = ( m_drawnBottomTileRow - m_drawnTopTileRow)+1;
-	numberOfColumns = (m_drawnLeftTileColumn - requiredLeftTileColumn) ;
-	if (numberOfRows > 0 && numberOfColumns > 0)
-	{
-		DrawTileRange(requiredLeftTileColumn, m_drawnTopTileRow, numberOfColumns, numberOfRows);
-		stateUpdate = true;
-	}
-
-	//Draws the tiles that are required to the right of the drawn columns.
-	numberOfRows = (m_drawnBottomTileRow - m_drawnTopTileRow)+1;
-	numberOfColumns = (requiredRightTileColumn - m_drawnRightTileColumn) ;
-	if (numberOfRows > 0 && numberOfColumns > 0)
+	else
 	{
-		DrawTileRange(m_drawnRightTileColumn + 1, m_drawnTopTileRow, numberOfColumns, numberOfRows);
-		stateUpdate = true;
+		TileSizeCalibrator calibrator;
+		m_tileSizeCalibration = calibrator.Calibrate(*m_currentRenderer, (int)viewportSize.Width, (int)viewportSize.Height, DRAWAHEADTILECOUNT, POWEROFTWOTILESIZE);
 	}
 
-	//Update the current drawn left tile columns and current drawn right tile columns.
-	m_drawnLeftTileColumn = min(requiredLeftTileColumn, m_drawnLeftTileColumn);
-	m_drawnRightTileColumn = max(requiredRightTileColumn, m_drawnRightTileColumn);
+	int tileSize = m_tileSizeCalibration.tileSize;
+	m_currentRenderer->SetTileSize(tileSize);
+	m_rasterizer.EnableLabels(tileSize);
+	m_parallelRenderer.SetTileSize(tileSize);
+	m_scheduler.SetTileSize(tileSize);
+}
 
-	// Trimming the tiles that are not visible on screen
-	if (stateUpdate)
-	{
-		Trim(requiredLeftTileColumn, requiredTopTileRow, requiredRightTileColumn, requiredBottomTileRow);
-	}
+//
+//  FUNCTION: UpdateVisibleRegion
+//
+//  PURPOSE: More unloaded surface is now visible on screen because of some event like manipulations(zoom, pan, etc.). The TileScheduler
+//	figures out the new areas that need to be rendered and calls back into DrawTileRange and Trim.
+//
+void TileDrawingManager::UpdateVisibleRegion(float3 currentPosition)
+{
+	double timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	m_scheduler.UpdateVisibleRegion(currentPosition.x, currentPosition.y, timeMs);
 }
 
 //
-//  FUNCTION: UpdateViewportSize
+//  FUNCTION: UpdateZoom
 //
-//  PURPOSE: Updates the Viewport Size of the application.
+//  PURPOSE: Called while the scale is changing, with the position and viewport size at the new scale. The full resolution
+//	tiles are only updated once the zoom is over, in the meantime the TileScheduler fills the viewport with coarse tiles.
 //
-void TileDrawingManager::UpdateViewportSize(Size newSize)
+void TileDrawingManager::UpdateZoom(float3 currentPosition, Size viewportSize, float scale)
 {
-	m_viewPortSize = newSize;
-	//Using the ceil operator to make sure the Virtual Surfaces is loaded with tiles that occupy the entirity of the viewport
-	//not leaving any empty areas on it.
-	m_horizontalVisibleTileCount = (int)ceil(newSize.Width / TILESIZE);
-	m_verticalVisibleTileCount = (int)ceil(newSize.Height / TILESIZE);
-	DrawVisibleTilesByRange();
+	m_scheduler.UpdateZoom(currentPosition.x, currentPosition.y, viewportSize.Width, viewportSize.Height, scale);
 }
 
 //
-//  FUNCTION: GetRectForTileRange
+//  FUNCTION: SetInertiaTarget
 //
-//  PURPOSE: Gets the rect that needs to be updated for this range of tiles.
+//  PURPOSE: Lets the TileScheduler know where the current inertia will come to rest, so it does not draw ahead past it.
 //
-Rect TileDrawingManager::GetRectForTileRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows)
+void TileDrawingManager::SetInertiaTarget(float3 restingPosition)
 {
-	int x = tileStartColumn * TILESIZE;
-	int y = tileStartRow * TILESIZE;
-	return Rect((float)x, (float)y, (float)(numColumns * TILESIZE), (float)(numRows * TILESIZE));
+	m_scheduler.SetInertiaTarget(restingPosition.x, restingPosition.y);
 }
 
 //
-//  FUNCTION: GetTilesForRange
+//  FUNCTION: ResetDrawAhead
 //
-//  PURPOSE: Converts the tile coordinates into a list of Tile Objects that can be sent to the renderer.
+//  PURPOSE: Called when the content stops moving, or a new manipulation starts, to drop the velocity seen so far.
 //
-list<Tile> TileDrawingManager::GetTilesForRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows)
+void TileDrawingManager::ResetDrawAhead()
 {
-	list<Tile> returnTiles;
-	//get Tile objects for each tile that needs to be rendered.
-	for (int i = tileStartColumn; i < tileStartColumn + numColumns; i++) {
-		for (int j = tileStartRow; j < tileStartRow + numRows; j++) {
-			returnTiles.push_back(Tile(j, i,TILESIZE));
-		}
-	}
-	return returnTiles;
+	m_scheduler.ResetDrawAhead();
 }
 
+//
+//  FUNCTION: FlushTrim
+//
+//  PURPOSE: Called when the content stops moving. A trim the tile cache was waiting on is done now, while nothing else is.
+//
+void TileDrawingManager::FlushTrim()
+{
+	m_scheduler.FlushTrim();
+}
 
-void TileDrawingManager::DrawTileRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows) 
+//
+//  FUNCTION: ProcessPendingTiles
+//
+//  PURPOSE: Draws the tiles queued by the previous updates, visible ones first, for at most FRAMEBUDGET milliseconds.
+//	Called once per frame. Returns true while there is work left.
+//
+bool TileDrawingManager::ProcessPendingTiles()
 {
-	m_currentRenderer->DrawTileRange(GetRectForTileRange(tileStartColumn, tileStartRow, numColumns, numRows), GetTilesForRange(tileStartColumn, tileStartRow, numColumns, numRows));
+	return m_scheduler.ProcessPendingTiles();
 }
 
+bool TileDrawingManager::HasPendingTiles() const
+{
+	return m_scheduler.HasPendingTiles();
+}
 
 //
-//  FUNCTION: DrawVisibleTilesByRange
+//  FUNCTION: UpdateViewportSize
 //
-//  PURPOSE: This function combines all the tiles into a single call, so the rendering is faster as opposed to calling BeginDraw on each tile.
+//  PURPOSE: Updates the Viewport Size of the application.
 //
-void TileDrawingManager::DrawVisibleTilesByRange()
+void TileDrawingManager::UpdateViewportSize(Size newSize)
 {
-	//The DRAWAHEADTILECOUNT draws tiles that the configured number of tiles outside the viewport to make sure the user doesnt see a lot 
-	//of empty areas when scrolling.
-	DrawTileRange(0, 0, m_horizontalVisibleTileCount + DRAWAHEADTILECOUNT, m_verticalVisibleTileCount + DRAWAHEADTILECOUNT);
+	m_scheduler.UpdateViewportSize(newSize.Width, newSize.Height);
+}
 
-	//update the tiles that are already drawn, so only the new tiles will have to be rendered when panning.
-	m_drawnRightTileColumn = m_horizontalVisibleTileCount - 1 + DRAWAHEADTILECOUNT;
-	m_drawnBottomTileRow = m_verticalVisibleTileCount - 1 + DRAWAHEADTILECOUNT;
+//
+//  FUNCTION: DrawTileRange
+//
+//  PURPOSE: Called by the TileScheduler with a block of tiles that needs to be rendered. The range itself is handed to the
+//	renderer, which enumerates its tiles lazily instead of receiving a list built node by node.
+//
+bool TileDrawingManager::DrawTileRange(TileRange const& range)
+{
+	if (CPURASTERTHREADCOUNT > 0)
+	{
+		return m_parallelRenderer.DrawTileRange(range, 0);
+	}
+	return m_currentRenderer->DrawTileRange(range, 0);
+}
 
+//
+//  FUNCTION: DrawLevelOfDetailRange
+//
+//  PURPOSE: Called by the TileScheduler with a block of coarse tiles while zooming. The surface of each level is scaled up
+//	by its brush, so the tiles use the same rect as full resolution tiles, just on the level's own surface.
+//
+bool TileDrawingManager::DrawLevelOfDetailRange(TileRange const& range, int level)
+{
+	if (CPURASTERTHREADCOUNT > 0)
+	{
+		return m_parallelRenderer.DrawTileRange(range, level);
+	}
+	return m_currentRenderer->DrawTileRange(range, level);
 }
 
 //
 //  FUNCTION: Trim()
 //
-//  PURPOSE: Trims the tiles that are outside these co-ordinates. So only the contents that are visible are rendered, to save on memory.
+//  PURPOSE: Called by the TileScheduler once its tile cache is over budget, with the tiles that are still cached. Everything
+//	else is trimmed from the surface in a single call, to save on memory.
 //
-void TileDrawingManager::Trim(int leftColumn, int topRow, int rightColumn, int bottomRow)
+void TileDrawingManager::Trim(std::vector<TileRange> const& keepRanges)
 {
-	auto trimRect = GetRectForTileRange(
-		leftColumn,
-		topRow,
-		rightColumn - leftColumn + 1,
-		bottomRow - topRow + 1);
-
-	m_currentRenderer->Trim(trimRect);
+	int tileSize = m_scheduler.GetTileSize();
+	m_trimRects.clear();
+	for (TileRange const& range : keepRanges)
+	{
+		m_trimRects.push_back(RectInt32{ range.startColumn * tileSize, range.startRow * tileSize, range.numColumns * tileSize, range.numRows * tileSize });
+	}
+	m_currentRenderer->Trim(m_trimRects, 0);
+}
 
-	m_drawnLeftTileColumn = leftColumn;
-	m_drawnRightTileColumn = rightColumn;
-	m_drawnTopTileRow = topRow;
-	m_drawnBottomTileRow = bottomRow;
+void TileDrawingManager::TrimLevelOfDetail(TileRange const& keepRange, int level)
+{
+	int tileSize = m_scheduler.GetTileSize();
+	m_trimRects.clear();
+	m_trimRects.push_back(RectInt32{ keepRange.startColumn * tileSize, keepRange.startRow * tileSize, keepRange.numColumns * tileSize, keepRange.numRows * tileSize });
+	m_currentRenderer->Trim(m_trimRects, level);
 }
@@ -15,51 +15,73 @@
 #pragma once
 
 #include "DirectXTileRenderer.h"
+#include "ParallelTileRenderer.h"
+#include "PatternTileRasterizer.h"
+#include "TileScheduler.h"
+#include "TileSizeCalibrator.h"
 
 using namespace std;
 using namespace winrt;
 using namespace Windows::Foundation::Numerics;
 using namespace Windows::Foundation;
 
-class TileDrawingManager
+//The tile logic itself lives in the platform neutral TileScheduler. The TileDrawingManager adapts it to winrt types and
+//turns the tile ranges it schedules into DirectXTileRenderer calls. With CPURASTERTHREADCOUNT above 0 the tiles are
+//rasterized on the CPU by worker threads instead, and the DirectXTileRenderer only uploads them. Otherwise TILEBACKEND
+//picks whether the DirectXTileRenderer draws them with Direct2D or with its deterministic software backend.
+class TileDrawingManager : public ITileRenderer
 {
 public:
 	TileDrawingManager();
 	~TileDrawingManager();
 	void UpdateVisibleRegion(float3 currentPosition);
 	void UpdateViewportSize(Size newSize);
+	void UpdateZoom(float3 currentPosition, Size viewportSize, float scale);
+	void SetInertiaTarget(float3 restingPosition);
+	void ResetDrawAhead();
+	void FlushTrim();
+	bool ProcessPendingTiles();
+	bool HasPendingTiles() const;
 	void SetRenderer(DirectXTileRenderer* renderer);
 	DirectXTileRenderer* GetRenderer();
+	void CalibrateTileSize(Size viewportSize);
+	int GetTileSize() const;
+	TileSizeCalibration GetTileSizeCalibration() const;
 
-	const static int TILESIZE = 250;
-	const static int MAXSURFACESIZE = TILESIZE * 10000;
+	//ITileRenderer implementation, called back by the TileScheduler.
+	bool DrawTileRange(TileRange const& range) override;
+	void Trim(std::vector<TileRange> const& keepRanges) override;
+	bool DrawLevelOfDetailRange(TileRange const& range, int level) override;
+	void TrimLevelOfDetail(TileRange const& keepRange, int level) override;
+
+	const static int PINNEDTILESIZE = 0; //Tile size in pixels, 0 picks one at startup with a TileSizeCalibrator. Set it to the size calibrated on a class of machines to skip the calibration
+	const static bool POWEROFTWOTILESIZE = false; //Only lets the calibration pick power of two tile sizes
+	const static int MAXSURFACESIZE = 1 << 24; //Largest size of a virtual surface, the tile state is sparse so it does not cost anything up front
 	const static int DRAWAHEADTILECOUNT = 1; //Number of tiles to draw ahead 
+	const static int MAXDRAWAHEADTILECOUNT = 4; //Number of tiles to draw ahead on the leading edge of a fast pan
+	const static int MINDRAWAHEADTILECOUNT = 0; //Least the draw ahead at rest shrinks to when tiles take too long to draw for the frame budget
+	const static int ADAPTIVEDRAWAHEADTILECOUNT = 3; //Most the draw ahead at rest grows to when tiles are cheap to draw, 0 keeps it at DRAWAHEADTILECOUNT
+	const static int LEVELOFDETAILCOUNT = 2; //Number of coarser levels drawn while zooming out, each half the resolution of the previous one
+	const static int FRAMEBUDGET = 8; //Milliseconds per frame spent drawing tiles, 0 draws them all synchronously
+	const static int CACHEBUDGETMB = 64; //Megabytes of tiles kept on the surface after they leave the draw ahead band
+	const static int TRIMMARGINTILECOUNT = 2; //Number of tiles around the draw ahead band that are never trimmed
+	const static int TRIMDEFERRAL = 8; //Updates a trim may wait for a frame with time to spare once the tile cache is over budget, 0 trims within the update
+	const static TileOrder TILEORDER = TileOrder::CenterOut; //Order the blocks of a range are drawn in, CenterOut fills the middle of the viewport first
+	const static int CPURASTERTHREADCOUNT = 0; //Threads rasterizing tiles on the CPU, 0 draws them on the UI thread with TILEBACKEND
+	const static TileBackend TILEBACKEND = TileBackend::Direct2D; //Software draws the tiles on the UI thread without Direct2D, the same bits on every machine
+	const static int TILESTOREMB = 32; //Megabytes of compressed tiles the CPU path keeps to restore trimmed tiles without rasterizing them, 0 for none
+	const static bool DISKTILECACHE = false; //Keeps the tiles the CPU path rasterizes in a file in the temp folder, so the next run reads them instead
+	const static uint64_t TILECONTENTHASH = 0x5041545445524E31ull; //Identifies the sample's tiles in that file, change it whenever the way they are drawn does
 
 private:
-	
-	list<Tile> GetTilesForRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows);
-	void DrawVisibleTilesByRange();
-	Rect GetRectForTileRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows);
-	void Trim(int leftColumn, int topRow, int rightColumn, int bottomRow);
-	void DrawTileRange(int tileStartColumn, int tileStartRow, int numColumns, int numRows);
 
 	//member variables
-	
-	//These variables reflect the current state of the surface and which tiles are screen.
-	//Helps us figure out the new set of tiles that need to be rendered when there's change because of manipulation
-	//or viewport size changes.
-	int                     m_drawnTopTileRow = 0;//Keeps track of the top tile row that is currently drawn
-	int                     m_drawnBottomTileRow = 0;//Keeps track of the bottom tile row that is currently drawn
-	int                     m_drawnLeftTileColumn = 0;//Keeps track of the left tile colum that is currently drawn
-	int                     m_drawnRightTileColumn = 0;//Keeps track of the right rile column that is currently drawn
-
-	int                     m_horizontalVisibleTileCount=0;//Number of horizonal tiles visible.
-	int                     m_verticalVisibleTileCount=0;//Number of vertical tiles visible.
-
-	Size                    m_viewPortSize;//Size of the viewport.
-	float3                  m_currentPosition;//Current position
-	int                     m_currentTopLeftTileRow = 0;//Row number of the top left tile that is currently visible
-	int                     m_currentTopLeftTileColumn = 0;//Column number of the top left tile that is currently visible.
-
+	TileScheduler           m_scheduler{ TileSizeCalibrator::DEFAULTTILESIZE, DRAWAHEADTILECOUNT, MAXDRAWAHEADTILECOUNT };
+	TileSizeCalibration     m_tileSizeCalibration;
 	DirectXTileRenderer*    m_currentRenderer;
+	PatternTileRasterizer   m_rasterizer;
+	CompressedTileStore     m_tileStore;
+	TileDiskCache           m_diskCache;
+	ParallelTileRenderer    m_parallelRenderer{ m_rasterizer, TileSizeCalibrator::DEFAULTTILESIZE, CPURASTERTHREADCOUNT };
+	std::vector<RectInt32>  m_trimRects;//Scratch space for Trim
 };
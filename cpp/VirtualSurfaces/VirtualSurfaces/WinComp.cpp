@@ -50,12 +50,26 @@ void WinComp::Initialize(HWND hwnd)
 	namespace abi = ABI::Windows::UI::Composition;
 
 	m_window = hwnd;
+	if (RECORDTRACE)
+	{
+		m_traceRecorder.Start();
+	}
 	Compositor compositor;
 	m_compositor = compositor;
 	DirectXTileRenderer* dxRenderer = new DirectXTileRenderer();
-	dxRenderer->Initialize(m_compositor, TileDrawingManager::TILESIZE, TileDrawingManager::MAXSURFACESIZE);
+	dxRenderer->Initialize(m_compositor, m_TileDrawingManager.GetTileSize(), TileDrawingManager::MAXSURFACESIZE, TileDrawingManager::LEVELOFDETAILCOUNT, TileDrawingManager::TILEBACKEND);
+	//Tiles are drawn a frame budget at a time from this timer, instead of all at once inside the tracker callbacks.
+	m_tileTimer = DispatcherQueue::GetForCurrentThread().CreateTimer();
+	m_tileTimer.Interval(std::chrono::milliseconds(16));
+	m_tileTimer.Tick([this](DispatcherQueueTimer const& timer, IInspectable const&)
+	{
+		if (!m_TileDrawingManager.ProcessPendingTiles())
+		{
+			timer.Stop();
+		}
+	});
 	m_TileDrawingManager.SetRenderer(dxRenderer);
-
+	m_TileDrawingManager.CalibrateTileSize(GetWindowSize());
 }
 
 void WinComp::TryRedirectForManipulation(PointerPoint pp)
@@ -95,11 +109,23 @@ void WinComp::PrepareVisuals()
 //
 //  FUNCTION: AddD2DVisual
 //
-//  PURPOSE: Creates a SurfaceBrush to host Direct2D content in this visual.
+//  PURPOSE: Creates a SurfaceBrush to host Direct2D content in this visual. The coarser levels of detail each get a visual
+//	underneath it, coarsest at the bottom, so they only show where the finer levels have not been drawn.
 //
 void WinComp::AddD2DVisual(VisualCollection const& visuals, float x, float y)
 {
 	auto compositor = visuals.Compositor();
+	auto renderer = m_TileDrawingManager.GetRenderer();
+	for (int level = renderer->getLevelOfDetailCount(); level > 0; level--)
+	{
+		SpriteVisual levelVisual = compositor.CreateSpriteVisual();
+		levelVisual.Brush(renderer->getLevelOfDetailBrush(level));
+		levelVisual.Size(GetWindowSize());
+		levelVisual.Offset({ x, y, 0.0f, });
+		visuals.InsertAtTop(levelVisual);
+		m_levelOfDetailVisuals.push_back(levelVisual);
+	}
+
 	m_contentVisual = compositor.CreateSpriteVisual();
 	m_contentVisual.Brush(m_TileDrawingManager.GetRenderer()->getSurfaceBrush());
 
@@ -125,10 +151,16 @@ void WinComp::UpdateViewPort(boolean changeContentVisual)
 		windowSize.Width = (windowRect.right-windowRect.left)/m_lastTrackerScale;
 		
 		if(changeContentVisual){
+			m_traceRecorder.Record(InteractionEvent::Kind::Size, (float)(windowRect.right - windowRect.left), (float)(windowRect.bottom - windowRect.top), 1.0f);
 			m_contentVisual.Size(windowSize);
+			for (auto& levelVisual : m_levelOfDetailVisuals)
+			{
+				levelVisual.Size(windowSize);
+			}
 		}
 		m_TileDrawingManager.UpdateViewportSize(windowSize);
 		m_TileDrawingManager.UpdateVisibleRegion(m_lastTrackerPosition/m_lastTrackerScale);
+		ScheduleTileWork();
 	}
 }
 
@@ -165,6 +197,17 @@ void WinComp::StartAnimation(CompositionSurfaceBrush brush)
 	m_animateMatrix.SetReferenceParameter(L"props", m_animatingPropset);
 
 	brush.StartAnimation(L"TransformMatrix", m_animateMatrix);
+
+	//The coarse levels follow the same manipulation, scaled up by 2^level to cover the same area as the full resolution surface.
+	auto renderer = m_TileDrawingManager.GetRenderer();
+	for (int level = 1; level <= renderer->getLevelOfDetailCount(); level++)
+	{
+		std::wstring levelScale = std::to_wstring(1 << level);
+		auto levelMatrix = m_compositor.CreateExpressionAnimation(
+			L"Matrix3x2(props.scale * " + levelScale + L", 0.0, 0.0, props.scale * " + levelScale + L", props.xcoord, props.ycoord)");
+		levelMatrix.SetReferenceParameter(L"props", m_animatingPropset);
+		renderer->getLevelOfDetailBrush(level).StartAnimation(L"TransformMatrix", levelMatrix);
+	}
 }
 
 //
@@ -209,21 +252,38 @@ void WinComp::CustomAnimationStateEntered(InteractionTracker sender, Interaction
 
 void WinComp::IdleStateEntered(InteractionTracker sender, InteractionTrackerIdleStateEnteredArgs args)
 {
+	m_traceRecorder.Record(InteractionEvent::Kind::Idle, 0.0f, 0.0f, m_lastTrackerScale);
+	//the content has stopped moving, go back to drawing the same number of tiles ahead on every side.
+	m_TileDrawingManager.ResetDrawAhead();
 	if (m_zooming)
 	{
 		//dont update the content visual, because the window size hasnt changed.
 		UpdateViewPort( false);
 	}
 	m_zooming = false;
+	//a trim that was put off while the content was moving costs nothing now.
+	m_TileDrawingManager.FlushTrim();
+
+	//the trace is complete up to here, so closing the app at rest never loses any of it.
+	if (m_traceRecorder.IsRecording() && !m_traceRecorder.Save(TRACEFILE))
+	{
+		OutputDebugString(L"Could not write the interaction trace\n");
+	}
 }
 
 void WinComp::InertiaStateEntered(InteractionTracker sender, InteractionTrackerInertiaStateEnteredArgs args)
 {
+	//the tracker already knows where the inertia will end, so the tiles drawn ahead never go past that point.
+	float3 restingPosition = args.ModifiedRestingPosition() != nullptr ? args.ModifiedRestingPosition().Value() : args.NaturalRestingPosition();
+	m_traceRecorder.Record(InteractionEvent::Kind::Inertia, restingPosition.x, restingPosition.y, m_lastTrackerScale);
+	m_TileDrawingManager.SetInertiaTarget(restingPosition / m_lastTrackerScale);
 }
 
 void WinComp::InteractingStateEntered(InteractionTracker sender, InteractionTrackerInteractingStateEnteredArgs args)
 {
-
+	m_traceRecorder.Record(InteractionEvent::Kind::Interacting, 0.0f, 0.0f, m_lastTrackerScale);
+	//a new manipulation does not continue the previous motion.
+	m_TileDrawingManager.ResetDrawAhead();
 }
 
 void WinComp::RequestIgnored(InteractionTracker sender, InteractionTrackerRequestIgnoredArgs args)
@@ -232,16 +292,36 @@ void WinComp::RequestIgnored(InteractionTracker sender, InteractionTrackerReques
 
 void WinComp::ValuesChanged(InteractionTracker sender, InteractionTrackerValuesChangedArgs args)
 {
+	m_traceRecorder.Record(InteractionEvent::Kind::Values, sender.Position().x, sender.Position().y, args.Scale());
 	if (m_lastTrackerScale == args.Scale())
 	{
 		m_TileDrawingManager.UpdateVisibleRegion(sender.Position()/m_lastTrackerScale);
 	}
 	else
 	{
-		// Don't run tilemanager during a zoom
+		// Don't run tilemanager during a zoom, coarse tiles fill the viewport until it is over.
 		m_zooming = true;
+		Size windowSize = GetWindowSize();
+		windowSize.Width /= args.Scale();
+		windowSize.Height /= args.Scale();
+		m_TileDrawingManager.UpdateZoom(sender.Position() / args.Scale(), windowSize, args.Scale());
 	}
 
 	m_lastTrackerScale = args.Scale();
 	m_lastTrackerPosition = sender.Position();
+	ScheduleTileWork();
+}
+
+//
+//  FUNCTION: ScheduleTileWork
+//
+//  PURPOSE: Starts the tile timer when the last update queued tiles. The timer stops itself once the queue is empty, so
+//	nothing runs while the content is at rest.
+//
+void WinComp::ScheduleTileWork()
+{
+	if (m_TileDrawingManager.HasPendingTiles() && !m_tileTimer.IsRunning())
+	{
+		m_tileTimer.Start();
+	}
 }
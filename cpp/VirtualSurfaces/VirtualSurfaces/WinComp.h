@@ -17,6 +17,7 @@
 
 #include "stdafx.h"
 #include "TileDrawingManager.h"
+#include "InteractionTrace.h"
 #include <winrt/Windows.UI.Composition.Interactions.h>
 
 using namespace winrt;
@@ -54,9 +55,13 @@ public:
 	void CustomAnimationStateEntered(InteractionTracker sender, InteractionTrackerCustomAnimationStateEnteredArgs args);
 	void IdleStateEntered(InteractionTracker sender, InteractionTrackerIdleStateEnteredArgs args);
 
+	const static bool RECORDTRACE = false; //Records the InteractionTracker callbacks to TRACEFILE, for TileSchedulerBenchmark --trace to replay
+	static constexpr char const* TRACEFILE = "VirtualSurfaces.itrace"; //Rewritten every time the tracker goes idle, in the working directory
+
 private:
 
 	void AddD2DVisual(VisualCollection const& visuals, float x, float y);
+	void ScheduleTileWork();
 	void StartAnimation(CompositionSurfaceBrush brush);
 	Size GetWindowSize();
 
@@ -65,6 +70,7 @@ private:
 	VisualInteractionSource     m_interactionSource{ nullptr };
 	SpriteVisual                m_viewportVisual{ nullptr };
 	SpriteVisual                m_contentVisual{ nullptr };
+	std::vector<SpriteVisual>   m_levelOfDetailVisuals;//Coarser levels of detail, under the content visual
 	InteractionTracker          m_tracker{ nullptr };
 	DesktopWindowTarget         m_target{ nullptr };
 	HWND                        m_window = nullptr;
@@ -77,9 +83,11 @@ private:
 	CompositionPropertySet      m_animatingPropset{ nullptr };
 
 	TileDrawingManager          m_TileDrawingManager;
+	DispatcherQueueTimer        m_tileTimer{ nullptr };//Draws the queued tiles, one frame budget per tick
 	float                       m_lastTrackerScale = 1.0f;
 	float3                      m_lastTrackerPosition{ 0.0f,0.0f,0.0f };
 	bool                        m_zooming;
+	InteractionTraceRecorder    m_traceRecorder;
 
 };
 